@@ -14,6 +14,7 @@
 #include "loganalysis.h"
 #include "experiments/restore_cmd.h"
 #include "dbscan.h"
+#include "tracecat.h"
 
 #include <boost/foreach.hpp>
 
@@ -53,6 +54,7 @@ void Command::init()
     REGISTER_COMMAND("kits", KitsCommand);
     REGISTER_COMMAND("restore", RestoreCmd);
     REGISTER_COMMAND("propstats", PropStats);
+    REGISTER_COMMAND("tracecat", TraceCat);
 }
 
 void Command::setupCommonOptions()
@@ -168,6 +170,8 @@ void Command::setupSMOptions(po::options_description& options)
             "Path to the error log of the storage manager")
     ("sm_chkpt_interval", po::value<int>(),
             "Interval for checkpoint flushes")
+    ("sm_chkpt_use_log_scan", po::value<bool>(),
+            "Collect checkpoints with a backward log scan instead of from the buffer pool")
     ("sm_log_fetch_buf_partitions", po::value<uint>()->default_value(0),
         "Number of partitions to buffer in memory for recovery")
     ("sm_log_page_flushers", po::value<uint>()->default_value(1),
@@ -193,16 +197,32 @@ void Command::setupSMOptions(po::options_description& options)
          will be ignored (uses write elision and single-page recovery)")
     ("sm_vol_o_direct", po::value<bool>(),
         "Whether to open volume (i.e., db file) with O_DIRECT")
+    ("sm_vol_compress", po::value<bool>(),
+        "Compress pages written to the volume and punch holes in the file")
+    ("sm_snapshot_reads", po::value<bool>(),
+        "Keep record versions so that snapshot transactions can read without locks")
+    ("sm_page_size", po::value<int>(),
+        "Page size of the volume; must match SM_PAGESIZE of the build")
+    ("sm_alloc_slab_size", po::value<int>(),
+        "Number of page IDs reserved at once by each thread for allocation")
     ("sm_restart_instant", po::value<bool>(),
         "Enable instant restart")
     ("sm_restart_log_based_redo", po::value<bool>(),
         "Perform non-instant restart with log-based redo instead of page-based")
+    ("sm_restart_log_analysis_threads", po::value<int>(),
+        "Number of threads scanning log partitions in parallel during log analysis")
     ("sm_restore_segsize", po::value<int>(),
         "Segment size restore")
     ("sm_restore_prefetcher_window", po::value<int>(),
         "Segment size restore")
     ("sm_backup_prefetcher_segments", po::value<int>(),
         "Segment size restore")
+    ("sm_backup_prefetcher_ios", po::value<int>(),
+        "Number of concurrent segment reads issued by the backup prefetcher")
+    ("sm_restore_write_batch", po::value<int>(),
+        "Maximum number of adjacent restored segments written with one I/O")
+    ("sm_restore_write_buffers", po::value<int>(),
+        "Number of write batch buffers used by the restore segment writer")
     ("sm_rawlock_gc_interval_ms", po::value<int>(),
         "Garbage Collection Interval in ms")
     ("sm_rawlock_lockpool_segsize", po::value<int>(),
@@ -243,12 +263,30 @@ void Command::setupSMOptions(po::options_description& options)
         "Do not write metadata pages (stnode and alloc caches) in cleaner")
     ("sm_cleaner_async_candidate_collection", po::value<bool>(),
         "Collect candidate frames to be cleaned in an asynchronous thread")
+    ("sm_ghost_reclaim", po::value<bool>(),
+        "Reclaim ghosts and defragment leaves found by the cleaner in the background")
+    ("sm_ghost_reclaim_threshold", po::value<int>(),
+        "Percentage of a leaf held by ghosts and holes to trigger its defragmentation")
+    ("sm_ghost_reclaim_interval_millisec", po::value<int>(),
+        "Ghost reclaimer sleep interval in ms")
+    ("sm_btree_maintenance", po::value<bool>(),
+        "Adopt foster children and merge underfull leaves in the background")
+    ("sm_btree_maintenance_interval_millisec", po::value<int>(),
+        "B-tree maintenance sleep interval in ms")
+    ("sm_btree_maintenance_max_ops", po::value<int>(),
+        "Maximum number of adopts, defrags and merges per B-tree maintenance round")
+    ("sm_btree_merge_threshold", po::value<int>(),
+        "Percentage of a leaf in use below which B-tree maintenance merges it")
     ("sm_archiver_workspace_size", po::value<int>(),
         "Workspace size archiver")
+    ("sm_archiver_workers", po::value<int>(),
+        "Number of sort workers used by log archiver for run generation")
     ("sm_archiver_block_size", po::value<int>()->default_value(1024*1024),
         "Archiver Block size")
     ("sm_archiver_bucket_size", po::value<int>()->default_value(128),
         "Archiver bucket size")
+    ("sm_archiver_prealloc_size", po::value<int>(),
+        "Space in MB preallocated for each archive run file")
     ("sm_merge_factor", po::value<int>(),
         "Merging factor")
     ("sm_archiving_blocksize", po::value<int>(),
@@ -271,6 +309,16 @@ void Command::setupSMOptions(po::options_description& options)
         "Enable/Disable ticker (currently always enabled)")
     ("sm_ticker_msec", po::value<int>(),
         "Ticker interval in millisec")
+    ("sm_ticker_latency_file", po::value<string>(),
+        "File to which the ticker exports latency histograms every second")
+    ("sm_latency_stats", po::value<bool>(),
+        "Enable/Disable latency histograms for fix, lock, log flush and commit")
+    ("sm_trace_file", po::value<string>(),
+        "File to which page I/O and eviction events are traced")
+    ("sm_trace_ring_size", po::value<int>(),
+        "Capacity in events of each per-thread trace buffer")
+    ("sm_trace_flush_interval", po::value<int>(),
+        "Interval in msec at which trace buffers are written to the trace file")
     ("sm_prefetch", po::value<bool>(),
         "Enable/Disable prefetching")
     ("sm_restore_instant", po::value<bool>(),
@@ -287,6 +335,8 @@ void Command::setupSMOptions(po::options_description& options)
         "Use preemptive scheduling during restore")
     ("sm_bufferpool_swizzle", po::value<bool>(),
         "Enable/Disable bufferpool swizzle")
+    ("sm_bufferpool_optimistic_reads", po::value<bool>(),
+        "Enable/Disable latch-free reads of interior B-tree pages")
     ("sm_archiver_eager", po::value<bool>(),
         "Enable/Disable eager archiving")
     ("sm_archiver_read_whole_blocks", po::value<bool>(),
@@ -0,0 +1,61 @@
+#include "tracecat.h"
+
+#include "eventtrace.h"
+
+void TraceCat::setupOptions()
+{
+    po::options_description opt("TraceCat Options");
+    opt.add_options()
+        ("file,f", po::value<string>(&file)->required(),
+         "Trace file to be converted")
+        ("format", po::value<string>(&format)->default_value("csv"),
+         "Output format: csv or chrome")
+        ;
+    options.add(opt);
+}
+
+void TraceCat::run()
+{
+    bool chrome = (format == "chrome");
+    if (!chrome && format != "csv") {
+        throw runtime_error("Invalid trace format: " + format);
+    }
+
+    trace_reader_t reader(file);
+    uint64_t start_usec = reader.header().start_usec;
+    trace_event_t e;
+
+    if (chrome) {
+        // Instant events, one track per traced thread; timestamps in usec
+        cout << "{\"traceEvents\":[" << endl;
+        bool first = true;
+        while (reader.next(e)) {
+            if (!first) { cout << "," << endl; }
+            first = false;
+            cout << "{\"name\":\"" << trace_event_t::type_name(e.type)
+                << "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0"
+                << ",\"tid\":" << e.thread
+                << ",\"ts\":" << e.ts / 1000 << "." << setfill('0')
+                << setw(3) << e.ts % 1000 << setfill(' ')
+                << ",\"args\":{\"pid\":" << e.pid
+                << ",\"count\":" << e.count
+                << ",\"lsn\":\"" << lsn_t(e.lsn) << "\"}}";
+        }
+        cout << endl << "],\"displayTimeUnit\":\"ns\""
+            << ",\"otherData\":{\"start_usec\":" << start_usec << "}}"
+            << endl;
+    }
+    else {
+        cout << "# start_usec=" << start_usec << endl;
+        cout << "ts_ns,thread,event,pid,count,lsn" << endl;
+        while (reader.next(e)) {
+            cout << e.ts
+                << "," << e.thread
+                << "," << trace_event_t::type_name(e.type)
+                << "," << e.pid
+                << "," << e.count
+                << "," << lsn_t(e.lsn)
+                << endl;
+        }
+    }
+}
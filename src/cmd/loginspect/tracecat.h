@@ -0,0 +1,21 @@
+#ifndef TRACECAT_H
+#define TRACECAT_H
+
+#include "command.h"
+
+/*
+ * Converts a binary trace file written by event_tracer (option
+ * sm_trace_file) into CSV or into the JSON format of the Chrome trace
+ * viewer (chrome://tracing).
+ */
+class TraceCat : public Command {
+public:
+    void run();
+    void setupOptions();
+
+private:
+    string file;
+    string format;
+};
+
+#endif
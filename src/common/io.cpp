@@ -894,6 +894,8 @@ w_rc_t sthread_t::close(int fd)
  *  sthread_t::readv(fd, iov, iovcnt)
  *  sthread_t::fsync(fd)
  *  sthread_t::ftruncate(fd, len)
+ *  sthread_t::fallocate(fd, off, len)
+ *  sthread_t::punch_hole(fd, off, len)
  *
  *  Perform I/O.
  *
@@ -1059,6 +1061,30 @@ w_rc_t    sthread_t::ftruncate(int fd, fileoff_t n)
     return e;
 }
 
+w_rc_t    sthread_t::fallocate(int fd, fileoff_t off, fileoff_t n)
+{
+    fd -= fd_base;
+    if (fd < 0 || fd >= (int)open_max || !_disks[fd])
+        return RC(stBADFD);
+
+    w_rc_t        e;
+    e =  _disks[fd]->preallocate(off, n);
+
+    return e;
+}
+
+w_rc_t    sthread_t::punch_hole(int fd, fileoff_t off, fileoff_t n)
+{
+    fd -= fd_base;
+    if (fd < 0 || fd >= (int)open_max || !_disks[fd])
+        return RC(stBADFD);
+
+    w_rc_t        e;
+    e =  _disks[fd]->punch_hole(off, n);
+
+    return e;
+}
+
 w_rc_t sthread_t::frename(int fd, const char* oldname, const char* newname)
 {
     fd -= fd_base;
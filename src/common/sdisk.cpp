@@ -190,6 +190,18 @@ w_rc_t    sdisk_t::sync()
 }
 
 
+w_rc_t    sdisk_t::preallocate(fileoff_t, fileoff_t)
+{
+    return RC(fcNOTIMPLEMENTED);
+}
+
+
+w_rc_t    sdisk_t::punch_hole(fileoff_t, fileoff_t)
+{
+    return RC(fcNOTIMPLEMENTED);
+}
+
+
 w_rc_t    sdisk_t::stat(filestat_t &)
 {
     return RC(fcNOTIMPLEMENTED);
@@ -168,6 +168,8 @@ public:
     virtual w_rc_t    rename(const char* oldname, const char* newname) = 0;
 
     virtual w_rc_t    truncate(fileoff_t size) = 0;
+    virtual w_rc_t    preallocate(fileoff_t offset, fileoff_t size);
+    virtual w_rc_t    punch_hole(fileoff_t offset, fileoff_t size);
     virtual w_rc_t    sync();
 
     virtual    w_rc_t    stat(filestat_t &stat);
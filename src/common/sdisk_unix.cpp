@@ -346,6 +346,55 @@ w_rc_t    sdisk_unix_t::truncate(fileoff_t size)
     return RCOK;
 }
 
+/*
+ * Reserves disk blocks without changing the file size, so that appends
+ * within the range do not need block allocation. Returns fcNOTIMPLEMENTED
+ * if the file system does not support it.
+ */
+w_rc_t    sdisk_unix_t::preallocate(fileoff_t offset, fileoff_t size)
+{
+    if (_fd == FD_NONE)
+        return RC(stBADFD);
+
+#ifdef FALLOC_FL_KEEP_SIZE
+    int n = ::fallocate(_fd, FALLOC_FL_KEEP_SIZE, offset, size);
+    if (n == -1 && (errno == EOPNOTSUPP || errno == ENOSYS))
+        return RC(fcNOTIMPLEMENTED);
+    CHECK_ERRNO(n);
+
+    return RCOK;
+#else
+    (void) offset;
+    (void) size;
+    return RC(fcNOTIMPLEMENTED);
+#endif
+}
+
+/*
+ * Deallocates the disk blocks of the given range without changing the file
+ * size; the range reads back as zeros. Returns fcNOTIMPLEMENTED if the file
+ * system does not support it.
+ */
+w_rc_t    sdisk_unix_t::punch_hole(fileoff_t offset, fileoff_t size)
+{
+    if (_fd == FD_NONE)
+        return RC(stBADFD);
+
+#ifdef FALLOC_FL_PUNCH_HOLE
+    int n = ::fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            offset, size);
+    if (n == -1 && (errno == EOPNOTSUPP || errno == ENOSYS))
+        return RC(fcNOTIMPLEMENTED);
+    CHECK_ERRNO(n);
+
+    return RCOK;
+#else
+    (void) offset;
+    (void) size;
+    return RC(fcNOTIMPLEMENTED);
+#endif
+}
+
 w_rc_t    sdisk_unix_t::sync()
 {
     if (_fd == FD_NONE)
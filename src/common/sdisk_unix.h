@@ -85,6 +85,10 @@ public:
 
     w_rc_t    truncate(fileoff_t size);
 
+    w_rc_t    preallocate(fileoff_t offset, fileoff_t size);
+
+    w_rc_t    punch_hole(fileoff_t offset, fileoff_t size);
+
     w_rc_t    sync();
 
     w_rc_t    stat(filestat_t &st);
@@ -736,6 +736,8 @@ public:
                             int                whence);
     static w_rc_t        fsync(int fd);
     static w_rc_t        ftruncate(int fd, fileoff_t sz);
+    static w_rc_t        fallocate(int fd, fileoff_t off, fileoff_t sz);
+    static w_rc_t        punch_hole(int fd, fileoff_t off, fileoff_t sz);
     static w_rc_t        frename(int fd, const char* o, const char* n);
     static w_rc_t        fstat(int fd, filestat_t &sb);
     static w_rc_t        fisraw(int fd, bool &raw);
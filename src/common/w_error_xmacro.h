@@ -105,6 +105,11 @@ X(eBFFULL,                    "Buffer pool is full during Recovery operation")
 X(eACCESS_CONFLICT,           "User transaction is conflicting with Recovery task on a page access")
 X(eBAD_BACKUPPAGE,            "Retrieved page from backup file was incorrect")
 X(eVOLFAILED,                 "Volume is failed")
+X(eBADOVERFLOWPAGE,          "Page in chain of large value is not an overflow page")
+X(eNOTOVERFLOW,               "Record does not refer to a large value")
+X(eBADPAGESIZE,               "Page size does not match the one the storage manager was built with")
+X(eNOSNAPSHOTS,               "Snapshot reads are not enabled (sm_snapshot_reads)")
+X(eSNAPSHOTUPDATE,            "Snapshot transactions cannot update")
 
 /*
  * CS: The old Shore-MT RC used a simple integer as error code, which allowed
@@ -0,0 +1,275 @@
+#ifndef W_LOSERTREE_H
+#define W_LOSERTREE_H
+
+#include "w_defines.h"
+
+#include "w_base.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+/**\brief Sort key packed into two integers for LoserTree.
+ *
+ * Keys are compared lexicographically as (hi, lo). Callers pack their
+ * sort key into these integers, e.g., the log archiver uses
+ * hi = (run << 32) | pid and lo = lsn. The largest key is reserved to mark
+ * empty leaves of the tree.
+ */
+struct w_packed_key_t {
+    uint64_t hi;
+    uint64_t lo;
+
+    w_packed_key_t() : hi(0), lo(0) {}
+    w_packed_key_t(uint64_t hi, uint64_t lo) : hi(hi), lo(lo) {}
+
+    static w_packed_key_t max() { return w_packed_key_t(~0ULL, ~0ULL); }
+
+    bool is_max() const { return hi == ~0ULL && lo == ~0ULL; }
+
+    bool operator<(const w_packed_key_t& other) const
+    {
+#ifdef __SIZEOF_INT128__
+        // lets the compiler emit a branch-free comparison
+        return (((unsigned __int128) hi << 64) | lo)
+            < (((unsigned __int128) other.hi << 64) | other.lo);
+#else
+        return hi < other.hi || (hi == other.hi && lo < other.lo);
+#endif
+    }
+};
+
+/**\brief Tournament tree of losers, used for run generation and k-way merge.
+ *
+ * Each element occupies one leaf of a complete binary tree. Every internal
+ * node stores the key and leaf number of the element that lost the match
+ * played at that node, and node 0 stores the overall winner, i.e., the
+ * smallest key. Since keys are packed integers stored in the nodes
+ * themselves, a match costs one integer comparison without dereferencing
+ * anything; values are kept in a separate array indexed by leaf.
+ *
+ * Replacing or removing the winner replays the matches on the path from
+ * its leaf to the root: exactly log2(capacity) comparisons and, unlike
+ * Heap::ReplacedFirst(), no access to siblings off that path. This is the
+ * operation of a k-way merge, where the winner is replaced by the next
+ * element of the same input (replace_top()), or removed once its input is
+ * exhausted (pop()).
+ *
+ * In replacement selection, a pop() is usually followed by a push(). To
+ * take advantage of that, pop() only marks the leaf of the winner as free,
+ * and the next push() reuses it with a single replay, as in replace_top().
+ * If another operation comes first, the removal is replayed then. A push()
+ * into any other free leaf must first reconstruct the winners on the path
+ * of that leaf top-down, because the losers stored on the path do not tell
+ * which of them won the match below; the replay then takes the same number
+ * of comparisons. The tree grows (doubling its capacity) when all leaves
+ * are taken.
+ *
+ * Complexity:
+ *   - build (initial or grow)        O(capacity)
+ *   - top                            O(1)
+ *   - push, pop, replace_top         O(log capacity)
+ *
+ * Empty leaves hold w_packed_key_t::max(), so keys inserted by callers must
+ * be smaller than that.
+ */
+template <class V>
+class LoserTree
+{
+public:
+    typedef w_packed_key_t key_t;
+
+    LoserTree(size_t capacity = 2)
+        : _capacity(0), _size(0), _height(0), _pending(false)
+    {
+        size_t cap = 2;
+        while (cap < capacity) { cap <<= 1; }
+        _grow(cap);
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    size_t capacity() const { return _capacity; }
+
+    /// Smallest key; undefined if the tree is empty
+    const key_t& top_key()
+    {
+        _flush();
+        return _nodes[0].key;
+    }
+
+    V& top()
+    {
+        _flush();
+        return _values[_nodes[0].leaf];
+    }
+
+    /// Inserts a new element into a free leaf
+    void push(const key_t& key, const V& value)
+    {
+        w_assert1(!key.is_max());
+        if (_pending) {
+            // reuse the leaf of the winner removed by pop()
+            _pending = false;
+            uint32_t leaf = _nodes[0].leaf;
+            _values[leaf] = value;
+            _replay(key, leaf);
+            _size++;
+            return;
+        }
+
+        if (_free.empty()) {
+            _grow(2 * _capacity);
+        }
+        uint32_t leaf = _free.back();
+        _free.pop_back();
+        _values[leaf] = value;
+        _update(key, leaf);
+        _size++;
+    }
+
+    /// Removes the smallest element
+    void pop()
+    {
+        w_assert1(_size > 0);
+        _flush();
+        _pending = true;
+        _size--;
+    }
+
+    /// Assigns a new key to the smallest element, whose value may be
+    /// modified in place via top() before or after the call
+    void replace_top(const key_t& key)
+    {
+        w_assert1(_size > 0 && !key.is_max());
+        _flush();
+        _replay(key, _nodes[0].leaf);
+    }
+
+private:
+    struct node_t {
+        key_t key;
+        uint32_t leaf;
+    };
+
+    size_t _capacity;
+    size_t _size;
+    uint32_t _height;
+
+    /// _nodes[0] is the winner; _nodes[n], 1 <= n < capacity, the loser of
+    /// node n, whose children are nodes 2n and 2n+1. Leaf i is node
+    /// capacity + i, which is implicit: every leaf is in exactly one node.
+    std::vector<node_t> _nodes;
+    std::vector<V> _values;
+    std::vector<uint32_t> _free;
+
+    /// The winner in _nodes[0] was popped but not replayed yet
+    bool _pending;
+
+    void _flush()
+    {
+        if (_pending) {
+            _pending = false;
+            uint32_t leaf = _nodes[0].leaf;
+            _replay(key_t::max(), leaf);
+            _free.push_back(leaf);
+        }
+    }
+
+    /// Replays the matches of the leaf of the winner with its new key
+    void _replay(const key_t& key, uint32_t leaf)
+    {
+        node_t winner;
+        winner.key = key;
+        winner.leaf = leaf;
+        for (size_t n = (_capacity + leaf) >> 1; n > 0; n >>= 1) {
+            if (_nodes[n].key < winner.key) {
+                std::swap(_nodes[n], winner);
+            }
+        }
+        _nodes[0] = winner;
+    }
+
+    /// Replays the matches of an arbitrary free leaf with its new key
+    void _update(const key_t& key, uint32_t leaf)
+    {
+        // Top-down: the two elements known at each node on the path are the
+        // winners of its children. The one not in the subtree of the path
+        // is the opponent of the path at that node, and the other one is
+        // the winner of the next node below.
+        node_t opponent[32];
+        node_t winner = _nodes[0];
+        size_t pos = _capacity + leaf;
+        for (uint32_t d = _height; d > 0; d--) {
+            const node_t& loser = _nodes[pos >> d];
+            if (((_capacity + loser.leaf) >> (d - 1)) == (pos >> (d - 1))) {
+                opponent[d - 1] = winner;
+                winner = loser;
+            }
+            else {
+                opponent[d - 1] = loser;
+            }
+        }
+
+        // Bottom-up: replay against the opponents
+        winner.key = key;
+        winner.leaf = leaf;
+        for (uint32_t d = 1; d <= _height; d++) {
+            node_t& n = _nodes[pos >> d];
+            if (opponent[d - 1].key < winner.key) {
+                n = winner;
+                winner = opponent[d - 1];
+            }
+            else {
+                n = opponent[d - 1];
+            }
+        }
+        _nodes[0] = winner;
+    }
+
+    /// Sets the capacity and plays all matches again
+    void _grow(size_t capacity)
+    {
+        w_assert1(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        w_assert1(!_pending);
+
+        // every leaf appears in exactly one node
+        std::vector<node_t> leaves(capacity);
+        for (size_t i = 0; i < capacity; i++) {
+            leaves[i].key = key_t::max();
+            leaves[i].leaf = i;
+        }
+        for (size_t n = 0; n < _capacity; n++) {
+            leaves[_nodes[n].leaf].key = _nodes[n].key;
+        }
+
+        // new leaves are handed out lowest first
+        for (size_t i = capacity; i > _capacity; i--) {
+            _free.push_back(i - 1);
+        }
+        _values.resize(capacity);
+        _nodes.assign(capacity, node_t());
+        _capacity = capacity;
+        _height = 0;
+        while ((1ULL << _height) < capacity) { _height++; }
+
+        // winners of internal nodes are only needed during the build
+        std::vector<node_t> winners(capacity);
+        for (size_t n = capacity - 1; n > 0; n--) {
+            size_t l = 2 * n, r = 2 * n + 1;
+            const node_t& wl = l >= capacity ? leaves[l - capacity] : winners[l];
+            const node_t& wr = r >= capacity ? leaves[r - capacity] : winners[r];
+            if (wr.key < wl.key) {
+                winners[n] = wr;
+                _nodes[n] = wl;
+            }
+            else {
+                winners[n] = wl;
+                _nodes[n] = wr;
+            }
+        }
+        _nodes[0] = winners[1];
+    }
+};
+
+#endif
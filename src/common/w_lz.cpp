@@ -0,0 +1,179 @@
+#include "w_lz.h"
+
+#include <cstring>
+#include <stdint.h>
+
+namespace w_lz {
+
+/// Hash table of previous positions used by compress()
+const size_t hash_bits = 12;
+
+/// Largest distance of a back-reference (2-byte offset)
+const size_t max_offset = 65535;
+
+static inline uint32_t read32(const char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline size_t hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - hash_bits);
+}
+
+static bool put_length(char*& op, const char* oend, size_t len)
+{
+    while (len >= 255) {
+        if (op >= oend) { return false; }
+        *op++ = (char) 255;
+        len -= 255;
+    }
+    if (op >= oend) { return false; }
+    *op++ = (char) len;
+    return true;
+}
+
+static bool get_length(const unsigned char*& ip, const unsigned char* iend,
+        size_t& len)
+{
+    while (ip < iend) {
+        unsigned char b = *ip++;
+        len += b;
+        if (b < 255) { return true; }
+    }
+    return false;
+}
+
+/*
+ * Appends one (literals, match) pair to the output. A match_len of zero
+ * produces the final, literals-only pair.
+ */
+static bool put_sequence(char*& op, const char* oend, const char* lit,
+        size_t lit_len, size_t offset, size_t match_len)
+{
+    if (op >= oend) { return false; }
+    char* token = op++;
+
+    unsigned char t;
+    if (lit_len >= 15) {
+        t = 15 << 4;
+        if (!put_length(op, oend, lit_len - 15)) { return false; }
+    }
+    else {
+        t = lit_len << 4;
+    }
+
+    if ((size_t) (oend - op) < lit_len) { return false; }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len > 0) {
+        if (oend - op < 2) { return false; }
+        *op++ = (char) (offset & 0xff);
+        *op++ = (char) (offset >> 8);
+
+        size_t ml = match_len - min_match;
+        if (ml >= 15) {
+            t |= 15;
+            if (!put_length(op, oend, ml - 15)) { return false; }
+        }
+        else {
+            t |= ml;
+        }
+    }
+
+    *token = (char) t;
+    return true;
+}
+
+size_t compress(const char* src, size_t len, char* dst, size_t capacity)
+{
+    if (len > max_input) { return 0; }
+
+    // Positions are stored plus one, so that zero means empty
+    uint32_t table[1 << hash_bits];
+    memset(table, 0, sizeof(table));
+
+    const char* ip = src;
+    const char* anchor = src;
+    const char* const end = src + len;
+    char* op = dst;
+    const char* const oend = dst + capacity;
+
+    while (ip + min_match <= end) {
+        uint32_t seq = read32(ip);
+        size_t h = hash(seq);
+        size_t cand = table[h];
+        table[h] = (ip - src) + 1;
+
+        if (cand > 0) {
+            const char* ref = src + cand - 1;
+            if ((size_t) (ip - ref) <= max_offset && read32(ref) == seq) {
+                size_t mlen = min_match;
+                while (ip + mlen < end && ref[mlen] == ip[mlen]) { mlen++; }
+
+                if (!put_sequence(op, oend, anchor, ip - anchor, ip - ref,
+                            mlen))
+                {
+                    return 0;
+                }
+                ip += mlen;
+                anchor = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+
+    if (!put_sequence(op, oend, anchor, end - anchor, 0, 0)) { return 0; }
+    return op - dst;
+}
+
+size_t decompress(const char* src, size_t len, char* dst, size_t capacity)
+{
+    const unsigned char* ip = (const unsigned char*) src;
+    const unsigned char* const iend = ip + len;
+    char* op = dst;
+    const char* const oend = dst + capacity;
+
+    while (ip < iend) {
+        unsigned char t = *ip++;
+
+        size_t lit = t >> 4;
+        if (lit == 15 && !get_length(ip, iend, lit)) { return 0; }
+        if ((size_t) (iend - ip) < lit || (size_t) (oend - op) < lit) {
+            return 0;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        // last pair has no match
+        if (ip == iend) { break; }
+
+        if (iend - ip < 2) { return 0; }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        size_t mlen = t & 15;
+        if (mlen == 15 && !get_length(ip, iend, mlen)) { return 0; }
+        mlen += min_match;
+
+        if (offset == 0 || offset > (size_t) (op - dst)
+                || (size_t) (oend - op) < mlen)
+        {
+            return 0;
+        }
+
+        // byte-wise copy, since source and destination may overlap
+        const char* ref = op - offset;
+        for (size_t i = 0; i < mlen; i++) { op[i] = ref[i]; }
+        op += mlen;
+    }
+
+    return op - dst;
+}
+
+} // namespace w_lz
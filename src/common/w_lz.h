@@ -0,0 +1,50 @@
+#ifndef W_LZ_H
+#define W_LZ_H
+
+#include "w_defines.h"
+
+#include <cstddef>
+
+/**
+ * \brief Byte-oriented LZ77 compression of small buffers.
+ *
+ * \details
+ * A minimal codec in the spirit of LZ4, meant for compressing single pages
+ * in the I/O path: compression is a single greedy pass with a small hash
+ * table of previous positions, and decompression is a plain copy loop.
+ *
+ * The compressed stream is a sequence of (literals, match) pairs. Each pair
+ * starts with a token byte whose high nibble is the number of literals and
+ * whose low nibble is the match length minus min_match; a nibble value of 15
+ * is continued with bytes of 255 terminated by a byte smaller than 255. The
+ * literals follow the token, and then a 2-byte little-endian match offset and
+ * the extended match length. The last pair of the stream has only literals.
+ *
+ * Buffers are limited to max_input bytes, which is more than the largest
+ * page size.
+ */
+namespace w_lz {
+
+/// Shortest match encoded as a back-reference
+const size_t min_match = 4;
+
+/// Largest buffer that can be compressed
+const size_t max_input = 1 << 20;
+
+/**
+ * Compresses len bytes of src into dst, which has room for capacity bytes.
+ * Returns the compressed size, or 0 if it would exceed capacity (i.e., if
+ * the data does not compress well enough).
+ */
+size_t compress(const char* src, size_t len, char* dst, size_t capacity);
+
+/**
+ * Decompresses len bytes of src into dst, which has room for capacity
+ * bytes. Returns the decompressed size, or 0 if the input is malformed or
+ * does not fit into dst.
+ */
+size_t decompress(const char* src, size_t len, char* dst, size_t capacity);
+
+} // namespace w_lz
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef W_MPSC_QUEUE_H
+#define W_MPSC_QUEUE_H
+
+#include "w_defines.h"
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * \brief Unbounded FIFO queue for multiple producers and a single consumer.
+ * \ingroup LOCKFREE
+ * \details
+ * Node-based queue after Dmitry Vyukov's intrusive MPSC algorithm. push() is
+ * wait-free: a producer swaps itself into the head with one atomic exchange
+ * and then links the previous head to its node. The consumer follows the
+ * links from the tail without any atomic read-modify-write operation.
+ *
+ * Unlike LockFreeQueue, nodes are allocated by the queue and freed by the
+ * consumer, which is the only thread that dereferences consumed nodes, so
+ * there is no ABA problem and no need for safe memory reclamation.
+ *
+ * A push() is visible to the consumer once its second step (the link) is
+ * done. Until then, the consumer sees the queue as empty at that point, even
+ * if further pushes already completed after it; it only has to try again.
+ *
+ * push() may be called by any thread; pop(), peek() and empty() only by the
+ * single consumer.
+ */
+template <class T>
+class MPSCQueue {
+public:
+    MPSCQueue()
+    {
+        node_t* stub = new node_t();
+        _head.store(stub, std::memory_order_relaxed);
+        _tail = stub;
+    }
+
+    ~MPSCQueue()
+    {
+        T value;
+        while (pop(value)) {}
+        delete _tail;
+    }
+
+    void push(const T& value)
+    {
+        node_t* node = new node_t();
+        node->value = value;
+        node_t* prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /// Removes the oldest element; returns false if the queue is empty
+    bool pop(T& value)
+    {
+        node_t* next = _tail->next.load(std::memory_order_acquire);
+        if (!next) { return false; }
+        value = next->value;
+        // next becomes the new stub
+        delete _tail;
+        _tail = next;
+        return true;
+    }
+
+    /// Reads the oldest element without removing it
+    bool peek(T& value)
+    {
+        node_t* next = _tail->next.load(std::memory_order_acquire);
+        if (!next) { return false; }
+        value = next->value;
+        return true;
+    }
+
+    bool empty()
+    {
+        return _tail->next.load(std::memory_order_acquire) == NULL;
+    }
+
+private:
+    struct node_t {
+        std::atomic<node_t*> next;
+        T value;
+
+        node_t() : next(NULL), value() {}
+    };
+
+    // producers and consumer on different cache lines
+    alignas(64) std::atomic<node_t*> _head;
+    alignas(64) node_t* _tail;
+
+    MPSCQueue(const MPSCQueue&);
+    MPSCQueue& operator=(const MPSCQueue&);
+};
+
+#endif
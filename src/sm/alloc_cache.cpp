@@ -13,31 +13,105 @@
 
 const size_t alloc_cache_t::extent_size = alloc_page::bits_held;
 
-alloc_cache_t::alloc_cache_t(stnode_cache_t& stcache, bool virgin)
-    : last_alloc_page(0), stcache(stcache)
+// PageID is 32 bits wide
+static const size_t max_extents = (size_t(1) << 32) / alloc_page::bits_held;
+
+static std::atomic<uint64_t> next_alloc_cache_id(1);
+
+/*
+ * Slab of the calling thread, i.e., the range [next, end) of pages which
+ * it reserved and did not allocate yet. If a thread exits or the volume is
+ * remounted, the rest of its slab is left as free pages in the extent.
+ */
+struct alloc_slab_t {
+    uint64_t owner = 0;
+    PageID next = 0;
+    PageID end = 0;
+};
+
+static thread_local alloc_slab_t tls_alloc_slab;
+
+alloc_cache_t::extent_t::extent_t()
+    : loaded(false), page_lsn(lsn_t::null)
+{
+    for (size_t i = 0; i < words; i++) {
+        free_bits[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool alloc_cache_t::extent_t::is_free(size_t bit) const
+{
+    uint64_t word = free_bits[bit / 64].load(std::memory_order_acquire);
+    return (word & (uint64_t(1) << (bit % 64))) != 0;
+}
+
+void alloc_cache_t::extent_t::set_free(size_t bit)
+{
+    free_bits[bit / 64].fetch_or(uint64_t(1) << (bit % 64),
+            std::memory_order_acq_rel);
+}
+
+void alloc_cache_t::extent_t::unset_free(size_t bit)
+{
+    free_bits[bit / 64].fetch_and(~(uint64_t(1) << (bit % 64)),
+            std::memory_order_acq_rel);
+}
+
+alloc_cache_t::alloc_cache_t(stnode_cache_t& stcache, bool virgin,
+        size_t slab_size)
+    : last_alloc_page(0), stcache(stcache),
+    slab_size(slab_size > 0 ? slab_size : 1),
+    _id(next_alloc_cache_id++)
 {
-    vector<StoreID> stores;
-    stcache.get_used_stores(stores);
+    extents = new std::atomic<extent_t*>[max_extents];
+    for (size_t i = 0; i < max_extents; i++) {
+        extents[i].store(NULL, std::memory_order_relaxed);
+    }
 
     if (virgin) {
         // Extend 0 and stnode pid are always allocated
-        loaded_extents.push_back(true);
+        get_extent(0)->loaded = true;
         last_alloc_page = stnode_page::stpid;
     }
     else {
         // Load last extent eagerly and the rest of them on demand
         extent_id_t ext = stcache.get_last_extent();
-        loaded_extents.resize(ext + 1, false);
         W_COERCE(load_alloc_page(ext, true));
     }
 }
 
+alloc_cache_t::~alloc_cache_t()
+{
+    for (size_t i = 0; i < max_extents; i++) {
+        delete extents[i].load();
+    }
+    delete[] extents;
+}
+
+alloc_cache_t::extent_t* alloc_cache_t::get_extent(extent_id_t ext)
+{
+    w_assert1(ext < max_extents);
+    extent_t* e = extents[ext].load(std::memory_order_acquire);
+    if (!e) {
+        // install a new one unless another thread was faster
+        extent_t* created = new extent_t;
+        if (extents[ext].compare_exchange_strong(e, created)) {
+            e = created;
+        }
+        else {
+            delete created;
+        }
+    }
+    return e;
+}
+
 rc_t alloc_cache_t::load_alloc_page(extent_id_t ext, bool is_last_ext)
 {
     spinlock_write_critical_section cs(&_latch);
 
     // protect against race on concurrent loads
-    if (loaded_extents[ext]) {
+    extent_t* e = get_extent(ext);
+    if (e->loaded) {
         return RCOK;
     }
 
@@ -52,9 +126,9 @@ rc_t alloc_cache_t::load_alloc_page(extent_id_t ext, bool is_last_ext)
 
     alloc_page* page = (alloc_page*) p.get_generic_page();
 
+    // bit 0 is the alloc page itself, which is always allocated
     size_t last_alloc = 0;
-    size_t j = alloc_page::bits_held;
-    while (j > 0) {
+    for (size_t j = alloc_page::bits_held - 1; j > 0; j--) {
         if (page->get_bit(j)) {
             if (last_alloc == 0) {
                 last_alloc = j;
@@ -64,14 +138,15 @@ rc_t alloc_cache_t::load_alloc_page(extent_id_t ext, bool is_last_ext)
             }
         }
         else if (last_alloc != 0) {
-            freed_pages.insert(alloc_pid + j);
+            e->set_free(j);
         }
-
-        j--;
     }
 
-    page_lsns[p.pid()] = p.lsn();
-    loaded_extents[ext] = true;
+    {
+        spinlock_write_critical_section ecs(&e->latch);
+        e->page_lsn = p.lsn();
+    }
+    e->loaded.store(true, std::memory_order_release);
 
     // pass argument evict=true because we won't be maintaining the page
     p.unfix(true);
@@ -81,16 +156,16 @@ rc_t alloc_cache_t::load_alloc_page(extent_id_t ext, bool is_last_ext)
 
 PageID alloc_cache_t::get_last_allocated_pid() const
 {
-    spinlock_read_critical_section cs(&_latch);
-    return last_alloc_page;
+    return last_alloc_page.load(std::memory_order_acquire);
 }
 
 lsn_t alloc_cache_t::get_page_lsn(PageID pid)
 {
-    spinlock_read_critical_section cs(&_latch);
-    map<PageID, lsn_t>::const_iterator it = page_lsns.find(pid);
-    if (it == page_lsns.end()) { return lsn_t::null; }
-    return it->second;
+    extent_t* e = extents[pid / extent_size].load(std::memory_order_acquire);
+    if (!e) { return lsn_t::null; }
+
+    spinlock_read_critical_section cs(&e->latch);
+    return e->page_lsn;
 }
 
 bool alloc_cache_t::is_allocated(PageID pid)
@@ -98,73 +173,108 @@ bool alloc_cache_t::is_allocated(PageID pid)
     // No latching required to check if loaded. Any races will be
     // resolved inside load_alloc_page
     extent_id_t ext = pid / extent_size;
-    if (!loaded_extents[ext]) {
+    extent_t* e = get_extent(ext);
+    if (!e->loaded.load(std::memory_order_acquire)) {
         W_COERCE(load_alloc_page(ext, false));
     }
 
-    spinlock_read_critical_section cs(&_latch);
+    if (pid > last_alloc_page.load(std::memory_order_acquire)) {
+        return false;
+    }
 
-    // loaded cannot go from true to false, so this is safe
-    w_assert0(loaded_extents[ext]);
+    // Pages of a slab that was just reserved may be reported as allocated
+    // until the reserving thread marks them free, but nobody can refer to
+    // them before they are handed out.
+    return !e->is_free(pid % extent_size);
+}
 
-    if (pid > last_alloc_page) { return false; }
+rc_t alloc_cache_t::reserve_slab(PageID& first, PageID& end)
+{
+    PageID last = last_alloc_page.load(std::memory_order_acquire);
+    while (true) {
+        first = last + 1;
+        w_assert1(first != stnode_page::stpid);
+
+        if (first % extent_size == 0) {
+            // Contiguous space of the last extent is exhausted. Appending
+            // the new extent is logged, so it is serialized on the latch.
+            spinlock_write_critical_section cs(&_latch);
+            if (last_alloc_page.load() == last) {
+                extent_id_t ext = first / extent_size;
+                W_DO(stcache.sx_append_extent(ext));
+                get_extent(ext)->loaded = true;
+                // the alloc page is not handed out
+                last_alloc_page.store(first);
+            }
+            last = last_alloc_page.load();
+            continue;
+        }
+
+        // A slab never spans two extents
+        PageID extent_end = (first / extent_size + 1) * extent_size;
+        end = first + slab_size;
+        if (end > extent_end || end < first) { end = extent_end; }
+
+        if (last_alloc_page.compare_exchange_weak(last, end - 1)) {
+            break;
+        }
+    }
+
+    // Pages of the slab are free until the thread hands them out
+    extent_t* e = get_extent(first / extent_size);
+    for (PageID p = first; p < end; p++) {
+        e->set_free(p % extent_size);
+    }
+    INC_TSTAT(alloc_slabs_reserved);
 
-    pid_set::const_iterator iter = freed_pages.find(pid);
-    return (iter == freed_pages.end());
+    return RCOK;
 }
 
 rc_t alloc_cache_t::sx_allocate_page(PageID& pid, bool redo)
 {
-    spinlock_write_critical_section cs(&_latch);
-
     if (redo) {
         // all space before this pid must not be contiguous free space
-        if (last_alloc_page < pid) {
-            last_alloc_page = pid;
-        }
-        // if pid is on freed list, remove
-        pid_set::iterator iter = freed_pages.find(pid);
-        if (iter != freed_pages.end()) {
-            freed_pages.erase(iter);
-        }
+        PageID last = last_alloc_page.load();
+        while (last < pid && !last_alloc_page.compare_exchange_weak(last, pid))
+        {}
+        // if pid is in the free bitmap, remove
+        get_extent(pid / extent_size)->unset_free(pid % extent_size);
+        return RCOK;
     }
-    else {
-        pid = last_alloc_page + 1;
-        w_assert1(pid != stnode_page::stpid);
 
-        if (pid % extent_size == 0) {
-            extent_id_t ext = last_alloc_page / extent_size + 1;
-            pid = ext * extent_size + 1;
-            W_DO(stcache.sx_append_extent(ext));
-        }
+    alloc_slab_t& slab = tls_alloc_slab;
+    if (slab.owner != _id || slab.next >= slab.end) {
+        W_DO(reserve_slab(slab.next, slab.end));
+        slab.owner = _id;
+    }
+    pid = slab.next++;
 
-        last_alloc_page = pid;
+    extent_t* e = get_extent(pid / extent_size);
+    e->unset_free(pid % extent_size);
 
-        // CS TODO: page allocation should transfer ownership instead of just
-        // marking the page as allocated; otherwise, zombie pages may appear
-        // due to system failures after allocation but before setting the
-        // pointer on the new owner/parent page. To fix this, an SSX to
-        // allocate an emptry b-tree child would be the best option.
+    // CS TODO: page allocation should transfer ownership instead of just
+    // marking the page as allocated; otherwise, zombie pages may appear
+    // due to system failures after allocation but before setting the
+    // pointer on the new owner/parent page. To fix this, an SSX to
+    // allocate an emptry b-tree child would be the best option.
 
-        // Entry in page_lsns array is updated by the log insertion
-        extent_id_t ext = pid / extent_size;
-        sysevent::log_alloc_page(pid, page_lsns[ext * extent_size]);
-    }
+    // Extent page LSN is updated by the log insertion
+    spinlock_write_critical_section cs(&e->latch);
+    sysevent::log_alloc_page(pid, e->page_lsn);
 
     return RCOK;
 }
 
 rc_t alloc_cache_t::sx_deallocate_page(PageID pid, bool redo)
 {
-    spinlock_write_critical_section cs(&_latch);
-
-    // Just add to list of freed pages
-    freed_pages.insert(pid);
+    // Just add to the free bitmap
+    extent_t* e = get_extent(pid / extent_size);
+    e->set_free(pid % extent_size);
 
     if (!redo) {
-        // Entry in page_lsns array is updated by the log insertion
-        extent_id_t ext = pid / extent_size;
-        sysevent::log_dealloc_page(pid, page_lsns[ext * extent_size]);
+        // Extent page LSN is updated by the log insertion
+        spinlock_write_critical_section cs(&e->latch);
+        sysevent::log_dealloc_page(pid, e->page_lsn);
     }
 
     return RCOK;
@@ -174,27 +284,23 @@ rc_t alloc_cache_t::write_dirty_pages(lsn_t rec_lsn)
 {
     generic_page* buf = NULL;
     lsn_t page_lsn = lsn_t::null;
-    extent_id_t last_extent = 0;
 
-    // We just have to iterate over the extents in the page_lsns table, since
-    // those are the only ones which were modified since the system started.
-    {
-        spinlock_read_critical_section cs (&_latch);
-        last_extent = last_alloc_page / extent_size;
-    }
+    // We just have to iterate over the extents which were touched since the
+    // system started.
+    extent_id_t last_extent = get_last_allocated_pid() / extent_size;
 
-    map<PageID, lsn_t>::const_iterator iter;
     for (extent_id_t ext = 0; ext <= last_extent; ext++) {
         PageID alloc_pid = ext * extent_size;
+        extent_t* e = extents[ext].load(std::memory_order_acquire);
+        if (!e) { continue; }
+
         // While in the critical section, just verify if the extent alloc page
         // needs to be written, to avoid blocking threads trying to allocate
         // pages for too long.
         {
-            spinlock_read_critical_section cs(&_latch);
-            iter = page_lsns.find(alloc_pid);
-            if (iter == page_lsns.end()) { continue; }
-            if (iter->second > rec_lsn) { continue; }
-            page_lsn = iter->second;
+            spinlock_read_critical_section cs(&e->latch);
+            if (e->page_lsn.is_null() || e->page_lsn > rec_lsn) { continue; }
+            page_lsn = e->page_lsn;
         }
 
         if (!buf) {
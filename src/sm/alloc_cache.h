@@ -8,8 +8,8 @@
 #include "w_defines.h"
 #include "alloc_page.h"
 #include "latch.h"
+#include <atomic>
 #include <vector>
-#include <unordered_set>
 
 class bf_fixed_m;
 
@@ -20,11 +20,19 @@ class bf_fixed_m;
  * This object handles allocation/deallocation requests for one volume.
  * All allocation/deallocation are logged and done in a critical section.
  * To make it scalable, this object is designed to be as fast as possible.
+ *
+ * Page IDs are handed out from per-thread slabs, i.e., contiguous ranges of
+ * up to slab_size pages which a thread reserves from the contiguous free
+ * space with a single CAS on last_alloc_page. Allocations from the slab then
+ * require no shared state other than the extent of the page, whose latch only
+ * protects the log-record chain of the alloc page. Appending a new extent is
+ * the only operation that takes the global latch.
  * @See alloc_page_h
  */
 class alloc_cache_t {
 public:
-    alloc_cache_t(stnode_cache_t& stcache, bool virgin);
+    alloc_cache_t(stnode_cache_t& stcache, bool virgin, size_t slab_size = 1);
+    ~alloc_cache_t();
 
     /**
      * Allocates one page. (System transaction)
@@ -48,10 +56,10 @@ public:
      * that, but only on the pages that require propagation, i.e., only those
      * of loaded extents with greater PageLSN.
      *
-     * For any extent for which loaded_extents[ext] == true, all free pages
-     * with id lower than last_alloc_page are guaranteed to be in the free
-     * list. Extents for which loaded_extents[ext] == false, on the other hand,
-     * are guaranteed to be up-do-date on disk.
+     * For any loaded extent, all free pages with id lower than
+     * last_alloc_page are guaranteed to be set in its free bitmap. Extents
+     * which are not loaded, on the other hand, are guaranteed to be
+     * up-do-date on disk.
      */
     rc_t write_dirty_pages(lsn_t rec_lsn);
 
@@ -68,48 +76,78 @@ public:
 private:
 
     /**
-     * Keep track of free pages using the ID of the last allocated page and
-     * a list of free pages whose IDs are lower than that.
+     * In-memory allocation state of one extent.
      *
-     * Pages which are freed end up in the list of freed pages, again
-     * one for each store. Currently, these lists are only used to determine
-     * whether a certain page is allocated or not. To avoid fragmentation in
-     * a workload with many deletions, items should be removed from these lists
-     * when allocating a page to avoid fragmentation. One extreme policy would
-     * be to only use the contiguous space when the corresponding list is
-     * empty, i.e., when the non-contiguous space has been fully utilized.
-     * Policies that trade off allocation performance for fragmentation by
-     * managing allocations from both contiguous and non-contiguous space would
-     * be the more flexible and robust option.
+     * Free pages are kept in a bitmap with one bit per page of the extent,
+     * which is set if the page is free and lower than last_alloc_page. Bits
+     * are flipped with atomic operations, so is_allocated() does not block.
+     *
+     * The page_lsn field is needed for the sole purpose of maintaining
+     * per-page log-record chains. It keeps track of the current pageLSN of
+     * the alloc page. Since we don't apply allocation operations on the pages
+     * directly (i.e., no page fix is performed), this is required to
+     * generate a correct prev_page pointer when logging allocations. It is
+     * protected by the extent latch, which must be held while inserting the
+     * log record.
      */
-    PageID last_alloc_page;
+    struct extent_t {
+        static const size_t words = alloc_page::bits_held / 64;
 
-    typedef unordered_set<PageID> pid_set;
-    pid_set freed_pages;
+        std::atomic<uint64_t> free_bits[words];
+        std::atomic<bool> loaded;
+        lsn_t page_lsn;
+        srwlock_t latch;
+
+        extent_t();
+
+        bool is_free(size_t bit) const;
+        void set_free(size_t bit);
+        void unset_free(size_t bit);
+    };
 
     /**
-     * Bitmap of extents whose allocation pages were already loaded. This is
-     * needed because the allocation information of each extent is loaded on
-     * demand.
+     * Keep track of free pages using the ID of the last allocated page and
+     * bitmaps of free pages whose IDs are lower than that.
+     *
+     * Pages which are freed end up in the free bitmap of their extent.
+     * Currently, the bitmaps are only used to determine whether a certain
+     * page is allocated or not. To avoid fragmentation in a workload with
+     * many deletions, free pages should be reused when allocating a page.
+     * One extreme policy would be to only use the contiguous space when the
+     * bitmaps are empty, i.e., when the non-contiguous space has been fully
+     * utilized. Policies that trade off allocation performance for
+     * fragmentation by managing allocations from both contiguous and
+     * non-contiguous space would be the more flexible and robust option.
      */
-    vector<bool> loaded_extents;
+    std::atomic<PageID> last_alloc_page;
 
     /**
-     * CS TODO
-     * This map is needed for the sole purpose of maintaining per-page
-     * log-record chains. It keeps track of the current pageLSN of each
-     * alloc page. Since we don't apply allocation operations on the pages
-     * directly (i.e., no page fix is performed), this is required to
-     * generate a correct prev_page pointer when logging allocations.
+     * Extent states, indexed by extent ID and created on first use. The
+     * allocation information of each extent is loaded on demand, so a
+     * non-null entry does not mean that the extent is loaded.
      */
-    map<PageID, lsn_t> page_lsns;
+    std::atomic<extent_t*>* extents;
 
     stnode_cache_t& stcache;
 
-    /** all operations in this object are protected by this lock. */
+    /** Number of pages reserved by a thread at once */
+    const size_t slab_size;
+
+    /**
+     * Identifies this object in the thread-local slabs, which may still
+     * refer to a previous instance (e.g., after the volume was remounted)
+     */
+    const uint64_t _id;
+
+    /** Protects loading of alloc pages and appending of extents */
     mutable srwlock_t _latch;
 
     rc_t load_alloc_page(extent_id_t ext, bool is_last_ext);
+
+    extent_t* get_extent(extent_id_t ext);
+
+    /** Reserves a new slab for the calling thread */
+    rc_t reserve_slab(PageID& first, PageID& end);
 };
 
 #endif // ALLOC_CACHE_H
@@ -0,0 +1,172 @@
+#include "backup_delta.h"
+
+#include "generic_page.h"
+#include "logarchiver.h"
+
+#include <algorithm>
+#include <cstring>
+
+const char backup_delta_header_t::MAGIC[8] =
+    { 'Z', 'D', 'E', 'L', 'T', 'A', 'B', 'K' };
+
+const size_t BACKUP_PAGE_SIZE = sizeof(generic_page);
+
+// Rounds up to a whole number of pages, for direct I/O
+static size_t page_align(size_t size)
+{
+    return (size + BACKUP_PAGE_SIZE - 1) / BACKUP_PAGE_SIZE
+        * BACKUP_PAGE_SIZE;
+}
+
+static char* alloc_aligned(size_t size)
+{
+    char* buf = NULL;
+    int res = posix_memalign((void**) &buf, LogArchiver::IO_ALIGN, size);
+    w_assert0(res == 0);
+    memset(buf, 0, size);
+    return buf;
+}
+
+bool backup_delta_header_t::isValid() const
+{
+    return memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && version == FORMAT_VERSION;
+}
+
+DeltaBackupWriter::DeltaBackupWriter(int fd, lsn_t baseLSN)
+    : fd(fd), baseLSN(baseLSN), nextOffset(BACKUP_PAGE_SIZE)
+{
+    w_assert0(fd >= 0);
+}
+
+rc_t DeltaBackupWriter::append(PageID first, size_t count, const void* buf)
+{
+    w_assert1(count > 0);
+    W_DO(me()->pwrite(fd, buf, count * BACKUP_PAGE_SIZE, nextOffset));
+
+    backup_delta_extent_t ext;
+    ext.first = first;
+    ext.count = count;
+    ext.offset = nextOffset;
+    extents.push_back(ext);
+
+    nextOffset += count * BACKUP_PAGE_SIZE;
+    return RCOK;
+}
+
+rc_t DeltaBackupWriter::finish(lsn_t backupLSN)
+{
+    // index goes after the last extent
+    size_t indexSize = page_align(std::max<size_t>(1, extents.size())
+            * sizeof(backup_delta_extent_t));
+    char* index = alloc_aligned(indexSize);
+    if (!extents.empty()) {
+        memcpy(index, &extents[0],
+                extents.size() * sizeof(backup_delta_extent_t));
+    }
+    rc_t rc = me()->pwrite(fd, index, indexSize, nextOffset);
+    free(index);
+    W_DO(rc);
+
+    // header is written last, so that an incomplete file is not valid
+    char* page = alloc_aligned(BACKUP_PAGE_SIZE);
+    backup_delta_header_t* header = (backup_delta_header_t*) page;
+    memcpy(header->magic, backup_delta_header_t::MAGIC,
+            sizeof(backup_delta_header_t::MAGIC));
+    header->version = backup_delta_header_t::FORMAT_VERSION;
+    header->extentCount = extents.size();
+    header->baseLSN = baseLSN;
+    header->backupLSN = backupLSN;
+    header->indexOffset = nextOffset;
+    rc = me()->pwrite(fd, page, BACKUP_PAGE_SIZE, 0);
+    free(page);
+    W_DO(rc);
+
+    return me()->fsync(fd);
+}
+
+DeltaBackupFile::DeltaBackupFile(const std::string& path)
+    : path(path), fd(-1)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+DeltaBackupFile::~DeltaBackupFile()
+{
+    if (fd >= 0) {
+        W_COERCE(me()->close(fd));
+    }
+}
+
+rc_t DeltaBackupFile::readHeader(int fd, backup_delta_header_t& header,
+        bool& isDelta)
+{
+    char* page = alloc_aligned(BACKUP_PAGE_SIZE);
+    int done = 0;
+    rc_t rc = me()->pread_short(fd, page, BACKUP_PAGE_SIZE, 0, done);
+    memcpy(&header, page, sizeof(header));
+    free(page);
+    W_DO(rc);
+
+    isDelta = done >= (int) sizeof(header) && header.isValid();
+    return RCOK;
+}
+
+rc_t DeltaBackupFile::open(bool directIO)
+{
+    w_assert0(fd < 0);
+    int flags = smthread_t::OPEN_RDONLY | smthread_t::OPEN_SYNC;
+    if (directIO) {
+        flags |= smthread_t::OPEN_DIRECT;
+    }
+    W_DO(me()->open(path.c_str(), flags, 0666, fd));
+
+    bool isDelta = false;
+    W_DO(readHeader(fd, header, isDelta));
+    if (!isDelta) {
+        return RC(eBAD_BACKUPPAGE);
+    }
+
+    size_t indexSize = page_align(std::max<size_t>(1, header.extentCount)
+            * sizeof(backup_delta_extent_t));
+    char* index = alloc_aligned(indexSize);
+    rc_t rc = me()->pread(fd, index, indexSize, header.indexOffset);
+    if (!rc.is_error()) {
+        backup_delta_extent_t* ext = (backup_delta_extent_t*) index;
+        extents.assign(ext, ext + header.extentCount);
+    }
+    free(index);
+    W_DO(rc);
+
+    std::sort(extents.begin(), extents.end(),
+            [] (const backup_delta_extent_t& a, const backup_delta_extent_t& b)
+            { return a.first < b.first; });
+
+    return RCOK;
+}
+
+rc_t DeltaBackupFile::overlay(PageID first, size_t count, char* buf)
+{
+    w_assert1(fd >= 0);
+    PageID end = first + count;
+
+    // first extent that may overlap the range
+    std::vector<backup_delta_extent_t>::iterator iter = std::upper_bound(
+            extents.begin(), extents.end(), first,
+            [] (PageID pid, const backup_delta_extent_t& e)
+            { return pid < e.first; });
+    if (iter != extents.begin()) { iter--; }
+
+    for (; iter != extents.end() && iter->first < end; iter++) {
+        PageID from = std::max(first, iter->first);
+        PageID to = std::min(end, PageID(iter->first + iter->count));
+        if (from >= to) { continue; }
+
+        size_t skip = size_t(from - iter->first) * BACKUP_PAGE_SIZE;
+        W_DO(me()->pread(fd, buf + size_t(from - first) * BACKUP_PAGE_SIZE,
+                    size_t(to - from) * BACKUP_PAGE_SIZE,
+                    iter->offset + skip));
+    }
+
+    return RCOK;
+}
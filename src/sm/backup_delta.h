@@ -0,0 +1,95 @@
+#ifndef BACKUP_DELTA_H
+#define BACKUP_DELTA_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "lsn.h"
+
+#include <string>
+#include <vector>
+
+/** \brief Header in the first page of an incremental (delta) backup file.
+ *
+ * A delta backup contains only the segments that changed between the backup
+ * it is based on (whose LSN is baseLSN) and backupLSN. The file consists of
+ * this header (padded to one page), the page extents in the order they were
+ * written, and an index of the extents, also padded to whole pages so that
+ * the file can be read with direct I/O.
+ */
+struct backup_delta_header_t {
+    static const char MAGIC[8];
+    static const uint32_t FORMAT_VERSION = 1;
+
+    char     magic[8];
+    uint32_t version;
+    uint32_t extentCount;
+    lsn_t    baseLSN;
+    lsn_t    backupLSN;
+    uint64_t indexOffset;
+
+    bool isValid() const;
+};
+
+/** \brief Entry of the extent index of a delta backup */
+struct backup_delta_extent_t {
+    PageID   first;
+    uint32_t count;
+    uint64_t offset;
+};
+
+/** \brief Writer of an incremental backup, used by vol_t::take_backup().
+ *
+ * Segments are appended by RestoreMgr (via vol_t::write_backup) as they
+ * are produced by merging the log archive into the previous backup, and the
+ * header and index are written by finish().
+ */
+class DeltaBackupWriter {
+public:
+    DeltaBackupWriter(int fd, lsn_t baseLSN);
+
+    rc_t append(PageID first, size_t count, const void* buf);
+
+    rc_t finish(lsn_t backupLSN);
+
+    size_t getExtentCount() const { return extents.size(); }
+
+private:
+    int fd;
+    lsn_t baseLSN;
+    uint64_t nextOffset;
+    std::vector<backup_delta_extent_t> extents;
+};
+
+/** \brief Read access to an incremental backup during restore.
+ *
+ * The extent index is loaded when the file is opened. overlay() copies the
+ * pages of the delta that fall into a given page range over a buffer that
+ * was filled from the preceding backups, so that a chain of a full backup
+ * plus any number of deltas is read like a single backup.
+ */
+class DeltaBackupFile {
+public:
+    DeltaBackupFile(const std::string& path);
+    ~DeltaBackupFile();
+
+    rc_t open(bool directIO);
+
+    rc_t overlay(PageID first, size_t count, char* buf);
+
+    const backup_delta_header_t& getHeader() const { return header; }
+
+    /** Reads the header of a backup file; returns false in isDelta if the
+     * file is a full backup */
+    static rc_t readHeader(int fd, backup_delta_header_t& header,
+            bool& isDelta);
+
+private:
+    std::string path;
+    int fd;
+    backup_delta_header_t header;
+    /// Sorted by first page
+    std::vector<backup_delta_extent_t> extents;
+};
+
+#endif
@@ -11,9 +11,6 @@ const std::string BackupPrefetcher::IMPL_NAME = "prefetcher";
 
 const size_t IO_ALIGN = LogArchiver::IO_ALIGN;
 
-// Time (in usec) for which to wait until a segment is requested/prefetched
-const unsigned WAIT_TIME = 500;
-
 BackupReader::BackupReader(size_t bufferSize)
 {
     // Using direct I/O
@@ -57,91 +54,107 @@ void BackupOnDemandReader::unfix(unsigned segment)
     W_IFDEBUG1(fixedSegment = -1);
 }
 
+/** Helper thread that issues backup reads on behalf of the prefetcher
+ *  CS: Placed here on cpp file because it isn't used anywhere else.
+ */
+class BackupPrefetcher::IOThread : public smthread_t {
+public:
+    IOThread(BackupPrefetcher* prefetcher)
+        : smthread_t(t_regular, "BackupPrefetcher_IO"), prefetcher(prefetcher)
+    {
+    }
+
+    virtual ~IOThread() {}
+
+    virtual void run()
+    {
+        prefetcher->ioLoop();
+    }
+
+private:
+    BackupPrefetcher* prefetcher;
+};
+
 BackupPrefetcher::BackupPrefetcher(vol_t* volume, size_t numSegments,
-        size_t segmentSize)
+        size_t segmentSize, size_t numIOs)
     : BackupReader(segmentSize * sizeof(generic_page) * numSegments),
       volume(volume), numSegments(numSegments), segmentSize(segmentSize),
       segmentSizeBytes(segmentSize * sizeof(generic_page)),
-      fixWaiting(false), shutdownFlag(false), lastEvicted(numSegments - 1)
+      numIOs(std::max<size_t>(numIOs, 1)),
+      shutdownFlag(false), requestSeq(0), lastEvicted(numSegments - 1)
 {
     w_assert1(volume);
 
-    // initialize all slots as free
+    // initialize all slots as free, lowest slot used first
     slots = new int[numSegments];
     status = new int[numSegments];
+    slotPriority = new int[numSegments];
     for (size_t i = 0; i < numSegments; i++) {
         status[i] = SLOT_FREE;
+        freeSlots.push_back(numSegments - 1 - i);
     }
-
-    DO_PTHREAD(pthread_mutex_init(&mutex, NULL));
 }
 
 BackupPrefetcher::~BackupPrefetcher()
 {
-    DO_PTHREAD(pthread_mutex_destroy(&mutex));
-
     delete[] slots;
+    delete[] status;
+    delete[] slotPriority;
 }
 
-void BackupPrefetcher::prefetch(unsigned segment, int priority)
+size_t BackupPrefetcher::findSlot(unsigned segment)
 {
-    CRITICAL_SECTION(cs, &mutex);
-
-    // if segment was already fetched, ignore
-    for (size_t i = 0; i < numSegments; i++)
-    {
+    for (size_t i = 0; i < numSegments; i++) {
         if (slots[i] == (int) segment && status[i] != SLOT_FREE) {
-            return;
+            return i;
         }
     }
+    return numSegments;
+}
 
-    // if segment was already requested, ignore
-    for (std::deque<unsigned>::iterator iter = requests.begin();
-            iter != requests.end(); iter++)
-    {
-        if (*iter == segment) { return; }
-    }
-
-    // add request to the queue
-    if (priority > 0) {
-        requests.push_front(segment);
+void BackupPrefetcher::addRequest(unsigned segment, int priority)
+{
+    std::map<unsigned, std::set<Request>::iterator>::iterator iter
+        = requested.find(segment);
+    if (iter != requested.end()) {
+        // if segment was already requested, only raise its priority
+        if (iter->second->priority >= priority) { return; }
+        Request req = *iter->second;
+        req.priority = priority;
+        requests.erase(iter->second);
+        iter->second = requests.insert(req).first;
     }
     else {
-        requests.push_back(segment);
+        Request req = { priority, requestSeq++, segment };
+        requested[segment] = requests.insert(req).first;
     }
-    DBG(<< "Requested prefetch of " << segment);
+    ioCond.notify_one();
 }
 
-char* BackupPrefetcher::fix(unsigned segment)
+void BackupPrefetcher::prefetch(unsigned segment, int priority)
 {
-    bool wait = false;
-    bool statIncremented = false;
-    while (true) {
+    w_assert1(priority < FIX_PRIORITY);
+    std::lock_guard<std::mutex> lock(mutex);
 
-        if (wait) {
-            usleep(WAIT_TIME);
-            wait = false;
-        }
+    // if segment was already fetched, ignore
+    if (findSlot(segment) < numSegments) { return; }
 
-        CRITICAL_SECTION(cs, &mutex);
+    addRequest(segment, priority);
+    DBG(<< "Requested prefetch of " << segment << " priority " << priority);
+}
 
+char* BackupPrefetcher::fix(unsigned segment)
+{
+    bool statIncremented = false;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
         // look for segment in buffer -- majority of calls should end here
         // on the first try, otherwise prefetch was not effective
-        for (size_t i = 0; i < numSegments; i++) {
-            if (slots[i] == (int) segment && status[i] != SLOT_FREE) {
-                if (status[i] == SLOT_READING) {
-                    // Segment is curretly being read -- let's just wait
-                    DBG(<< "Segment " << segment << " fix missed. "
-                            << "Waiting for read");
-                    wait = true;
-                    break;
-                }
-                w_assert0(status[i] == SLOT_UNFIXED);
-                status[i] = SLOT_FIXED;
-                DBG(<< "Fixed segment " << segment << " into slot " << i);
-                fixWaiting = false;
-                return buffer + (i * segmentSizeBytes);
-            }
+        size_t i = findSlot(segment);
+        if (i < numSegments && status[i] == SLOT_UNFIXED) {
+            status[i] = SLOT_FIXED;
+            DBG(<< "Fixed segment " << segment << " into slot " << i);
+            return buffer + (i * segmentSizeBytes);
         }
 
         if (!statIncremented) {
@@ -149,20 +162,20 @@ char* BackupPrefetcher::fix(unsigned segment)
             statIncremented = true;
         }
 
-        if (wait) { continue; }
-
-        // segment not in buffer -- move request to the front and wait
-        // for prefetch to catch up
-        std::deque<unsigned>::iterator iter
-            = std::find(requests.begin(), requests.end(), segment);
-        if (iter != requests.end()) {
-            requests.erase(iter);
+        if (i < numSegments) {
+            // Segment is curretly being read -- let's just wait
+            w_assert0(status[i] == SLOT_READING);
+            DBG(<< "Segment " << segment << " fix missed. "
+                    << "Waiting for read");
+        }
+        else {
+            // segment not in buffer -- move request to the front and wait
+            // for prefetch to catch up
+            DBG(<< "Segment " << segment << " fix missed. Wake up prefetcher");
+            addRequest(segment, FIX_PRIORITY);
         }
-        requests.push_front(segment);
 
-        DBG(<< "Segment " << segment << " fix missed. Wake up prefetcher");
-        fixWaiting = true;
-        wait = true;
+        fixCond.wait(lock);
     }
 
     // should never reach this
@@ -172,17 +185,18 @@ char* BackupPrefetcher::fix(unsigned segment)
 
 void BackupPrefetcher::unfix(unsigned segment)
 {
-    CRITICAL_SECTION(cs, &mutex);
-
-    for (size_t i = 0; i < numSegments; i++) {
-        if (slots[i] == (int) segment && status[i] != SLOT_FREE) {
-            w_assert1(status[i] == SLOT_FIXED);
-            // since each segment is used only once, it goes directly to
-            // free instead of unfixed
-            DBG(<< "Unfixed segment " << segment <<  " from slot " << i);
-            status[i] = SLOT_FREE;
-            return;
-        }
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t i = findSlot(segment);
+    if (i < numSegments) {
+        w_assert1(status[i] == SLOT_FIXED);
+        // since each segment is used only once, it goes directly to
+        // free instead of unfixed, and it is the next one to be reused
+        DBG(<< "Unfixed segment " << segment <<  " from slot " << i);
+        status[i] = SLOT_FREE;
+        freeSlots.push_back(i);
+        ioCond.notify_one();
+        return;
     }
 
     // Segment not found -- error!
@@ -190,127 +204,133 @@ void BackupPrefetcher::unfix(unsigned segment)
             << "Attempt to unfix segment which was not fixed: " << segment);
 }
 
-void BackupPrefetcher::run()
+bool BackupPrefetcher::nextRead(std::unique_lock<std::mutex>& lock,
+        unsigned& segment, size_t& slotIdx)
 {
-    bool wait = false;
     while (true) {
-        size_t slotIdx = 0;
-        char* readSlot = NULL;
-        unsigned next = numSegments; // invalid value
-        PageID firstPage;
-
-        if (wait) {
-            usleep(WAIT_TIME);
-            wait = false;
-        }
+        if (shutdownFlag) { return false; }
 
-        {
-            CRITICAL_SECTION(cs, &mutex);
+        if (requests.empty()) {
+            ioCond.wait(lock);
+            continue;
+        }
 
-            if (shutdownFlag) { return; }
+        std::set<Request>::iterator next = requests.begin();
+        segment = next->segment;
+        int priority = next->priority;
 
-            if (requests.size() == 0) {
-                wait = true;
-                continue;
-            }
-
-            next = requests.front();
+        PageID firstPage = PageID(segment * segmentSize);
+        if (firstPage >= volume->num_used_pages()
+                || findSlot(segment) < numSegments)
+        {
+            // prefetch request beyond end of volume or segment already in
+            // buffer (or being read) -- ignore
+            requested.erase(segment);
+            requests.erase(next);
+            continue;
+        }
 
-            firstPage = PageID(next * segmentSize);
-            if (firstPage >= volume->num_used_pages()) {
-                // prefetch request beyond end of volume -- ignore
-                requests.pop_front();
+        if (freeSlots.empty()) {
+            if (priority < FIX_PRIORITY) {
+                // We're not in a hurry, so let's not evict prematurely
+                ioCond.wait(lock);
                 continue;
             }
 
-            bool alreadyFetched = false;
-            // look if segment is already in buffer
+            // A fix is waiting and the buffer is full -- must evict.
+            // Do one round and wait if no segment can be evicted
+            size_t victim = numSegments;
             for (size_t i = 0; i < numSegments; i++) {
-                if (slots[i] == (int) next && status[i] != SLOT_FREE) {
-                    alreadyFetched = true;
-                    requests.pop_front();
-                    break;
-                }
-            }
-            if (alreadyFetched) { continue; }
+                if (lastEvicted == 0) { lastEvicted = numSegments - 1; }
+                else { lastEvicted--; }
 
-            bool freeFound = false;
-            // segment not in buffer, look for a free slot for reading into
-            for (size_t i = 0; i < numSegments; i++) {
-                if (status[i] == SLOT_FREE) {
-                    slotIdx = i;
-                    freeFound = true;
+                if (status[lastEvicted] == SLOT_UNFIXED) {
+                    victim = lastEvicted;
                     break;
                 }
             }
 
-            if (!freeFound) {
-                if (!fixWaiting) {
-                    // We're not in a hurry, so let's not evict prematurely
-                    wait = true;
-                    continue;
-                }
-
-                // A fix is waiting and the buffer is full -- must evict.
-                // Do one round and start over if no segment can be evicted
-                size_t start = lastEvicted;
-                do {
-                    if (lastEvicted == 0) { lastEvicted = numSegments - 1; }
-                    else { lastEvicted--; }
-
-                    if (lastEvicted == start) {
-                        // no evictable segments found -- wait some more
-                        wait = true;
-                        INC_TSTAT(backup_eviction_stuck);
-                        break;
-                    }
-                } while (status[lastEvicted] == SLOT_FIXED ||
-                        status[lastEvicted] == SLOT_READING);
-
-                if (wait) { continue; }
-
-                DBG(<< "Evicted " << slots[lastEvicted]);
-                requests.push_front(slots[lastEvicted]);
-                slotIdx = lastEvicted;
-                INC_TSTAT(backup_evict_segment);
+            if (victim == numSegments) {
+                // no evictable segments found -- wait some more
+                INC_TSTAT(backup_eviction_stuck);
+                ioCond.wait(lock);
+                continue;
             }
 
-            // Found a slot to read into!
-            slots[slotIdx] = next;
-            status[slotIdx] = SLOT_READING;
-            readSlot = buffer + (slotIdx * segmentSizeBytes);
+            DBG(<< "Evicted " << slots[victim]);
+            status[victim] = SLOT_FREE;
+            freeSlots.push_back(victim);
+            addRequest(slots[victim], slotPriority[victim]);
+            INC_TSTAT(backup_evict_segment);
+        }
 
-            w_assert0(readSlot);
-            requests.pop_front();
+        // Found a slot to read into!
+        requested.erase(segment);
+        requests.erase(next);
 
-        } // end of critical section
+        slotIdx = freeSlots.back();
+        freeSlots.pop_back();
+        slots[slotIdx] = segment;
+        status[slotIdx] = SLOT_READING;
+        slotPriority[slotIdx] = priority;
+        return true;
+    }
+}
 
-        DBG(<< "Prefetching segment " << next);
-        // perform the read into the slot found
-        firstPage = PageID(next * segmentSize);
-        if (firstPage >= volume->num_used_pages()) {
-            return;
+void BackupPrefetcher::ioLoop()
+{
+    while (true) {
+        unsigned next;
+        size_t slotIdx;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!nextRead(lock, next, slotIdx)) { return; }
         }
 
+        DBG(<< "Prefetching segment " << next);
+        // perform the read into the slot found
+        char* readSlot = buffer + (slotIdx * segmentSizeBytes);
         INC_TSTAT(restore_backup_reads);
-        W_COERCE(volume->read_backup(firstPage, segmentSize, readSlot));
+        W_COERCE(volume->read_backup(PageID(next * segmentSize), segmentSize,
+                    readSlot));
 
         {
             // Re-acquire mutex to mark slot as read, i.e., unfixed
-            CRITICAL_SECTION(cs, &mutex);
+            std::lock_guard<std::mutex> lock(mutex);
             status[slotIdx] = SLOT_UNFIXED;
             DBG(<< "Read segment " << next << " into  slot " << slotIdx);
         }
 
-        DBG(<< "Segment " << next << " read finished");
+        // wake up a waiting fix, and an I/O thread waiting to evict
+        fixCond.notify_all();
+        ioCond.notify_one();
+    }
+}
+
+void BackupPrefetcher::run()
+{
+    for (size_t i = 1; i < numIOs; i++) {
+        IOThread* t = new IOThread(this);
+        t->fork();
+        ioThreads.push_back(t);
+    }
+
+    ioLoop();
+
+    for (size_t i = 0; i < ioThreads.size(); i++) {
+        ioThreads[i]->join();
+        delete ioThreads[i];
     }
+    ioThreads.clear();
 }
 
 void BackupPrefetcher::finish()
 {
     {
-        CRITICAL_SECTION(cs, &mutex);
+        std::lock_guard<std::mutex> lock(mutex);
         shutdownFlag = true;
     }
+    ioCond.notify_all();
+    fixCond.notify_all();
     join();
 }
@@ -4,7 +4,12 @@
 #include "sm_base.h"
 #include "generic_page.h"
 
-#include <deque>
+#include <climits>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
 
 class vol_t;
 
@@ -135,16 +140,27 @@ public:
  * of segments.  Similar to a buffer pool, one of the slots is always "fixed"
  * as the one being currently used as the restore workspace.
  *
+ * Reads are issued by numIOs I/O threads (the prefetcher thread itself plus
+ * numIOs - 1 helpers), so that several segment reads are outstanding on the
+ * backup device at any time, which is required to exploit the internal
+ * parallelism of SSDs. Each I/O thread takes the pending request with the
+ * highest priority (FIFO among equal priorities), so that on-demand requests
+ * overtake the reads of a single-pass schedule. A slot released by unfix()
+ * is handed to the next read immediately (LIFO), instead of being found by
+ * polling.
+ *
  * \author Caetano Sauer
  */
 class BackupPrefetcher : public smthread_t, public BackupReader {
 public:
-    BackupPrefetcher(vol_t* volume, size_t numSegments, size_t segmentSize);
+    BackupPrefetcher(vol_t* volume, size_t numSegments, size_t segmentSize,
+            size_t numIOs = 1);
     virtual ~BackupPrefetcher();
 
     /**
-     * Default priority is zero, which makes request go to end of FIFO queue.
-     * Any value larger than zero pushes it to the front of the queue.
+     * Requests are served in descending order of priority. If the segment
+     * was already requested with a lower priority, its priority is raised.
+     * Priorities must be lower than FIX_PRIORITY.
      */
     virtual void prefetch(unsigned segment, int priority = 0);
     virtual char* fix(unsigned segment);
@@ -154,6 +170,23 @@ public:
     virtual void finish();
 
 private:
+    class IOThread;
+
+    /** Loop executed by each I/O thread until shutdown */
+    void ioLoop();
+
+    /** Pick the next request and a slot for it, evicting only for requests
+     * of a waiting fix; returns false on shutdown. Caller must hold the
+     * mutex. */
+    bool nextRead(std::unique_lock<std::mutex>& lock, unsigned& segment,
+            size_t& slotIdx);
+
+    /** Find the slot holding a segment; returns numSegments if not found */
+    size_t findSlot(unsigned segment);
+
+    /** Add or reprioritize a request. Caller must hold the mutex. */
+    void addRequest(unsigned segment, int priority);
+
     vol_t* volume;
 
     /** Number of segments to hold in buffer */
@@ -165,27 +198,67 @@ private:
     /** Size of a segment in Bytes **/
     size_t segmentSizeBytes;
 
+    /** Maximum number of reads in flight */
+    size_t numIOs;
+
+    /** Helper I/O threads (numIOs - 1) */
+    std::vector<IOThread*> ioThreads;
+
     /** Array to keep track of fetched segments. */
     int* slots;
 
     /** Array to keep track of /free status of each segment */
     int* status;
 
-    /** True if a fix didn't find the segment -- prefetcher should hurry */
-    bool fixWaiting;
+    /** Priority with which the segment in each slot was requested */
+    int* slotPriority;
+
+    /** Free slots, most recently released at the back */
+    std::vector<size_t> freeSlots;
 
     /** Tells prefetcher thread to exit */
     bool shutdownFlag;
 
+    /** A pending request, ordered by descending priority and then by
+     * arrival */
+    struct Request {
+        int priority;
+        uint64_t seq;
+        unsigned segment;
+
+        bool operator<(const Request& other) const
+        {
+            if (priority != other.priority) {
+                return priority > other.priority;
+            }
+            return seq < other.seq;
+        }
+    };
+
     /** Queue of received requests */
-    std::deque<unsigned> requests;
+    std::set<Request> requests;
+
+    /** Pending requests by segment, to avoid duplicates */
+    std::map<unsigned, std::set<Request>::iterator> requested;
+
+    /** Arrival counter of requests */
+    uint64_t requestSeq;
 
     /** Mutex to protect access to request queue and slot array */
-    pthread_mutex_t mutex;
+    std::mutex mutex;
+
+    /** Signals I/O threads of new requests, free slots and shutdown */
+    std::condition_variable ioCond;
+
+    /** Signals fix() of finished reads */
+    std::condition_variable fixCond;
 
     /** Keep track of last evicted slot */
     size_t lastEvicted;
 
+    /** Priority of a segment requested by fix() -- may cause eviction */
+    static const int FIX_PRIORITY = INT_MAX;
+
     static const int SLOT_FREE = 0;
     static const int SLOT_READING = 1;
     static const int SLOT_UNFIXED = 2;
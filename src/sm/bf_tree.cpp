@@ -56,6 +56,8 @@ bf_tree_m::bf_tree_m(const sm_options& options)
 
     bool bufferpool_swizzle =
         options.get_bool_option("sm_bufferpool_swizzle", false);
+    bool bufferpool_optimistic_reads =
+        options.get_bool_option("sm_bufferpool_optimistic_reads", true);
     // clock or random
     std::string replacement_policy =
         options.get_string_option("sm_bufferpool_replacement_policy", "clock");
@@ -64,6 +66,8 @@ bf_tree_m::bf_tree_m(const sm_options& options)
 
     _block_cnt = nbufpages;
     _enable_swizzling = bufferpool_swizzle;
+    // optimistic reads follow swizzled pointers only
+    _enable_optimistic_reads = bufferpool_swizzle && bufferpool_optimistic_reads;
     // if (strcmp(replacement_policy.c_str(), "clock") == 0) {
     //     _replacement_policy = POLICY_CLOCK;
     // } else if (strcmp(replacement_policy.c_str(), "clock+priority") == 0) {
@@ -151,6 +155,7 @@ bf_tree_m::bf_tree_m(const sm_options& options)
     DO_PTHREAD(pthread_mutex_init(&_eviction_lock, NULL));
 
     _cleaner_decoupled = options.get_bool_option("sm_cleaner_decoupled", false);
+    _decoupled_clean_lsn = lsn_t::null;
 }
 
 void bf_tree_m::shutdown()
@@ -235,6 +240,7 @@ w_rc_t bf_tree_m::fix(generic_page* parent, generic_page*& page,
                                    bool conditional, bool virgin_page,
                                    lsn_t emlsn)
 {
+    uint64_t fix_start = LATENCY_START();
     if (is_swizzled_pointer(pid)) {
         w_assert1(!virgin_page);
 
@@ -257,6 +263,7 @@ w_rc_t bf_tree_m::fix(generic_page* parent, generic_page*& page,
 
         page = &(_buffer[idx]);
 
+        RECORD_TLATENCY(fix_hit, fix_start);
         return RCOK;
     }
 
@@ -343,6 +350,7 @@ w_rc_t bf_tree_m::fix(generic_page* parent, generic_page*& page,
             w_assert1(cb.latch().held_by_me());
             w_assert1(cb._pin_cnt > 0);
             DBG(<< "Fixed page " << pid << " (miss) to frame " << idx);
+            RECORD_TLATENCY(fix_miss, fix_start);
 
             if (mode != LATCH_EX) {
                 w_assert1(mode == LATCH_SH);
@@ -378,6 +386,7 @@ w_rc_t bf_tree_m::fix(generic_page* parent, generic_page*& page,
             w_assert1(cb.latch().held_by_me());
             DBG(<< "Fixed page " << pid << " (hit) to frame " << idx);
             w_assert1(cb._pin_cnt > 0);
+            RECORD_TLATENCY(fix_hit, fix_start);
         }
 
         if (!is_swizzled(page) && _enable_swizzling && parent) {
@@ -396,10 +405,11 @@ w_rc_t bf_tree_m::fix(generic_page* parent, generic_page*& page,
             // Either a virgin page which hasn't been linked yet, or some other
             // thread won the race and already swizzled the pointer
             if (slot == GeneralRecordIds::INVALID) { return RCOK; }
-            // Not worth swizzling foster children, since they will soon be
-            // adopted (an thus unswizzled)
-            if (slot == GeneralRecordIds::FOSTER_CHILD) { return RCOK; }
-            w_assert1(slot > GeneralRecordIds::FOSTER_CHILD);
+            // Foster pointers are swizzled too, so that scans and splits
+            // following a foster chain skip the hash table. The pointer is
+            // unswizzled again on adoption (see
+            // btree_impl::_ux_adopt_foster_core).
+            w_assert1(slot >= GeneralRecordIds::FOSTER_CHILD);
             w_assert1(slot <= p.max_child_slot());
 
             // Update _swizzled flag atomically
@@ -609,8 +619,12 @@ bool bf_tree_m::unswizzle(generic_page* parent, general_recordid_t child_slot, b
         // Parent is updated without requiring EX latch. This is correct as
         // long as fix call can deal with swizzled pointers not being really
         // swizzled.
-        w_assert1(child_cb.latch().held_by_me());
-        w_assert1(child_cb.latch().mode() == LATCH_EX);
+        // A foster child is only reachable through its foster parent, so
+        // the EX latch on the latter is enough to exclude swizzlers.
+        w_assert1(child_slot == GeneralRecordIds::FOSTER_CHILD
+                || child_cb.latch().held_by_me());
+        w_assert1(child_slot == GeneralRecordIds::FOSTER_CHILD
+                || child_cb.latch().mode() == LATCH_EX);
         w_assert1(parent_cb.latch().held_by_me());
         w_assert1(parent_cb.latch().mode() == LATCH_EX);
         child_cb._swizzled = false;
@@ -645,7 +659,7 @@ void bf_tree_m::debug_dump(std::ostream &o) const
         bf_tree_cb_t &cb = get_cb(idx);
         if (cb._used) {
             o << "page-" << cb._pid;
-            if (cb.is_dirty()) {
+            if (_is_dirty(cb)) {
                 o << " (dirty)";
             }
             o << ", _swizzled=" << cb._swizzled;
@@ -803,6 +817,47 @@ w_rc_t bf_tree_m::refix_direct (generic_page*& page, bf_idx
     return RCOK;
 }
 
+bool bf_tree_m::optimistic_read_begin(bf_idx idx, uint32_t& version) const
+{
+    if (!_is_valid_idx(idx)) { return false; }
+    bf_tree_cb_t &cb = get_cb(idx);
+    // version must be read before checking the latch: a writer bumps the
+    // version before releasing its EX latch
+    version = cb._version.load();
+    return cb._used && cb.latch().mode() != LATCH_EX;
+}
+
+bool bf_tree_m::optimistic_read_validate(bf_idx idx, uint32_t version) const
+{
+    bf_tree_cb_t &cb = get_cb(idx);
+    // page reads must not be reordered after the validation
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return cb.latch().mode() != LATCH_EX && cb._version.load() == version;
+}
+
+w_rc_t bf_tree_m::fix_optimistic(generic_page*& page, bf_idx idx,
+        uint32_t version, latch_mode_t mode)
+{
+    w_assert1(_is_valid_idx(idx));
+    bf_tree_cb_t &cb = get_cb(idx);
+    W_DO(cb.latch().latch_acquire(mode, sthread_t::WAIT_FOREVER));
+    if (cb._version.load() != version || !cb._used || !cb._swizzled
+            || cb._pin_cnt < 0)
+    {
+        // Frame was modified or even reused since the optimistic read
+        cb.latch().latch_release();
+        return RC(eLATCHQFAIL);
+    }
+
+    cb.pin();
+    cb.inc_ref_count();
+    if (mode == LATCH_EX) {
+        cb.inc_ref_count_ex();
+    }
+    page = &(_buffer[idx]);
+    return RCOK;
+}
+
 w_rc_t bf_tree_m::fix_nonroot(generic_page*& page, generic_page *parent,
                                      PageID pid, latch_mode_t mode, bool conditional,
                                      bool virgin_page, lsn_t emlsn)
@@ -882,20 +937,38 @@ void bf_tree_m::unfix(const generic_page* p, bool evict)
         w_assert1(cb._pin_cnt >= 0);
     }
     DBG(<< "Unfixed " << idx << " pin count " << cb._pin_cnt);
+    if (cb.latch().mode() == LATCH_EX) { cb.bump_version(); }
     cb.latch().latch_release();
 }
 
 bool bf_tree_m::is_dirty(const generic_page* p) const {
     uint32_t idx = p - _buffer;
     w_assert1 (_is_active_idx(idx));
-    return get_cb(idx).is_dirty();
+    return _is_dirty(get_cb(idx));
 }
 
 bool bf_tree_m::is_dirty(const bf_idx idx) const {
     // Caller has latch on page
     // Used by REDO phase in Recovery
     w_assert1 (_is_active_idx(idx));
-    return get_cb(idx).is_dirty();
+    return _is_dirty(get_cb(idx));
+}
+
+bool bf_tree_m::_is_dirty(const bf_tree_cb_t& cb) const {
+    if (!cb.is_dirty()) {
+        return false;
+    }
+    // With the decoupled cleaner, every update below its clean LSN has
+    // already been replayed from the log archive and written to the volume
+    return !_cleaner_decoupled || cb.get_page_lsn() >= _decoupled_clean_lsn;
+}
+
+void bf_tree_m::set_decoupled_clean_lsn(lsn_t lsn) {
+    w_assert1(_cleaner_decoupled);
+    if (lsn > _decoupled_clean_lsn) {
+        _decoupled_clean_lsn = lsn;
+        lintel::atomic_thread_fence(lintel::memory_order_release);
+    }
 }
 
 bool bf_tree_m::is_used (bf_idx idx) const {
@@ -910,9 +983,35 @@ void bf_tree_m::set_page_lsn(generic_page* p, lsn_t lsn)
     w_assert1(cb.latch().held_by_me());
     w_assert1(cb.latch().mode() == LATCH_EX);
     w_assert1(cb.get_page_lsn() < lsn);
+    if (!_is_dirty(cb)) {
+        // first update since page was last cleaned
+        cb._rec_lsn = lsn;
+    }
     cb.set_page_lsn(lsn);
 }
 
+bool bf_tree_m::get_rec_lsn(bf_idx idx, PageID& pid, lsn_t& page_lsn,
+        lsn_t& rec_lsn) const
+{
+    w_assert1(_is_valid_idx(idx));
+    bf_tree_cb_t& cb = get_cb(idx);
+    if (!cb._used || !_is_dirty(cb)) {
+        return false;
+    }
+
+    pid = cb._pid;
+    page_lsn = cb.get_page_lsn();
+    rec_lsn = cb.get_rec_lsn();
+    if (rec_lsn.is_null() || rec_lsn > page_lsn) {
+        // frame reused or rec_lsn not set yet (e.g., dirtied by redo)
+        rec_lsn = cb.get_clean_lsn().is_null() ? page_lsn : cb.get_clean_lsn();
+    }
+    if (_cleaner_decoupled && rec_lsn < _decoupled_clean_lsn) {
+        rec_lsn = _decoupled_clean_lsn;
+    }
+    return true;
+}
+
 lsn_t bf_tree_m::get_page_lsn(generic_page* p)
 {
     uint32_t idx = p - _buffer;
@@ -931,6 +1030,7 @@ void bf_tree_m::downgrade_latch(const generic_page* p) {
     w_assert1 (_is_active_idx(idx));
     bf_tree_cb_t &cb = get_cb(idx);
     w_assert1(cb.latch().held_by_me());
+    cb.bump_version();
     cb.latch().downgrade();
 }
 
@@ -197,6 +197,36 @@ public:
      */
     w_rc_t refix_direct (generic_page*& page, bf_idx idx, latch_mode_t mode, bool conditional);
 
+    /**
+     * Starts an optimistic (OLFIT-style) read of the given frame, i.e., a
+     * read without any latch. Returns the current version of the frame, which
+     * must be passed to optimistic_read_validate() once the caller is done
+     * reading. Returns false if the frame is EX-latched or unused, in which
+     * case the caller must fall back to latching.
+     * The frame contents may change at any time during an optimistic read, so
+     * nothing read from it may be trusted before validation succeeds.
+     */
+    bool optimistic_read_begin(bf_idx idx, uint32_t& version) const;
+
+    /**
+     * Returns whether the frame was left untouched since the given version
+     * was obtained by optimistic_read_begin().
+     */
+    bool optimistic_read_validate(bf_idx idx, uint32_t version) const;
+
+    /**
+     * Latches a frame that was read optimistically, upgrading the read to a
+     * regular fix. The frame must have been reached through a swizzled
+     * pointer or the root-page array, which keeps it from being evicted while
+     * the version is unchanged. Returns eLATCHQFAIL without
+     * holding any latch if the frame changed since the given version.
+     */
+    w_rc_t fix_optimistic (generic_page*& page, bf_idx idx, uint32_t version,
+                           latch_mode_t mode);
+
+    /** returns whether B-tree traversals may use optimistic reads. */
+    bool is_optimistic_reads_enabled() const { return _enable_optimistic_reads; }
+
     /**
      * Fixes an existing (not virgin) root page for the given store.
      * This method doesn't receive page ID because it's already known by bufferpool.
@@ -236,6 +266,15 @@ public:
 
     bf_idx lookup(PageID pid) const;
 
+    /**
+     * Called by the decoupled cleaner (see page_cleaner_decoupled) once all
+     * updates archived up to the given LSN have been propagated to the
+     * volume. Any frame whose page LSN is below this value is clean, even
+     * though its control block was never touched by the cleaner.
+     */
+    void set_decoupled_clean_lsn(lsn_t lsn);
+    lsn_t get_decoupled_clean_lsn() const { return _decoupled_clean_lsn; }
+
     /**
      * Returns true if the page's _used flag is on
      */
@@ -248,6 +287,16 @@ public:
     void set_page_lsn(generic_page*, lsn_t);
     lsn_t get_page_lsn(generic_page*);
 
+    /**
+     * Fuzzy read of the recovery information of a frame, used by checkpoints
+     * to build the dirty page table without a log scan. No latch is acquired,
+     * so the values are only approximate for pages updated concurrently;
+     * those updates are covered by the log after the chkpt_begin record.
+     * Returns false if the frame is unused or clean.
+     */
+    bool get_rec_lsn(bf_idx idx, PageID& pid, lsn_t& page_lsn,
+            lsn_t& rec_lsn) const;
+
     /**
      * Whenever the parent of a page is changed (adoption or de-adoption),
      * this method must be called to switch it in bufferpool.
@@ -402,6 +451,12 @@ private:
     /** Adds a free block to the freelist. */
     void   _add_free_block(bf_idx idx);
 
+    /**
+     * Dirty check on a control block which also takes into account the
+     * clean LSN reported by the decoupled cleaner.
+     */
+    bool   _is_dirty (const bf_tree_cb_t& cb) const;
+
     /// returns true iff idx is in the valid range.  for assertion.
     bool   _is_valid_idx (bf_idx idx) const;
 
@@ -486,7 +541,16 @@ private:
     /** whether to swizzle non-root pages. */
     bool                 _enable_swizzling;
 
+    /** whether B-tree traversals may read interior pages without latching. */
+    bool                 _enable_optimistic_reads;
+
     bool _cleaner_decoupled;
+
+    /**
+     * LSN up to which the decoupled cleaner has replayed the log archive
+     * into the volume. Written only by the cleaner thread.
+     */
+    lsn_t _decoupled_clean_lsn;
 };
 
 /**
@@ -84,6 +84,9 @@ struct bf_tree_cb_t {
 
     /** clears all properties but latch. */
     inline void clear_except_latch () {
+        // the version survives, so that optimistic readers holding a
+        // version of the previous page in this frame fail validation
+        uint32_t version = _version.load();
 #ifdef BP_ALTERNATE_CB_LATCH
         signed char latch_offset = _latch_offset;
         ::memset(this, 0, sizeof(bf_tree_cb_t));
@@ -91,6 +94,7 @@ struct bf_tree_cb_t {
 #else
         ::memset(this, 0, sizeof(bf_tree_cb_t)-sizeof(latch_t));
 #endif
+        _version = version + 1;
     }
 
     /** Initializes all fields -- called by fix when fetching a new page */
@@ -105,6 +109,7 @@ struct bf_tree_cb_t {
         _ref_count_ex = BP_INITIAL_REFCOUNT;
         _clean_lsn = page_lsn;
         _page_lsn = page_lsn;
+        _rec_lsn = lsn_t::null;
     }
 
     /** clears latch */
@@ -158,14 +163,32 @@ struct bf_tree_cb_t {
 
     bool is_dirty() const { return _page_lsn > _clean_lsn; }
 
+    // CS: LSN of the first update since the page was last cleaned, i.e.,
+    // the recovery LSN used by checkpoints. Only meaningful if dirty.
+    lsn_t _rec_lsn; // +8 -> 40
+    lsn_t get_rec_lsn() const { return _rec_lsn; }
+
 
     /**
      * number of swizzled pointers to children; protected by ??
      */
-    uint16_t                    _swizzled_ptr_cnt_hint; // +2 -> 34
+    uint16_t                    _swizzled_ptr_cnt_hint; // +2 -> 42
+
+    /// Filler
+    uint16_t _fill44;        // +2 -> 44
+
+    /**
+     * Version counter for optimistic (OLFIT) reads. Incremented every time
+     * an EX latch on this frame is released or downgraded, i.e., after
+     * every modification of the page, and whenever the frame is cleared.
+     * A reader that observes the same version and no EX holder before and
+     * after reading the page without a latch has read a consistent image.
+     * See bf_tree_m::optimistic_read_begin().
+     */
+    std::atomic<uint32_t> _version; // +4 -> 48
 
     // Add padding to align control block at cacheline boundary (64 bytes)
-    uint8_t _fill63[29];    // +29 -> 63
+    uint8_t _fill63[15];    // +15 -> 63
 
 #ifdef BP_ALTERNATE_CB_LATCH
     /** offset to the latch to protect this page. */
@@ -187,6 +210,12 @@ struct bf_tree_cb_t {
         lintel::unsafe::atomic_fetch_sub(&_pin_cnt, 1);
     }
 
+    /// invalidate concurrent optimistic readers; call before releasing EX
+    void bump_version()
+    {
+        _version.fetch_add(1);
+    }
+
     void inc_ref_count()
     {
         if (_ref_count < BP_MAX_REFCOUNT) {
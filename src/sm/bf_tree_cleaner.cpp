@@ -15,6 +15,7 @@
 #include "sm.h"
 #include "stopwatch.h"
 #include "xct.h"
+#include "ghost_reclaimer.h"
 #include <vector>
 
 class candidate_collector_thread : public worker_thread_t
@@ -224,6 +225,11 @@ bool bf_tree_cleaner::latch_and_copy(PageID pid, bf_idx idx, size_t wpos)
     _workspace[wpos].checksum = _workspace[wpos].calculate_checksum();
     _workspace_cb_indexes[wpos] = idx;
 
+    // dirty leaves are where deletes leave their ghosts behind
+    if (smlevel_0::reclaimer) {
+        smlevel_0::reclaimer->check_page(&pdest, idx);
+    }
+
     return true;
 }
 
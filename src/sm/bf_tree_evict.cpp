@@ -1,6 +1,7 @@
 #include "bf_tree_cb.h"
 #include "bf_tree.h"
 #include "btree_page_h.h"
+#include "eventtrace.h"
 
 #include "bf_hashtable.cpp"
 
@@ -158,13 +159,13 @@ w_rc_t bf_tree_m::evict_blocks(uint32_t& evicted_count,
         // now we hold an EX latch -- check if leaf and not dirty
         btree_page_h p;
         p.fix_nonbufferpool_page(_buffer + idx);
-        if (p.tag() != t_btree_p || !p.is_leaf() || cb.is_dirty()
+        if (p.tag() != t_btree_p || !p.is_leaf() || _is_dirty(cb)
                 || !cb._used || p.pid() == p.root())
         {
             cb.latch().latch_release();
             DBG5(<< "Eviction failed on flags for " << idx);
             if (!p.is_leaf()) { nonleaf_count++; }
-            if (cb.is_dirty()) { dirty_count++; }
+            if (_is_dirty(cb)) { dirty_count++; }
             idx++;
             continue;
         }
@@ -180,6 +181,15 @@ w_rc_t bf_tree_m::evict_blocks(uint32_t& evicted_count,
             continue;
         }
 
+        // a foster parent holding a swizzled pointer must stay, otherwise
+        // its foster child could not be unswizzled when evicted itself
+        if (is_swizzled_pointer(p.get_foster_opaqueptr())) {
+            cb.latch().latch_release();
+            DBG3(<< "Eviction failed on swizzled foster child for " << idx);
+            idx++;
+            continue;
+        }
+
         // Step 2: latch parent in SH mode
         generic_page *page = &_buffer[idx];
         PageID pid = page->pid;
@@ -291,10 +301,12 @@ w_rc_t bf_tree_m::evict_blocks(uint32_t& evicted_count,
         idx++;
         evicted_count++;
 
+        parent_cb.bump_version();
         parent_cb.latch().latch_release();
         cb.latch().latch_release();
 
         INC_TSTAT(bf_evict);
+        event_tracer::trace(trace_event_t::page_evict, pid);
     }
 
     _eviction_current_frame = idx;
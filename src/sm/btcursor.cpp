@@ -17,6 +17,8 @@
 #include "xct.h"
 #include "lock.h"
 #include "sm.h"
+#include "version_store.h"
+#include "btree_partition.h"
 
 bt_cursor_t::bt_cursor_t(StoreID store, bool forward)
 {
@@ -75,10 +77,33 @@ void bt_cursor_t::_init(
 
     _needs_lock = g_xct_does_need_lock();
     _ex_lock = g_xct_does_ex_lock_for_select();
+
+    // partition cursors read snapshots on their own
+    xct_t* x = g_xct();
+    _snapshot = x && x->is_snapshot_xct() && smlevel_0::versions
+        && !partition_table_t::is_partitioned(store);
+    _snapshot_ts = _snapshot ? x->get_snapshot() : 0;
+    _cur_pending = false;
+    _cur_eof = false;
+    _snap_started = false;
+    _snap_eof = false;
+    _parts_ordered = false;
+    _part_cur = -1;
 }
 
 
 void bt_cursor_t::close()
+{
+    _snap_eof = true;
+    _close_current();
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        delete _parts[i];
+    }
+    _parts.clear();
+    _part_cur = -1;
+}
+
+void bt_cursor_t::_close_current()
 {
     _eof = true;
     _first_time = false;
@@ -256,7 +281,151 @@ w_rc_t bt_cursor_t::_refix_current_key(btree_page_h &p) {
 
 rc_t bt_cursor_t::next()
 {
-    if (!is_valid()) {
+    if (partition_table_t::is_partitioned(_store)) {
+        return _next_partitioned();
+    }
+    if (_snapshot) {
+        return _next_snapshot();
+    }
+    return _next_current();
+}
+
+rc_t bt_cursor_t::_next_snapshot()
+{
+    if (_snap_eof) {
+        return RCOK;
+    }
+
+    while (true) {
+        // Read ahead one record of the current state. This must happen before
+        // checking versions of its key, since versions are saved before the
+        // B-tree is modified.
+        if (!_cur_pending && !_cur_eof) {
+            W_DO(_next_current());
+            if (_eof) {
+                _cur_eof = true;
+            }
+            else {
+                _cur_pending = true;
+                _cur_key = _key;
+                _cur_el.assign(_elbuf, _elen);
+            }
+        }
+
+        // First key after the last one returned whose visible state differs
+        // from its current state
+        const w_keystr_t& from = _snap_started ? _snap_key
+            : (_forward ? _lower : _upper);
+        bool from_inclusive = !_snap_started
+            && (_forward ? _lower_inclusive : _upper_inclusive);
+        w_keystr_t vkey;
+        bool exists = false;
+        std::string vel;
+        bool versioned = versions->next(_store, from, from_inclusive,
+                _forward ? _upper : _lower,
+                _forward ? _upper_inclusive : _lower_inclusive,
+                _forward, _snapshot_ts, vkey, exists, vel);
+
+        if (!versioned && !_cur_pending) {
+            _snap_eof = true;
+            _snap_key.clear();
+            _snap_el.clear();
+            return RCOK;
+        }
+
+        int cmp = 0;
+        if (versioned && _cur_pending) {
+            cmp = vkey.compare(_cur_key);
+            if (!_forward) { cmp = -cmp; }
+        }
+
+        _snap_started = true;
+        if (versioned && (!_cur_pending || cmp <= 0)) {
+            if (cmp == 0) {
+                // read-ahead record is replaced by its visible state
+                _cur_pending = false;
+            }
+            _snap_key = vkey;
+            if (!exists) {
+                continue;
+            }
+            _snap_el = vel;
+            INC_TSTAT(snapshot_versions_applied);
+        }
+        else {
+            _cur_pending = false;
+            _snap_key = _cur_key;
+            _snap_el = _cur_el;
+        }
+        return RCOK;
+    }
+}
+
+rc_t bt_cursor_t::_open_partitions()
+{
+    const partitioning_t* map;
+    W_DO(partitions->get(_store, map));
+    _parts_ordered = map->kind == partitioning_t::t_range;
+    size_t count = map->stores.size();
+    for (size_t n = 0; n < count; ++n) {
+        size_t i = (_forward || !_parts_ordered) ? n : count - 1 - n;
+        if (map->overlaps(i, _lower, _upper)) {
+            _parts.push_back(new bt_cursor_t(map->stores[i],
+                _lower, _lower_inclusive, _upper, _upper_inclusive, _forward));
+        }
+    }
+    return RCOK;
+}
+
+rc_t bt_cursor_t::_next_partitioned()
+{
+    if (_first_time) {
+        _first_time = false;
+        W_DO(_open_partitions());
+        if (_parts.empty()) {
+            _eof = true;
+            return RCOK;
+        }
+        size_t ahead = _parts_ordered ? 1 : _parts.size();
+        for (size_t i = 0; i < ahead; ++i) {
+            W_DO(_parts[i]->next());
+        }
+        _part_cur = 0;
+    }
+    else if (_part_cur < 0 || _parts[_part_cur]->eof()) {
+        return RCOK; // EOF
+    }
+    else {
+        W_DO(_parts[_part_cur]->next());
+    }
+
+    if (_parts_ordered) {
+        while (_parts[_part_cur]->eof() && _part_cur + 1 < (int) _parts.size()) {
+            W_DO(_parts[++_part_cur]->next());
+        }
+        return RCOK;
+    }
+
+    // the next record is the first in scan order among those read ahead
+    for (int i = 0; i < (int) _parts.size(); ++i) {
+        if (_parts[i]->eof() || i == _part_cur) {
+            continue;
+        }
+        if (_parts[_part_cur]->eof()) {
+            _part_cur = i;
+            continue;
+        }
+        int cmp = _parts[i]->key().compare(_parts[_part_cur]->key());
+        if (_forward ? cmp < 0 : cmp > 0) {
+            _part_cur = i;
+        }
+    }
+    return RCOK;
+}
+
+rc_t bt_cursor_t::_next_current()
+{
+    if (!(_first_time || !_eof)) {
         return RCOK; // EOF
     }
 
@@ -281,7 +450,7 @@ rc_t bt_cursor_t::next()
     W_DO(_find_next(p, eof_ret));
 
     if (eof_ret) {
-        close();
+        _close_current();
         return RCOK;
     }
 
@@ -373,6 +542,12 @@ rc_t bt_cursor_t::_advance_one_slot(btree_page_h &p, bool &eof)
                     return RCOK;
                 }
             }
+            // If the right neighbor is the foster child of the current page,
+            // it can be reached through the foster pointer (which may be
+            // swizzled) rather than by a traversal from the root. The
+            // current page stays pinned by _pid_bfidx while unlatched below.
+            bool follow_foster = _forward && p.get_foster_opaqueptr() != 0;
+            lsn_t prelsn = p.get_page_lsn();
             p.unfix();
 
             // take lock for the fence key
@@ -391,7 +566,22 @@ rc_t bt_cursor_t::_advance_one_slot(btree_page_h &p, bool &eof)
             // TODO this part should check if we find an exact match of fence keys.
             // because we unlatch above, it's possible to not find exact match.
             // in that case, we should change the traverse_mode to fence_contains and continue
-            W_DO(btree_impl::_ux_traverse(_store, neighboring_fence, traverse_mode, LATCH_SH, p));
+            if (follow_foster) {
+                // foster link is still valid only if page was not modified
+                W_DO(p.refix_direct(_pid_bfidx.idx(), LATCH_SH));
+                if (p.get_page_lsn() == prelsn) {
+                    btree_page_h next;
+                    W_DO(next.fix_nonroot(p, p.get_foster_opaqueptr(), LATCH_SH));
+                    p = next;
+                }
+                else {
+                    p.unfix();
+                    follow_foster = false;
+                }
+            }
+            if (!follow_foster) {
+                W_DO(btree_impl::_ux_traverse(_store, neighboring_fence, traverse_mode, LATCH_SH, p));
+            }
             _slot = _forward ? 0 : p.nrecs() - 1;
             _set_current_page(p);
             continue;
@@ -9,6 +9,9 @@
 #include "w_key.h"
 #include "bf_tree.h"
 
+#include <string>
+#include <vector>
+
 class btree_page_h;
 
 
@@ -49,6 +52,21 @@ class btree_page_h;
  * These two events are expensive,
  * but happen only after the LSN check, so they are rare too.
  *
+ * \section Snapshot-Transactions
+ * In a snapshot transaction (see ss_m::begin_snapshot_xct), the cursor
+ * takes no locks. It reads one record of the current state ahead, and
+ * merges it with the keys whose state visible to the snapshot differs from
+ * the current one (see version_store_t), which covers keys updated, inserted
+ * or removed since the snapshot was taken.
+ *
+ * \section Partitioned-Indexes
+ * A cursor over a partitioned index (see partition_table_t) opens a cursor
+ * over each partition that may hold keys in the search range. Range
+ * partitions hold disjoint key ranges, so their cursors are simply read one
+ * after another in scan order. Hash partitions interleave their keys, so
+ * every partition cursor is kept one record ahead and the next record in
+ * scan order among them is returned.
+ *
  * \section Locking-and-Concurrency
  * A cursor object also takes locks on the keys and their
  * intervals it read. Here, the complication is that
@@ -111,19 +129,35 @@ public:
      */
     rc_t next();
 
-    bool          is_valid() const { return _first_time || !_eof; }
+    bool          is_valid() const {
+        if (_part_cur >= 0) { return _parts[_part_cur]->is_valid(); }
+        return _snapshot ? !_snap_eof : (_first_time || !_eof);
+    }
     bool          is_forward() const { return _forward; }
     void          close();
 
-    const w_keystr_t& key()     { return _key; }
+    const w_keystr_t& key()     {
+        if (_part_cur >= 0) { return _parts[_part_cur]->key(); }
+        return _snapshot ? _snap_key : _key;
+    }
     /**
      * Admittedly bad naming, but this means if the cursor still has record to return.
      * So, even if it's not quite the end of file or index, it returns true
      * when it exceeds the upper-condition.
      */
-    bool              eof()     { return _eof;  }
-    int               elen() const     { return _elen; }
-    char*             elem()     { return _eof ? 0 :  _elbuf; }
+    bool              eof()     {
+        if (_part_cur >= 0) { return _parts[_part_cur]->eof(); }
+        return _snapshot ? _snap_eof : _eof;
+    }
+    int               elen() const {
+        if (_part_cur >= 0) { return _parts[_part_cur]->elen(); }
+        return _snapshot ? (int) _snap_el.size() : _elen;
+    }
+    char*             elem() {
+        if (eof()) { return 0; }
+        if (_part_cur >= 0) { return _parts[_part_cur]->elem(); }
+        return _snapshot ? &_snap_el[0] : _elbuf;
+    }
 
 private:
     void        _init(
@@ -167,6 +201,21 @@ private:
     */
     rc_t         _make_rec(const btree_page_h& page);
 
+    /** Moves to the next record of the current state of the B-tree. */
+    rc_t         _next_current();
+
+    /** Ends the iteration over the current state of the B-tree. */
+    void         _close_current();
+
+    /** Moves to the next record visible to the snapshot transaction. */
+    rc_t         _next_snapshot();
+
+    /** Opens cursors over the partitions of a partitioned index. */
+    rc_t         _open_partitions();
+
+    /** Moves to the next record among the partitions of a partitioned index. */
+    rc_t         _next_partitioned();
+
     StoreID      _store;
     w_keystr_t  _lower;
     w_keystr_t  _upper;
@@ -206,6 +255,32 @@ private:
     smsize_t    _elen;
     /** buffer to store the current record (el). */
     char        _elbuf [SM_PAGESIZE];
+
+    /** whether this cursor reads for a snapshot transaction. */
+    bool        _snapshot;
+    /** snapshot of the transaction. */
+    uint64_t    _snapshot_ts;
+    /** whether a record of the current state was read ahead. */
+    bool        _cur_pending;
+    /** whether the current state has no more records. */
+    bool        _cur_eof;
+    /** record of the current state read ahead. */
+    w_keystr_t  _cur_key;
+    std::string _cur_el;
+    /** whether a record was returned (or skipped) by _next_snapshot. */
+    bool        _snap_started;
+    /** true if no element left for the snapshot. */
+    bool        _snap_eof;
+    /** record returned to a snapshot transaction. */
+    w_keystr_t  _snap_key;
+    std::string _snap_el;
+
+    /** cursors over the partitions of a partitioned index, in scan order for range partitions. */
+    std::vector<bt_cursor_t*> _parts;
+    /** whether _parts hold disjoint key ranges and are read one after another. */
+    bool        _parts_ordered;
+    /** index in _parts of the cursor on the current record, -1 if none. */
+    int         _part_cur;
 };
 
 #endif//BTCURSOR_H
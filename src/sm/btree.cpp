@@ -13,6 +13,7 @@
 #include "btree_page_h.h"
 #include "btree_impl.h"
 #include "btcursor.h"
+#include "btree_overflow.h"
 #include "w_key.h"
 #include "xct.h"
 #include "vec_t.h"
@@ -118,6 +119,13 @@ rc_t btree_m::remove(StoreID store, const w_keystr_t &key)
     return RCOK;
 }
 
+rc_t btree_m::remove_range(StoreID store, const w_keystr_t &low,
+        const w_keystr_t &high)
+{
+    W_DO(btree_impl::_ux_remove_range(store, low, high));
+    return RCOK;
+}
+
 rc_t btree_m::defrag_page(btree_page_h &page)
 {
     W_DO( btree_impl::_sx_defrag_page(page));
@@ -132,6 +140,81 @@ rc_t btree_m::lookup(
     W_DO( btree_impl::_ux_lookup(store, key, found, el, elen ));
     return RCOK;
 }
+/*
+ * Reads the element of key as an overflow_ref_t. Returns false in found if
+ * the key does not exist and eNOTOVERFLOW if its element is not a reference.
+ */
+static rc_t lookup_overflow_ref(StoreID store, const w_keystr_t& key,
+        overflow_ref_t& ref, bool& found)
+{
+    smsize_t elen = sizeof(ref);
+    rc_t rc = btree_impl::_ux_lookup(store, key, found, &ref, elen);
+    if (rc.is_error()) {
+        if (rc.err_num() == eRECWONTFIT) { return RC(eNOTOVERFLOW); }
+        return rc;
+    }
+    if (found && (elen != sizeof(ref) || !ref.is_valid())) {
+        return RC(eNOTOVERFLOW);
+    }
+    return RCOK;
+}
+
+rc_t btree_m::put_large(StoreID store, const w_keystr_t& key,
+        overflow_writer_t& writer)
+{
+    w_assert1(writer.get_store() == store);
+    if (key.get_length_as_nonkeystr() + sizeof(overflow_ref_t)
+            > btree_page_h::max_entry_size)
+    {
+        return RC(eRECWONTFIT);
+    }
+
+    overflow_ref_t ref;
+    W_DO(writer.finish(ref));
+
+    // a previous large value is deallocated after it is replaced; a regular
+    // element is simply overwritten
+    overflow_ref_t old;
+    bool found = false;
+    rc_t rc = lookup_overflow_ref(store, key, old, found);
+    if (rc.is_error() && rc.err_num() != eNOTOVERFLOW) { return rc; }
+    bool free_old = found && !rc.is_error();
+
+    W_DO(btree_impl::_ux_put(store, key, vec_t(&ref, sizeof(ref))));
+
+    // CS TODO: deallocation is not undone if the transaction aborts, which
+    // is only safe as long as alloc_cache_t does not reuse freed pages
+    if (free_old) {
+        W_DO(overflow_free(old));
+    }
+    return RCOK;
+}
+
+rc_t btree_m::lookup_large(StoreID store, const w_keystr_t& key,
+        overflow_reader_t& reader, bool& found)
+{
+    overflow_ref_t ref;
+    W_DO(lookup_overflow_ref(store, key, ref, found));
+    if (found) {
+        reader.open(ref);
+    }
+    return RCOK;
+}
+
+rc_t btree_m::remove_large(StoreID store, const w_keystr_t& key)
+{
+    overflow_ref_t ref;
+    bool found = false;
+    W_DO(lookup_overflow_ref(store, key, ref, found));
+    if (!found) {
+        return RC(eNOTFOUND);
+    }
+
+    W_DO(btree_impl::_ux_remove(store, key, false));  // Not from UNDO
+    W_DO(overflow_free(ref));
+    return RCOK;
+}
+
 rc_t btree_m::verify_tree(
         StoreID store, int hash_bits, bool &consistent)
 {
@@ -20,6 +20,8 @@ struct btree_int_stats_t;
 class w_keystr_t;
 class verify_volume_result;
 struct okvl_mode;
+class overflow_writer_t;
+class overflow_reader_t;
 /**
  * Data access API for B+Tree.
  * \ingroup SSMBTREE
@@ -90,6 +92,16 @@ public:
         StoreID store,
         const w_keystr_t&                    key);
 
+    /**
+    * Remove all keys in [low, high) from the btree and free the leaves
+    * emptied by it.
+    * @copydetails btree_impl::_ux_remove_range
+    */
+    static rc_t                        remove_range(
+        StoreID store,
+        const w_keystr_t&                    low,
+        const w_keystr_t&                    high);
+
     /** Print the btree (for debugging only). */
     static void                 print(const PageID& root,  bool print_elem = true);
 
@@ -115,6 +127,31 @@ public:
         smsize_t&                      elen,
         bool&                          found);
 
+    /**
+    * Put <key, ref> into the btree, where ref points to the large value
+    * written with writer (see btree_overflow.h). A large value previously
+    * associated with key is deallocated.
+    */
+    static rc_t                        put_large(
+        StoreID store,
+        const w_keystr_t&              key,
+        overflow_writer_t&             writer);
+
+    /**
+    * Find key in btree and open reader on its large value. Returns
+    * eNOTOVERFLOW if the element of key is not a reference to a large value.
+    */
+    static rc_t                        lookup_large(
+        StoreID store,
+        const w_keystr_t&              key,
+        overflow_reader_t&             reader,
+        bool&                          found);
+
+    /** Remove key and deallocate its large value. */
+    static rc_t                        remove_large(
+        StoreID store,
+        const w_keystr_t&              key);
+
     static rc_t                 get_du_statistics(
         const PageID &root_pid,
         btree_stats_t&                btree_stats,
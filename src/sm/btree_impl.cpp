@@ -579,6 +579,44 @@ DBGOUT3( << "&&&& Log for deletion, key: " << key);
     return RCOK;
 }
 
+rc_t
+btree_impl::_ux_remove_range(StoreID store, const w_keystr_t &low,
+        const w_keystr_t &high)
+{
+    if (!(low < high)) {
+        return RCOK;
+    }
+    INC_TSTAT(bt_remove_range_cnt);
+
+    w_keystr_t key = low;
+    while (true) {
+        btree_page_h leaf;
+        W_DO( _ux_traverse(store, key, t_fence_contain, LATCH_EX, leaf, true /*allow retry*/));
+        w_assert3(leaf.is_leaf());
+
+        // one single-log system transaction per leaf
+        sys_xct_section_t sxs (true);
+        W_DO(sxs.check_error_on_start());
+        int removed = 0;
+        rc_t ret = leaf.remove_range(low, high, removed);
+        W_DO (sxs.end_sys_xct (ret));
+        if (removed > 0) {
+            INC_TSTAT(bt_remove_range_pages);
+        }
+
+        // continue with the page holding the high fence key, which is the
+        // foster child if there is one
+        leaf.copy_fence_high_key(key);
+        if (key.is_posinf() || !(key < high)) {
+            break;
+        }
+    }
+
+    // merge away the emptied leaves
+    W_DO(_sx_defrag_tree(store));
+    return RCOK;
+}
+
 rc_t
 btree_impl::_ux_undo_ghost_mark(StoreID store, const w_keystr_t &key)
 {
@@ -217,6 +217,27 @@ public:
     /** _ux_remove()'s internal function without retry by itself.*/
     static rc_t _ux_remove_core(StoreID store, const w_keystr_t &key, const bool undo);
 
+    /**
+    *  \brief Physically removes all records with keys in [low, high).
+    * \details
+    *  Each leaf overlapping the range is cleared in a system transaction
+    *  logged with a single btree_remove_range record, which holds only the
+    *  two keys. The leaves emptied this way are then merged into their
+    *  siblings by _sx_defrag_tree(), and freed by the page cleaner like any
+    *  other merged page.
+    *  Nothing is undone if the calling transaction aborts, so the caller
+    *  must make sure no other transaction has uncommitted updates in the
+    *  range, e.g., with an X lock on the store.
+    *  Context: User transaction.
+    * @param[in] store Store ID
+    * @param[in] low lowest key removed
+    * @param[in] high first key after the range, or supremum
+    */
+    static rc_t                        _ux_remove_range(
+        StoreID store,
+        const w_keystr_t&   low,
+        const w_keystr_t&   high);
+
     /**
     *  \brief Reverses the ghost record of specified key to regular state.
     * \details
@@ -302,6 +323,25 @@ public:
         const bool                 from_undo = false
         );
 
+    /**
+    * \brief Optimistic version of _ux_traverse() that does not latch interior pages.
+    * \details
+    * Interior pages are read without latches and validated with the version
+    * counter of their buffer-pool frame (OLFIT). Only the leaf is latched, in
+    * leaf_latch_mode. Gives up (success=false, leaf unfixed) whenever a
+    * validation fails or an interior page would have to be latched, e.g., to
+    * follow a non-swizzled pointer or to adopt a foster child.
+    * @param[out] success whether the leaf was found and latched
+    */
+    static rc_t                 _ux_traverse_optimistic(
+        StoreID                    store,
+        const w_keystr_t&          key,
+        traverse_mode_t            traverse_mode,
+        latch_mode_t               leaf_latch_mode,
+        btree_page_h&              leaf,
+        bool&                      success
+        );
+
     /**
     * \brief For internal recursion. Assuming start is non-leaf, check children recursively.
     * \details
@@ -593,6 +633,13 @@ public:
                                                               btree_page_h &foster_p,
                                                               const bool full_logging = false);
 
+    /**
+     * Conservatively estimates the space page needs to absorb merged, its foster-child.
+     * _sx_merge_foster() does nothing if page has less usable space than this.
+     */
+    static smsize_t             _estimate_required_space_to_merge(btree_page_h &page,
+                                                                  btree_page_h &merged);
+
     /**
      * \brief Converts the right sibling of given page to be a foster-child of it.
      * \details
@@ -825,29 +872,58 @@ public:
     * If it finds such pages, it does adopt/defrag/merge etc.
     * This method is completely opportunistic, meaning it doesn't require a global latch or lock.
     * If there is some page this method can't get EX latch immediately, it skips the page.
-    * Context: in system transaction.
+    * Only pages already in the bufferpool are visited, so this method never reads a page.
+    * Interior nodes are never merged (see _ux_merge_foster_apply_parent), so merge/rebalance
+    * is only done on leaves: if one of two neighboring leaves is underfull and both fit in
+    * one page, the right one is de-adopted into a foster chain and then absorbed.
+    * Context: in user transaction or none. Each operation is its own system transaction.
     * @param[in] store Store ID
     * @param[in] inpage_defrag_ghost_threshold 0 to 100 (percent). if page has this many ghosts, and:
     * @param[in] inpage_defrag_usage_threshold 0 to 100 (percent). and it has this many used space, it does defrag.
     * @param[in] does_adopt whether we do adopts
     * @param[in] does_merge whether we do merge/rebalance (which might trigger de-adopt as well)
+    * @param[in] merge_threshold 0 to 100 (percent). leaves using less than this are merged with a neighbor.
+    * @param[in,out] max_ops if not NULL, the maximum number of adopts/defrags/merges to do.
+    * Decremented by the number of operations done.
     */
     static rc_t                        _sx_defrag_tree(
         StoreID store,
         uint16_t inpage_defrag_ghost_threshold = 10,
         uint16_t inpage_defrag_usage_threshold = 50,
         bool does_adopt = true,
-        bool does_merge = true);
+        bool does_merge = true,
+        uint16_t merge_threshold = 25,
+        uint32_t* max_ops = NULL);
+
+    /** Parameters and remaining budget of one _sx_defrag_tree() call. */
+    struct defrag_tree_args {
+        uint16_t ghost_threshold;
+        uint16_t usage_threshold;
+        bool     does_adopt;
+        bool     does_merge;
+        uint16_t merge_threshold;
+        uint32_t ops_left;
+        /** pages updated after this might have ghosts an active xct needs to rollback. */
+        lsn_t    oldest_active;
+    };
 
     /**
+     * Checks the cached children of the given node, recursively, and then the node
+     * itself with _sx_defrag_children().
      * @see _sx_defrag_tree()
+     * @pre node is latched in SH or EX mode
      */
-    static rc_t                        _ux_defrag_tree_core(
-        StoreID store,
-        uint16_t inpage_defrag_ghost_threshold,
-        uint16_t inpage_defrag_usage_threshold,
-        bool does_adopt,
-        bool does_merge);
+    static rc_t                        _sx_defrag_node(
+        btree_page_h &node, defrag_tree_args &args);
+
+    /**
+     * Adopts fosters of, in-page defrags and merges the cached children of the given node.
+     * Children which can't be EX latched immediately are skipped.
+     * @see _sx_defrag_tree()
+     * @pre parent is latched in EX mode
+     */
+    static rc_t                        _sx_defrag_children(
+        btree_page_h &parent, defrag_tree_args &args);
 
     /**
      * \brief Defrags the given page to remove holes and ghost records in the page.
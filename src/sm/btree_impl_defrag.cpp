@@ -18,37 +18,207 @@
 #include "btree_impl.h"
 #include "w_key.h"
 #include "xct.h"
+#include "bf_tree.h"
+#include "log_core.h"
+#include "log_lsn_tracker.h"
+
+#include <limits>
+
+/** Whether the given child of parent is in the bufferpool. -1 means pid0. */
+static bool is_cached_child(btree_page_h &parent, slotid_t slot)
+{
+    PageID ptr = slot < 0 ? parent.pid0_opaqueptr() : parent.child_opaqueptr(slot);
+    return smlevel_0::bf->is_swizzled_pointer(ptr) || smlevel_0::bf->lookup(ptr) != 0;
+}
+
+/**
+ * Conditionally fixes the given child of parent if it is in the bufferpool.
+ * Returns with child unfixed if it is not cached or is latched by someone else.
+ */
+static rc_t fix_cached_child(btree_page_h &parent, slotid_t slot,
+                             latch_mode_t mode, btree_page_h &child)
+{
+    if (!is_cached_child(parent, slot)) {
+        return RCOK;
+    }
+    PageID ptr = slot < 0 ? parent.pid0_opaqueptr() : parent.child_opaqueptr(slot);
+    rc_t rc = child.fix_nonroot(parent, ptr, mode, true);
+    if (rc.is_error() && rc.err_num() != stTIMEOUT) {
+        return rc;
+    }
+    return RCOK;
+}
+
+/** Whether the page would use less than merge_threshold of its space without ghosts. */
+static bool is_underfull(btree_page_h &page, const btree_impl::defrag_tree_args &args)
+{
+    smsize_t live = page.used_space() - page.reclaimable_space();
+    return live * 100 < btree_page_data::data_sz * args.merge_threshold;
+}
+
+static bool needs_inpage_defrag(btree_page_h &page,
+                                const btree_impl::defrag_tree_args &args)
+{
+    if (page.reclaimable_space() == 0) {
+        return false;
+    }
+    // ghosts marked by an active transaction must survive its rollback
+    if (page.nghosts() > 0 && page.get_page_lsn() >= args.oldest_active) {
+        return false;
+    }
+    if (args.does_merge && is_underfull(page, args)) {
+        return true; // so that it has room to absorb its sibling
+    }
+    return page.nghosts() * 100 >= page.nrecs() * args.ghost_threshold
+        && page.used_space() * 100 >= btree_page_data::data_sz * args.usage_threshold;
+}
 
 rc_t btree_impl::_sx_defrag_tree(
     StoreID store,
     uint16_t inpage_defrag_ghost_threshold,
     uint16_t inpage_defrag_usage_threshold,
     bool does_adopt,
-    bool does_merge)
+    bool does_merge,
+    uint16_t merge_threshold,
+    uint32_t* max_ops)
 {
-    sys_xct_section_t sxs;
-    W_DO(sxs.check_error_on_start());
-    rc_t ret = _ux_defrag_tree_core (store,
-        inpage_defrag_ghost_threshold,
-        inpage_defrag_usage_threshold,
-        does_adopt, does_merge
-    );
-    W_DO (sxs.end_sys_xct (ret));
+    defrag_tree_args args;
+    args.ghost_threshold = inpage_defrag_ghost_threshold;
+    args.usage_threshold = inpage_defrag_usage_threshold;
+    args.does_adopt = does_adopt;
+    args.does_merge = does_merge;
+    args.merge_threshold = merge_threshold;
+    args.ops_left = max_ops ? *max_ops : std::numeric_limits<uint32_t>::max();
+    args.oldest_active = smlevel_0::log->get_oldest_lsn_tracker()->get_oldest_active_lsn(
+            smlevel_0::log->curr_lsn());
+
+    rc_t ret;
+    {
+        // this uses the tree walk-through of jira ticket:60, which latches
+        // one path from the root plus the children of its last node
+        btree_page_h root;
+        W_DO (root.fix_root(store, LATCH_SH));
+        ret = _sx_defrag_node(root, args);
+    }
+    if (max_ops) {
+        *max_ops = args.ops_left;
+    }
     return ret;
 }
 
-rc_t btree_impl::_ux_defrag_tree_core(
-    StoreID store,
-    uint16_t /*inpage_defrag_ghost_threshold*/,
-    uint16_t /*inpage_defrag_usage_threshold*/,
-    bool /*does_adopt*/,
-    bool /*does_merge*/)
+rc_t btree_impl::_sx_defrag_node(btree_page_h &node, defrag_tree_args &args)
+{
+    w_assert1 (node.latch_mode() == LATCH_SH || node.latch_mode() == LATCH_EX);
+    if (node.is_leaf()) {
+        return RCOK; // only happens for the root. the ghost reclaimer takes care of it
+    }
+
+    // bottom-up, so that fosters pushed up by adopts below are adopted here
+    if (node.level() > 2) {
+        for (slotid_t i = -1; i < node.nrecs() && args.ops_left > 0; ++i) {
+            btree_page_h child;
+            W_DO(fix_cached_child(node, i, LATCH_SH, child));
+            if (child.is_fixed()) {
+                W_DO(_sx_defrag_node(child, args));
+            }
+        }
+    }
+
+    if (args.ops_left > 0
+        && (node.latch_mode() == LATCH_EX || node.upgrade_latch_conditional())) {
+        W_DO(_sx_defrag_children(node, args));
+    }
+    return RCOK;
+}
+
+rc_t btree_impl::_sx_defrag_children(btree_page_h &parent, defrag_tree_args &args)
 {
-    // TODO implement
-    // this should use the improved tree-walk-through jira ticket:60 "Tree walk-through without more than 2 pages latched" (originally trac ticket:62)
-    btree_page_h page;
-    W_DO (page.fix_root(store, LATCH_SH));
+    w_assert1 (parent.latch_mode() == LATCH_EX);
+    w_assert1 (parent.is_node());
+    const PageID parent_pid = parent.pid();
+    for (slotid_t i = -1; i < parent.nrecs() && args.ops_left > 0; ++i) {
+        btree_page_h child;
+        W_DO(fix_cached_child(parent, i, LATCH_EX, child));
+        if (!child.is_fixed()) {
+            continue;
+        }
+
+        if (child.is_leaf() && needs_inpage_defrag(child, args)) {
+            W_DO(_sx_defrag_page(child));
+            INC_TSTAT(bt_defrag_pages);
+            --args.ops_left;
+        }
+
+        bool deadopted = false;
+        // two leaves are merged if one of them is underfull and the left one
+        // can absorb the right one. As merge only works along a foster chain,
+        // a right sibling is first de-adopted.
+        if (args.does_merge && args.ops_left > 0 && child.is_leaf()
+            && child.get_foster() == 0 && i + 1 < parent.nrecs()) {
+            bool fits = false;
+            {
+                btree_page_h sibling;
+                W_DO(fix_cached_child(parent, i + 1, LATCH_EX, sibling));
+                if (sibling.is_fixed() && needs_inpage_defrag(sibling, args)) {
+                    W_DO(_sx_defrag_page(sibling));
+                    INC_TSTAT(bt_defrag_pages);
+                    --args.ops_left;
+                }
+                fits = sibling.is_fixed() && args.ops_left > 0
+                    && (is_underfull(child, args) || is_underfull(sibling, args))
+                    && child.usable_space() >= _estimate_required_space_to_merge(child, sibling);
+            }
+            if (fits) {
+                // de-adopt fixes both children itself
+                PageID child_ptr = i < 0 ? parent.pid0_opaqueptr() : parent.child_opaqueptr(i);
+                child.unfix();
+                W_DO(_sx_deadopt_foster(parent, i));
+                W_DO(child.fix_nonroot(parent, child_ptr, LATCH_EX));
+                deadopted = true;
+            }
+        }
 
+        // shorten the foster chain hanging off this child
+        while (child.get_foster() != 0 && args.ops_left > 0) {
+            if (args.does_merge && child.is_leaf()) {
+                bool fits = false;
+                {
+                    btree_page_h foster;
+                    rc_t rc = foster.fix_nonroot(child, child.get_foster_opaqueptr(),
+                                                 LATCH_SH, true);
+                    if (rc.is_error() && rc.err_num() != stTIMEOUT) {
+                        return rc;
+                    }
+                    fits = foster.is_fixed()
+                        && (is_underfull(child, args) || is_underfull(foster, args))
+                        && child.usable_space() >= _estimate_required_space_to_merge(child, foster);
+                }
+                if (fits) {
+                    PageID foster_pid = child.get_foster();
+                    W_DO(_sx_merge_foster(child));
+                    if (child.get_foster() == foster_pid) {
+                        break; // didn't fit after all
+                    }
+                    INC_TSTAT(bt_defrag_merges);
+                    --args.ops_left;
+                    if (deadopted && child.get_foster() == 0) {
+                        --i; // it might absorb the next sibling, too
+                    }
+                    continue;
+                }
+            }
+            if (args.does_adopt) {
+                // the adopted foster child becomes slot i+1, checked next
+                W_DO(_sx_adopt_foster(parent, child));
+                INC_TSTAT(bt_defrag_adopts);
+                --args.ops_left;
+                if (parent.pid() != parent_pid) {
+                    return RCOK; // parent was split and we now hold its foster child
+                }
+            }
+            break;
+        }
+    }
     return RCOK;
 }
 
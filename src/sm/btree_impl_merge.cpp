@@ -374,7 +374,7 @@ rc_t btree_impl::_sx_merge_foster(btree_page_h &page)
 }
 
 /** this function conservatively estimates.*/
-smsize_t estimate_required_space_to_merge (btree_page_h &page, btree_page_h &merged)
+smsize_t btree_impl::_estimate_required_space_to_merge (btree_page_h &page, btree_page_h &merged)
 {
     smsize_t ret = merged.used_space();
 
@@ -411,7 +411,7 @@ rc_t btree_impl::_ux_merge_foster_core(btree_page_h &page,      // In/Out: desti
     caller_commit = true;
 
     // can we fully absorb it?
-    size_t additional = estimate_required_space_to_merge(page, foster_p);
+    size_t additional = _estimate_required_space_to_merge(page, foster_p);
     if (page.usable_space() < additional) {
         // No record movement occurred, tell caller to commit the single log system transaction
         caller_commit = true;
@@ -476,9 +476,21 @@ rc_t btree_impl::_ux_merge_foster_core(btree_page_h &page,      // In/Out: desti
     if (ret.is_error())
         return ret;
 
+    // The foster child goes away, so the pointer to it must not stay
+    // swizzled; its own foster child (if any) is then reached through page
+    if (smlevel_0::bf->is_swizzled_pointer(page.get_foster_opaqueptr())) {
+        smlevel_0::bf->unswizzle(page.get_generic_page(),
+                GeneralRecordIds::FOSTER_CHILD);
+    }
+
     // Move the records now
     _ux_merge_foster_apply_parent(page, foster_p, false);
     W_COERCE(foster_p.set_to_be_deleted(false));
+
+    if (page.get_foster_opaqueptr() != 0) {
+        smlevel_0::bf->switch_parent(page.get_foster_opaqueptr(),
+                page.get_generic_page());
+    }
     return RCOK;
 }
 
@@ -570,11 +582,13 @@ void btree_impl::_ux_deadopt_foster_apply_foster_parent(btree_page_h &foster_par
     w_keystr_t org_low_key, org_high_key;
     foster_parent.copy_fence_low_key(org_low_key);
     foster_parent.copy_fence_high_key(org_high_key);
-    w_assert1 ((size_t)foster_parent.get_prefix_length() == org_low_key.common_leading_bytes(org_high_key));
+    // the page may use a shorter prefix than the fence keys have in common,
+    // so keep it as is. The records are stored without it.
+    w_assert1 ((size_t)foster_parent.get_prefix_length() <= org_low_key.common_leading_bytes(org_high_key));
 
     // high_key of adoped child is now chain-fence-high:
     W_COERCE(foster_parent.replace_fence_rec_nolog_may_defrag(
-        org_low_key, org_high_key, high_key));
+        org_low_key, org_high_key, high_key, foster_parent.get_prefix_length()));
 
     foster_parent.page()->btree_foster = foster_child_id;
     foster_parent.set_emlsn_general(GeneralRecordIds::FOSTER_CHILD, foster_child_emlsn);
@@ -601,6 +615,14 @@ rc_t btree_impl::_ux_deadopt_foster_core(btree_page_h &real_parent, slotid_t fos
         return RCOK; // maybe error?
     }
 
+    // The pointer to the foster child moves to foster_parent below,
+    // so it must not stay swizzled in real_parent
+    general_recordid_t foster_child_slot = foster_parent_slot + 2;
+    if (smlevel_0::bf->is_swizzled_pointer(
+                real_parent.child_opaqueptr(foster_parent_slot + 1))) {
+        smlevel_0::bf->unswizzle(real_parent.get_generic_page(), foster_child_slot);
+    }
+
     // get low_key
     btrec_t rec (real_parent, foster_parent_slot + 1);
     const w_keystr_t &low_key = rec.key();
@@ -613,7 +635,7 @@ rc_t btree_impl::_ux_deadopt_foster_core(btree_page_h &real_parent, slotid_t fos
         btrec_t next_rec (real_parent, foster_parent_slot + 2);
         high_key = next_rec.key();
     } else {
-        w_assert1(foster_parent_slot + 1 == real_parent.nrecs());
+        w_assert1(foster_parent_slot + 2 == real_parent.nrecs());
         real_parent.copy_fence_high_key(high_key);
     }
     w_assert1(low_key.compare(high_key) < 0);
@@ -625,6 +647,9 @@ rc_t btree_impl::_ux_deadopt_foster_core(btree_page_h &real_parent, slotid_t fos
     _ux_deadopt_foster_apply_foster_parent (foster_parent,
                                 foster_child_id, foster_child_emlsn, low_key, high_key);
 
+    // Switch parent of de-adopted child
+    smlevel_0::bf->switch_parent(foster_child_id, foster_parent.get_generic_page());
+
     w_assert3(real_parent.is_consistent(true, true));
     w_assert3(foster_parent.is_consistent(true, true));
     return RCOK;
@@ -98,6 +98,16 @@ btree_impl::_ux_traverse(StoreID store, const w_keystr_t &key,
         w_assert1(traverse_mode != t_fence_low_match); // surely misuse
     }
 
+    if (smlevel_0::bf->is_optimistic_reads_enabled()
+            && (xct() == NULL || !xct()->is_inquery_verify())) {
+        bool success;
+        W_DO(_ux_traverse_optimistic(store, key, traverse_mode, leaf_latch_mode,
+                                     leaf, success));
+        if (success) {
+            return RCOK;
+        }
+    }
+
     PageID leaf_pid_causing_failed_upgrade = 0;
     for (int times = 0; times < 20; ++times) { // arbitrary number
         inquery_verify_init(store); // initialize in-query verification
@@ -148,6 +158,91 @@ btree_impl::_ux_traverse(StoreID store, const w_keystr_t &key,
     return RC (eTOOMANYRETRY);
 }
 
+rc_t
+btree_impl::_ux_traverse_optimistic(StoreID store, const w_keystr_t &key,
+                                    traverse_mode_t traverse_mode,
+                                    latch_mode_t leaf_latch_mode,
+                                    btree_page_h &leaf, bool &success) {
+    success = false;
+    leaf.unfix();
+
+    bf_tree_m* bf = smlevel_0::bf;
+    bf_idx idx = bf->get_root_page_idx(store);
+    uint32_t version;
+    if (idx == 0 || !bf->optimistic_read_begin(idx, version)) {
+        INC_TSTAT(bt_optimistic_traverse_fail);
+        return RCOK;
+    }
+
+    // Same descent as _ux_traverse_recurse, but interior pages are never
+    // latched: each page is read under its frame version, which is validated
+    // only after the version of the next page was taken (OLFIT). Anything
+    // that needs a latch on an interior page -- non-swizzled pointers,
+    // adoptions, tree growth -- or any validation failure makes us give up,
+    // and the caller falls back to latch coupling.
+    bool followed_foster = false;
+    while (true) {
+        btree_page_h current;
+        current.fix_nonbufferpool_page(bf->get_page(idx));
+
+        // foster children not reached through their foster parent are
+        // adopted by the latched traversal
+        if (!followed_foster && current.get_foster_opaqueptr() != 0) {
+            break;
+        }
+
+        bool          this_is_the_leaf_page = false;
+        slot_follow_t slot_to_follow        = t_follow_invalid;
+        if (current.is_leaf()) {
+            // latching the leaf validates everything we read so far
+            rc_t rc = leaf.fix_optimistic(idx, version, leaf_latch_mode);
+            if (rc.is_error()) {
+                if (rc.err_num() == eLATCHQFAIL) { break; }
+                return rc;
+            }
+            _ux_traverse_search(traverse_mode, &leaf, key,
+                                this_is_the_leaf_page, slot_to_follow);
+            if (!this_is_the_leaf_page) {
+                // leaf has a foster chain to follow
+                leaf.unfix();
+                break;
+            }
+            INC_TSTAT(bt_optimistic_traverse_cnt);
+            success = true;
+            return RCOK;
+        }
+
+        _ux_traverse_search(traverse_mode, &current, key,
+                            this_is_the_leaf_page, slot_to_follow);
+        if (this_is_the_leaf_page) { break; } // torn read
+
+        PageID pid_to_follow_opaqueptr;
+        if (slot_to_follow == t_follow_foster) {
+            pid_to_follow_opaqueptr = current.get_foster_opaqueptr();
+        } else if (slot_to_follow == t_follow_pid0) {
+            pid_to_follow_opaqueptr = current.pid0_opaqueptr();
+        } else {
+            pid_to_follow_opaqueptr = current.child_opaqueptr(slot_to_follow);
+        }
+        if (!bf_tree_m::is_swizzled_pointer(pid_to_follow_opaqueptr)) {
+            break; // needs a hash table lookup under the parent latch
+        }
+
+        bf_idx next_idx = pid_to_follow_opaqueptr ^ SWIZZLED_PID_BIT;
+        uint32_t next_version;
+        if (!bf->optimistic_read_begin(next_idx, next_version)
+                || !bf->optimistic_read_validate(idx, version)) {
+            break;
+        }
+        idx = next_idx;
+        version = next_version;
+        followed_foster = (slot_to_follow == t_follow_foster);
+    }
+
+    INC_TSTAT(bt_optimistic_traverse_fail);
+    return RCOK;
+}
+
 rc_t
 btree_impl::_ux_traverse_recurse(btree_page_h&                start,
                                  const w_keystr_t&            key,
@@ -73,6 +73,12 @@ rc_t btree_impl::_ux_norec_alloc_core(btree_page_h &page, PageID &new_page_id) {
                           fence, fence, chain_high, false);
     page.accept_empty_child(page.get_page_lsn(), new_page_id, false /*not from redo*/);
 
+    // The old foster child, if any, is now reached through the new page
+    if (new_page.get_foster_opaqueptr() != 0) {
+        smlevel_0::bf->switch_parent(new_page.get_foster_opaqueptr(),
+                new_page.get_generic_page());
+    }
+
     // in this operation, the log contains everything we need to recover without any
     // write-order-dependency. So, no registration for WOD.
     w_assert3(new_page.is_consistent(true, true));
@@ -265,9 +271,11 @@ rc_t btree_impl::_ux_adopt_foster_core (btree_page_h &parent, btree_page_h &chil
     w_assert1 (child.latch_mode() == LATCH_EX);
     w_assert0 (child.get_foster() != 0);
 
-    PageID new_child_pid = child.get_foster();
+    // The foster pointer is removed from the child below, so if it is
+    // swizzled, the foster child must be unswizzled first
+    PageID new_child_pid = child.get_foster_opaqueptr();
     if (smlevel_0::bf->is_swizzled_pointer(new_child_pid)) {
-        smlevel_0::bf->unswizzle(parent.get_generic_page(),
+        smlevel_0::bf->unswizzle(child.get_generic_page(),
                 GeneralRecordIds::FOSTER_CHILD, true, &new_child_pid);
     }
     w_assert1(!smlevel_0::bf->is_swizzled_pointer(new_child_pid));
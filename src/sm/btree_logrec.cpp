@@ -1195,3 +1195,44 @@ void btree_compress_page_log::redo(fixable_page_h* p)
     borrowed_btree_page_h bp(p);
     bp.compress(low, high, chain, true /* redo */);
 }
+
+btree_remove_range_log::btree_remove_range_log(
+        const btree_page_h& page,
+        const w_keystr_t& low,
+        const w_keystr_t& high)
+{
+    uint16_t low_len = low.get_length_as_keystr();
+    uint16_t high_len = high.get_length_as_keystr();
+
+    char* ptr = data_ssx();
+    memcpy(ptr, &low_len, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    memcpy(ptr, &high_len, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+
+    low.serialize_as_keystr(ptr);
+    ptr += low_len;
+    high.serialize_as_keystr(ptr);
+    ptr += high_len;
+
+    fill(page, ptr - data_ssx());
+}
+
+void btree_remove_range_log::redo(fixable_page_h* p)
+{
+    char* ptr = data_ssx();
+
+    uint16_t low_len = *((uint16_t*) ptr);
+    ptr += sizeof(uint16_t);
+    uint16_t high_len = *((uint16_t*) ptr);
+    ptr += sizeof(uint16_t);
+
+    w_keystr_t low, high;
+    low.construct_from_keystr(ptr, low_len);
+    ptr += low_len;
+    high.construct_from_keystr(ptr, high_len);
+
+    borrowed_btree_page_h bp(p);
+    int removed;
+    W_COERCE(bp.remove_range(low, high, removed, true /* redo */));
+}
@@ -0,0 +1,57 @@
+#include "w_defines.h"
+
+#define SM_SOURCE
+
+#include "btree_maintainer.h"
+
+#include "btree_impl.h"
+#include "stnode_page.h"
+#include "vol.h"
+#include "restart.h"
+
+#include <vector>
+
+btree_maintainer_t::btree_maintainer_t(const sm_options& options)
+    : worker_thread_t(options.get_int_option(
+                "sm_btree_maintenance_interval_millisec", 10000)),
+    _next_store(0)
+{
+    int max_ops = options.get_int_option("sm_btree_maintenance_max_ops", 100);
+    w_assert0(max_ops > 0);
+    _max_ops = max_ops;
+
+    int threshold = options.get_int_option("sm_btree_merge_threshold", 25);
+    w_assert0(threshold >= 0 && threshold <= 100);
+    _merge_threshold = threshold;
+}
+
+btree_maintainer_t::~btree_maintainer_t()
+{
+}
+
+void btree_maintainer_t::do_work()
+{
+    // Pages may still be pending for restore or redo
+    if (smlevel_0::recovery && smlevel_0::recovery->is_running()) {
+        return;
+    }
+
+    std::vector<StoreID> stores;
+    smlevel_0::vol->get_stnode_cache()->get_used_stores(stores);
+    if (stores.empty()) { return; }
+
+    // Resume where the previous round ran out of budget
+    size_t first = 0;
+    while (first < stores.size() && stores[first] < _next_store) {
+        first++;
+    }
+
+    uint32_t ops_left = _max_ops;
+    for (size_t n = 0; n < stores.size() && ops_left > 0 && !should_exit(); n++) {
+        StoreID store = stores[(first + n) % stores.size()];
+        W_COERCE(btree_impl::_sx_defrag_tree(store, 10, 50, true, true,
+                    _merge_threshold, &ops_left));
+        _next_store = ops_left > 0 ? store + 1 : store;
+    }
+    INC_TSTAT(bt_maint_rounds);
+}
@@ -0,0 +1,49 @@
+#ifndef BTREE_MAINTAINER_H
+#define BTREE_MAINTAINER_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "sm_options.h"
+#include "worker_thread.h"
+
+/**
+ * \brief Background daemon that keeps B-trees close to their ideal shape.
+ *
+ * \details
+ * Splits leave foster chains behind, which are adopted only when a
+ * traversal happens to pass the foster parent with enough latch slack (see
+ * btree_impl::_ux_traverse_try_eager_adopt), and pages emptied by deletes
+ * are never merged by the foreground. Both make lookups longer than the
+ * height of the tree. In each round, this daemon walks the stores of the
+ * volume with btree_impl::_sx_defrag_tree(), which adopts foster children,
+ * defragments leaves full of ghosts and merges underfull leaves with a
+ * neighbor.
+ *
+ * The daemon stays out of the way of transactions: only pages already in
+ * the bufferpool are visited, pages are latched conditionally and skipped
+ * if busy, and each round does at most sm_btree_maintenance_max_ops
+ * structural operations. The next round continues with the store where
+ * the previous one ran out of budget. Nothing is done while instant
+ * restart is still running.
+ */
+class btree_maintainer_t : public worker_thread_t {
+public:
+    btree_maintainer_t(const sm_options& options);
+    virtual ~btree_maintainer_t();
+
+protected:
+    virtual void do_work();
+
+private:
+    /// Maximum number of adopts, defrags and merges per round
+    uint32_t _max_ops;
+
+    /// Leaves using less than this percentage of the page are merged
+    uint16_t _merge_threshold;
+
+    /// Store at which the next round starts
+    StoreID _next_store;
+};
+
+#endif // BTREE_MAINTAINER_H
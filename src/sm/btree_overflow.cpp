@@ -0,0 +1,223 @@
+#include "w_defines.h"
+
+#define SM_SOURCE
+
+#include "btree_overflow.h"
+
+#include "sm_base.h"
+#include "logrec.h"
+#include "log_core.h"
+#include "vol.h"
+#include "logarchiver.h"
+
+#include "logdef_gen.cpp"
+
+#include <algorithm>
+#include <cstring>
+
+static generic_page* alloc_pages(size_t count)
+{
+    generic_page* buf = NULL;
+    int res = posix_memalign((void**) &buf, LogArchiver::IO_ALIGN,
+            count * sizeof(generic_page));
+    w_assert0(res == 0);
+    memset(buf, 0, count * sizeof(generic_page));
+    return buf;
+}
+
+overflow_page_img_log::overflow_page_img_log(const generic_page* p)
+{
+    const overflow_page* page = reinterpret_cast<const overflow_page*>(p);
+    size_t size = page->used_size();
+    w_assert1(size <= sizeof(generic_page));
+    memcpy(data_ssx(), page, size);
+    fill(page->pid, page->store, t_overflow_p, size);
+}
+
+void overflow_page_img_log::redo(fixable_page_h* p)
+{
+    // Image contains everything but the unused part of the data area
+    const overflow_page* img =
+        reinterpret_cast<const overflow_page*>(data_ssx());
+    generic_page* page = p->get_generic_page();
+    memset(page, 0, sizeof(generic_page));
+    memcpy(page, img, img->used_size());
+}
+
+overflow_writer_t::overflow_writer_t(StoreID store)
+    : store(store), finished(false), batch_count(0), current_pid(0)
+{
+    buffer = alloc_pages(max_batch);
+}
+
+overflow_writer_t::~overflow_writer_t()
+{
+    free(buffer);
+}
+
+void overflow_writer_t::start_page(PageID pid)
+{
+    overflow_page* page = current();
+    memset(page, 0, sizeof(generic_page));
+    page->pid = pid;
+    page->store = store;
+    page->tag = t_overflow_p;
+    current_pid = pid;
+
+    if (ref.first == 0) { ref.first = pid; }
+    ref.page_count++;
+}
+
+rc_t overflow_writer_t::write(const char* data, size_t length)
+{
+    w_assert0(!finished);
+
+    while (length > 0) {
+        if (current_pid == 0) {
+            PageID pid;
+            W_DO(smlevel_0::vol->alloc_a_page(pid));
+            start_page(pid);
+        }
+        else if (current()->data_length == overflow_page::data_capacity) {
+            PageID next;
+            W_DO(smlevel_0::vol->alloc_a_page(next));
+            W_DO(complete_page(next));
+            start_page(next);
+        }
+
+        overflow_page* page = current();
+        size_t count = std::min<size_t>(length,
+                overflow_page::data_capacity - page->data_length);
+        memcpy(page->data + page->data_length, data, count);
+        page->data_length += count;
+        ref.length += count;
+
+        data += count;
+        length -= count;
+    }
+
+    return RCOK;
+}
+
+rc_t overflow_writer_t::complete_page(PageID next)
+{
+    overflow_page* page = current();
+    page->next = next;
+
+    if (smlevel_0::log && smlevel_0::logging_enabled) {
+        logrec_t* lr = new overflow_page_img_log(
+                reinterpret_cast<generic_page*>(page));
+        lr->set_page_prev_lsn(lsn_t::null);
+        lsn_t lsn;
+        rc_t rc = smlevel_0::log->insert(*lr, &lsn);
+        delete lr;
+        W_DO(rc);
+        page->lsn = lsn;
+    }
+    page->checksum = page->calculate_checksum();
+    INC_TSTAT(overflow_pages_written);
+
+    batch_count++;
+    // next page is appended to the batch only if contiguous
+    if (batch_count == max_batch || next != current_pid + 1) {
+        W_DO(flush_batch());
+    }
+    return RCOK;
+}
+
+rc_t overflow_writer_t::flush_batch()
+{
+    if (batch_count == 0) { return RCOK; }
+
+    PageID first = buffer[0].pid;
+    W_DO(smlevel_0::vol->write_many_pages(first, buffer, batch_count));
+    batch_count = 0;
+    return RCOK;
+}
+
+rc_t overflow_writer_t::finish(overflow_ref_t& ret)
+{
+    w_assert0(!finished);
+
+    if (current_pid != 0) {
+        W_DO(complete_page(0));
+        // complete_page(0) always flushes the batch
+        w_assert1(batch_count == 0);
+    }
+
+    finished = true;
+    ret = ref;
+    return RCOK;
+}
+
+overflow_reader_t::overflow_reader_t()
+    : position(0), page_pid(0), page_offset(0)
+{
+    page = reinterpret_cast<overflow_page*>(alloc_pages(1));
+}
+
+overflow_reader_t::~overflow_reader_t()
+{
+    free(page);
+}
+
+void overflow_reader_t::open(const overflow_ref_t& r)
+{
+    ref = r;
+    position = 0;
+    page_pid = 0;
+    page_offset = 0;
+}
+
+rc_t overflow_reader_t::read(char* buf, size_t length, size_t& done)
+{
+    done = 0;
+    while (done < length && !eof()) {
+        if (page_pid == 0 || page_offset == page->data_length) {
+            PageID pid = page_pid == 0 ? ref.first : page->next;
+            w_assert1(pid != 0);
+            W_DO(smlevel_0::vol->read_page_verify(pid,
+                        reinterpret_cast<generic_page*>(page), lsn_t::null));
+            if (page->pid != pid || page->tag != t_overflow_p) {
+                return RC(eBADOVERFLOWPAGE);
+            }
+            page_pid = pid;
+            page_offset = 0;
+            INC_TSTAT(overflow_pages_read);
+        }
+
+        size_t count = std::min<size_t>(length - done,
+                page->data_length - page_offset);
+        memcpy(buf + done, page->data + page_offset, count);
+        page_offset += count;
+        position += count;
+        done += count;
+    }
+
+    return RCOK;
+}
+
+rc_t overflow_free(const overflow_ref_t& ref)
+{
+    if (ref.first == 0) { return RCOK; }
+
+    generic_page* buf = alloc_pages(1);
+    overflow_page* page = reinterpret_cast<overflow_page*>(buf);
+
+    rc_t rc;
+    PageID pid = ref.first;
+    while (pid != 0) {
+        rc = smlevel_0::vol->read_page_verify(pid, buf, lsn_t::null);
+        if (rc.is_error()) { break; }
+        if (page->pid != pid || page->tag != t_overflow_p) {
+            rc = RC(eBADOVERFLOWPAGE);
+            break;
+        }
+        rc = smlevel_0::vol->deallocate_page(pid);
+        if (rc.is_error()) { break; }
+        pid = page->next;
+    }
+
+    free(buf);
+    return rc;
+}
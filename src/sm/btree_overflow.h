@@ -0,0 +1,167 @@
+#ifndef BTREE_OVERFLOW_H
+#define BTREE_OVERFLOW_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "generic_page.h"
+
+/**
+ * \brief Page holding a chunk of a large B-tree value.
+ *
+ * \details
+ * Values which do not fit into a B-tree page (see
+ * btree_page_h::max_entry_size) are stored in a chain of overflow pages,
+ * and the B-tree record only holds an overflow_ref_t pointing to the first
+ * page of the chain.
+ *
+ * Overflow pages are not managed by the buffer pool. They are written once,
+ * directly to the volume, and never updated in place: replacing a large
+ * value writes a new chain and deallocates the old one. Each page is logged
+ * with a single overflow_page_img log record carrying its used part, so
+ * that it can be redone in restart and restore like any other page.
+ */
+class overflow_page : public generic_page_header {
+public:
+    /// Next page of the chain, 0 if this is the last one
+    PageID   next;
+
+    /// Number of bytes used in data
+    uint32_t data_length;
+
+    static const size_t data_capacity = generic_page_header::page_sz
+        - sizeof(generic_page_header) - sizeof(PageID) - sizeof(uint32_t);
+
+    char     data[data_capacity];
+
+    /// Size of the part of the page that must be logged
+    size_t used_size() const
+    {
+        return sizeof(generic_page_header) + sizeof(PageID)
+            + sizeof(uint32_t) + data_length;
+    }
+};
+BOOST_STATIC_ASSERT(sizeof(overflow_page) == generic_page_header::page_sz);
+
+/**
+ * \brief Inline pointer to a large value, stored as the B-tree element.
+ */
+struct overflow_ref_t {
+    static const uint32_t MAGIC = 0x4f564652; // "OVFR"
+
+    uint32_t magic;
+    /// Number of pages in the chain
+    uint32_t page_count;
+    /// Total length of the value in bytes
+    uint64_t length;
+    /// First page of the chain, 0 for an empty value
+    PageID   first;
+    uint32_t fill;
+
+    overflow_ref_t()
+        : magic(MAGIC), page_count(0), length(0), first(0), fill(0)
+    {}
+
+    bool is_valid() const { return magic == MAGIC; }
+};
+
+/**
+ * \brief Streaming writer of a large value.
+ *
+ * \details
+ * Data passed to write() is copied into overflow pages, which are allocated
+ * through vol_t::alloc_a_page() as they fill up. Completed pages are logged
+ * and written to the volume in batches of contiguous page IDs. finish()
+ * writes the last page and returns the reference to the chain, which can
+ * then be stored with btree_m::put_large().
+ *
+ * If the writer is destroyed before finish() or the reference is never
+ * stored, the pages already allocated remain allocated.
+ */
+class overflow_writer_t {
+public:
+    overflow_writer_t(StoreID store);
+    ~overflow_writer_t();
+
+    rc_t write(const char* data, size_t length);
+
+    rc_t finish(overflow_ref_t& ref);
+
+    StoreID get_store() const { return store; }
+
+    /// Maximum number of pages written with a single I/O
+    static const size_t max_batch = 8;
+
+private:
+    StoreID store;
+    overflow_ref_t ref;
+    bool finished;
+
+    /// Aligned buffer of max_batch pages
+    generic_page* buffer;
+    /// Completed pages in the buffer
+    size_t batch_count;
+    /// Page being filled (buffer[batch_count]), 0 if none
+    PageID current_pid;
+
+    overflow_writer_t(const overflow_writer_t&);
+    overflow_writer_t& operator=(const overflow_writer_t&);
+
+    overflow_page* current()
+    {
+        return reinterpret_cast<overflow_page*>(&buffer[batch_count]);
+    }
+
+    void start_page(PageID pid);
+    rc_t complete_page(PageID next);
+    rc_t flush_batch();
+};
+
+/**
+ * \brief Streaming reader of a large value.
+ *
+ * \details
+ * Reads the chain of overflow pages of an overflow_ref_t, one page at a
+ * time, directly from the volume.
+ */
+class overflow_reader_t {
+public:
+    overflow_reader_t();
+    ~overflow_reader_t();
+
+    void open(const overflow_ref_t& ref);
+
+    /**
+     * Copies up to length bytes of the value into buf, continuing where the
+     * previous call stopped. The number of bytes copied, which is less than
+     * length only at the end of the value, is returned in done.
+     */
+    rc_t read(char* buf, size_t length, size_t& done);
+
+    uint64_t get_length() const { return ref.length; }
+
+    uint64_t remaining() const { return ref.length - position; }
+
+    bool eof() const { return position >= ref.length; }
+
+private:
+    overflow_ref_t ref;
+    uint64_t position;
+
+    overflow_page* page;
+    /// Page currently in the buffer, 0 if none
+    PageID page_pid;
+    /// Offset of the next byte to read in page
+    size_t page_offset;
+
+    overflow_reader_t(const overflow_reader_t&);
+    overflow_reader_t& operator=(const overflow_reader_t&);
+};
+
+/**
+ * Deallocates all pages of a chain. The deallocation is not undone if the
+ * calling transaction aborts.
+ */
+rc_t overflow_free(const overflow_ref_t& ref);
+
+#endif
@@ -451,6 +451,18 @@ bool btree_page_data::_items_are_consistent() const {
 }
 
 
+size_t btree_page_data::reclaimable_space() const {
+    size_t live = 0;
+    for (int i=0; i<nitems; i++) {
+        if (head[i].offset > 0) {
+            live += item_space(i);
+        }
+    }
+    w_assert1(data_sz >= live + usable_space());
+    return data_sz - live - usable_space();
+}
+
+
 void btree_page_data::compact() {
     w_assert3(_items_are_consistent());
 
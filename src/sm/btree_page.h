@@ -298,6 +298,13 @@ protected:
      */
     size_t        usable_space() const;
 
+    /**
+     * Return amount of space compact() would add to usable_space(),
+     * i.e., the space taken by ghost items plus the holes left behind
+     * by removed or shrunk item bodies.
+     */
+    size_t        reclaimable_space() const;
+
     /// compact item space, making all freed space available.
     void          compact();
 
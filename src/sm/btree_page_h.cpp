@@ -1980,6 +1980,38 @@ rc_t btree_page_h::compress(const w_keystr_t& low, const w_keystr_t& high,
     return RCOK;
 }
 
+rc_t btree_page_h::remove_range(const w_keystr_t& low, const w_keystr_t& high,
+        int& removed, bool redo)
+{
+    w_assert1 (is_fixed());
+    w_assert1 (is_leaf());
+    w_assert1 (latch_mode() == LATCH_EX);
+    if (!redo) {
+        w_assert1 (xct()->is_sys_xct());
+    }
+
+    bool found;
+    slotid_t from = 0;
+    if (!low.is_neginf() && compare_with_fence_low(low) > 0) {
+        search(low, found, from);
+    }
+    slotid_t to = nrecs();
+    if (!high.is_posinf() && compare_with_fence_high(high) < 0) {
+        search(high, found, to);
+    }
+
+    removed = 0;
+    if (from >= to) {
+        return RCOK;
+    }
+    if (!redo) {
+        W_DO(log_btree_remove_range(*this, low, high));
+    }
+    delete_range(from, to);
+    removed = to - from;
+    return RCOK;
+}
+
 bool btree_page_h::_check_space_for_insert(size_t data_length) {
     size_t contiguous_free_space = usable_space();
     return contiguous_free_space >= page()->predict_item_space(data_length);
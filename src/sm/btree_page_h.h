@@ -219,6 +219,9 @@ public:
     // Total usable space on page
     smsize_t                     usable_space()  const;
 
+    /// Space held by ghost records and holes; defrag() makes it usable
+    smsize_t                     reclaimable_space()  const;
+
 
 
 
@@ -761,6 +764,17 @@ public:
     rc_t compress(const w_keystr_t& low, const w_keystr_t& high,
             const w_keystr_t& chain, bool redo = false);
 
+    /**
+     * \brief Physically removes the records of this leaf whose keys are in
+     * [low, high), ghost or not.
+     * \details
+     * Only the two keys are logged, whatever the number of records removed.
+     * Context: System transaction, except when called from REDO.
+     * @param[out] removed number of records removed
+     */
+    rc_t remove_range(const w_keystr_t& low, const w_keystr_t& high,
+            int& removed, bool redo = false);
+
     /// stats for leaf nodes.
     rc_t             leaf_stats(btree_lf_stats_t& btree_lf);
     /// stats for interior nodes.
@@ -1320,6 +1334,11 @@ btree_page_h::usable_space() const {
     return page()->usable_space();
 }
 
+inline smsize_t
+btree_page_h::reclaimable_space() const {
+    return page()->reclaimable_space();
+}
+
 
 // ======================================================================
 //   BEGIN: Private record data packers inline implementation
@@ -0,0 +1,212 @@
+#include "w_defines.h"
+
+#define SM_SOURCE
+
+#include "btree_partition.h"
+
+#include "sm_base.h"
+#include "sm.h"
+#include "btree.h"
+#include "vec_t.h"
+
+#include <algorithm>
+
+/// Key of the only record in a map store
+static const char MAP_KEY[] = "partitions";
+
+/// FNV-1a; must stay stable since it decides where keys are stored
+static uint32_t hash_key(const w_keystr_t& key)
+{
+    const unsigned char* data = (const unsigned char*) key.buffer_as_keystr();
+    uint32_t hash = 2166136261U;
+    for (w_keystr_len_t i = 0; i < key.get_length_as_keystr(); ++i) {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+    return hash;
+}
+
+size_t partitioning_t::route(const w_keystr_t& key) const
+{
+    if (kind == t_hash) {
+        return hash_key(key) % stores.size();
+    }
+    return std::upper_bound(bounds.begin(), bounds.end(), key) - bounds.begin();
+}
+
+bool partitioning_t::overlaps(size_t i, const w_keystr_t& lower,
+        const w_keystr_t& upper) const
+{
+    if (kind == t_hash) {
+        return true;
+    }
+    if (i > 0 && upper < bounds[i - 1]) {
+        return false;
+    }
+    if (i < bounds.size() && bounds[i] <= lower) {
+        return false;
+    }
+    return true;
+}
+
+template <class T>
+static void append(std::string& out, T value)
+{
+    out.append((const char*) &value, sizeof(value));
+}
+
+template <class T>
+static bool consume(const char*& data, const char* end, T& value)
+{
+    if (data + sizeof(value) > end) {
+        return false;
+    }
+    ::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+void partitioning_t::serialize(std::string& out) const
+{
+    out.clear();
+    append<uint8_t>(out, kind);
+    append<uint32_t>(out, stores.size());
+    for (size_t i = 0; i < stores.size(); ++i) {
+        append<StoreID>(out, stores[i]);
+    }
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        append<w_keystr_len_t>(out, bounds[i].get_length_as_keystr());
+        out.append((const char*) bounds[i].buffer_as_keystr(),
+                bounds[i].get_length_as_keystr());
+    }
+}
+
+bool partitioning_t::deserialize(const char* data, smsize_t length)
+{
+    const char* end = data + length;
+    uint8_t k;
+    uint32_t count;
+    if (!consume(data, end, k) || !consume(data, end, count)
+            || (k != t_range && k != t_hash) || count == 0) {
+        return false;
+    }
+    kind = (kind_t) k;
+    stores.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!consume(data, end, stores[i])) {
+            return false;
+        }
+    }
+    bounds.resize(kind == t_range ? count - 1 : 0);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        w_keystr_len_t len;
+        if (!consume(data, end, len) || data + len > end) {
+            return false;
+        }
+        bounds[i].construct_from_keystr(data, len);
+        data += len;
+    }
+    return data == end;
+}
+
+partition_table_t::partition_table_t()
+{
+}
+
+partition_table_t::~partition_table_t()
+{
+    for (std::map<StoreID, partitioning_t*>::iterator it = _maps.begin();
+            it != _maps.end(); ++it) {
+        delete it->second;
+    }
+}
+
+rc_t partition_table_t::create(partitioning_t& map, uint32_t count,
+        StoreID& stid)
+{
+    if (count == 0 || (map.kind == partitioning_t::t_range
+                && map.bounds.size() + 1 != count)) {
+        return RC(eBADARGUMENT);
+    }
+    for (size_t i = 0; i < map.bounds.size(); ++i) {
+        if (!map.bounds[i].is_regular()
+                || (i > 0 && !(map.bounds[i - 1] < map.bounds[i]))) {
+            return RC(eBADARGUMENT);
+        }
+    }
+
+    map.stores.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        W_DO(ss_m::create_index(map.stores[i]));
+    }
+
+    StoreID map_stid;
+    W_DO(ss_m::create_index(map_stid));
+    w_assert1(!is_partitioned(map_stid));
+
+    std::string el;
+    map.serialize(el);
+    w_keystr_t key;
+    key.construct_regularkey(MAP_KEY, sizeof(MAP_KEY) - 1);
+    W_DO(smlevel_0::bt->insert(map_stid, key, cvec_t(el.data(), el.size())));
+
+    stid = map_stid | PARTITIONED_STORE;
+    return RCOK;
+}
+
+rc_t partition_table_t::_load(StoreID stid, partitioning_t& map)
+{
+    StoreID map_stid = stid & ~PARTITIONED_STORE;
+    if (map_stid >= stnode_page::max
+            || smlevel_0::vol->get_store_root(map_stid) == 0) {
+        return RC(eBADSTID);
+    }
+
+    w_keystr_t key;
+    key.construct_regularkey(MAP_KEY, sizeof(MAP_KEY) - 1);
+    std::vector<char> el(SM_PAGESIZE);
+    smsize_t elen = el.size();
+    bool found;
+    W_DO(smlevel_0::bt->lookup(map_stid, key, &el[0], elen, found));
+    if (!found || !map.deserialize(&el[0], elen)) {
+        return RC(eBADSTID);
+    }
+    return RCOK;
+}
+
+rc_t partition_table_t::get(StoreID stid, const partitioning_t*& map)
+{
+    w_assert1(is_partitioned(stid));
+    {
+        spinlock_read_critical_section cs(&_latch);
+        std::map<StoreID, partitioning_t*>::const_iterator it = _maps.find(stid);
+        if (it != _maps.end()) {
+            map = it->second;
+            return RCOK;
+        }
+    }
+
+    partitioning_t* loaded = new partitioning_t();
+    rc_t rc = _load(stid, *loaded);
+    if (rc.is_error()) {
+        delete loaded;
+        return rc;
+    }
+
+    spinlock_write_critical_section cs(&_latch);
+    std::pair<std::map<StoreID, partitioning_t*>::iterator, bool> ins
+        = _maps.insert(std::make_pair(stid, loaded));
+    if (!ins.second) {
+        // loaded concurrently by another thread
+        delete loaded;
+    }
+    map = ins.first->second;
+    return RCOK;
+}
+
+rc_t partition_table_t::route(StoreID& stid, const w_keystr_t& key)
+{
+    const partitioning_t* map;
+    W_DO(get(stid, map));
+    stid = map->stores[map->route(key)];
+    return RCOK;
+}
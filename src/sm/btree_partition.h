@@ -0,0 +1,107 @@
+#ifndef BTREE_PARTITION_H
+#define BTREE_PARTITION_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "w_key.h"
+#include "srwlock.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * \brief How the keys of a partitioned index are spread over its stores.
+ *
+ * \details
+ * A partitioned index is made of several ordinary Foster B-trees, its
+ * \e partitions, each in its own store with its own root page. Every key
+ * belongs to exactly one partition, chosen either by key range or by a hash
+ * of the key.
+ */
+struct partitioning_t {
+    enum kind_t {
+        /// Partition i holds the keys in [bounds[i-1], bounds[i])
+        t_range = 1,
+        /// Partition i holds the keys whose hash is i modulo the count
+        t_hash = 2
+    };
+
+    kind_t kind;
+
+    /// Stores of the partitions, in key order for range partitioning
+    std::vector<StoreID> stores;
+
+    /**
+     * Lowest key of each partition but the first, in increasing order.
+     * Only used by range partitioning.
+     */
+    std::vector<w_keystr_t> bounds;
+
+    /// Index of the partition holding the key
+    size_t route(const w_keystr_t& key) const;
+
+    /**
+     * Whether partition i may hold keys in [lower, upper]. Always true with
+     * hash partitioning.
+     */
+    bool overlaps(size_t i, const w_keystr_t& lower,
+            const w_keystr_t& upper) const;
+
+    void serialize(std::string& out) const;
+    bool deserialize(const char* data, smsize_t length);
+};
+
+/**
+ * \brief Partition maps of the partitioned indexes.
+ *
+ * \details
+ * A partitioned index is identified by the store ID of its \e map store with
+ * PARTITIONED_STORE set. The map store is a B-tree holding a single record,
+ * the serialized partitioning_t, written when the index is created (see
+ * ss_m::create_partitioned_index) and never modified afterwards. The high
+ * bit is never set in the ID of a physical store, whose number is bounded by
+ * stnode_page::max, so partitioned indexes are recognized without any lookup.
+ *
+ * The ss_m functions taking a key route it to the store of its partition
+ * before doing any work, and only lock and latch that store; a cursor over a
+ * partitioned index merges cursors over the partitions (see bt_cursor_t).
+ * Maps are read from their map store on first use and cached until shutdown.
+ */
+class partition_table_t {
+public:
+    static const StoreID PARTITIONED_STORE = 0x80000000;
+
+    static bool is_partitioned(StoreID stid) {
+        return (stid & PARTITIONED_STORE) != 0;
+    }
+
+    partition_table_t();
+    ~partition_table_t();
+
+    /**
+     * Creates the partition stores and the map store of a new partitioned
+     * index. The kind and bounds of the map must be set; its stores are
+     * filled in.
+     */
+    rc_t create(partitioning_t& map, uint32_t count, StoreID& stid);
+
+    /**
+     * Returns the map of a partitioned index. The map remains valid until
+     * shutdown.
+     */
+    rc_t get(StoreID stid, const partitioning_t*& map);
+
+    /// Replaces the ID of a partitioned index with that of the key's partition
+    rc_t route(StoreID& stid, const w_keystr_t& key);
+
+private:
+    /// Reads the map of a partitioned index from its map store
+    rc_t _load(StoreID stid, partitioning_t& map);
+
+    std::map<StoreID, partitioning_t*> _maps;
+    srwlock_t _latch;
+};
+
+#endif // BTREE_PARTITION_H
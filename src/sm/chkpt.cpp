@@ -75,6 +75,8 @@ struct RawLock;            // Lock information gathering
 #include "restart.h"
 #include "vol.h"
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
 #include "stopwatch.h"
 
@@ -119,6 +121,8 @@ chkpt_m::chkpt_m(const sm_options& options)
     : _chkpt_thread(NULL), _chkpt_count(0), _min_rec_lsn(0), _min_xct_lsn(0),
     _last_end_lsn(0)
 {
+    _use_log_scan = options.get_bool_option("sm_chkpt_use_log_scan", false);
+
     int interval = options.get_int_option("sm_chkpt_interval", -1);
     if (interval >= 0) {
         _chkpt_thread = new chkpt_thread_t(interval);
@@ -166,177 +170,342 @@ void chkpt_t::scan_log()
     // Set when scan finds begin of previous checkpoint
     lsn_t scan_stop = lsn_t(1,0);
 
-    // CS TODO: not needed with file serialization
-    // bool insideChkpt = false;
     while (lsn > scan_stop && scan.xct_next(lsn, r))
     {
-        if (r.is_skip() || r.type() == logrec_t::t_comment) {
-            continue;
+        if (analyze_logrec(lsn, r, true)) {
+            scan_stop = lsn;
         }
+    } //while
 
-        if (!r.tid().is_null()) {
-            if (r.tid() > get_highest_tid()) {
-                set_highest_tid(r.tid());
-            }
+    w_assert0(lsn == scan_stop);
 
-            if (r.is_page_update() || r.is_cpsn()) {
-                mark_xct_active(r.tid(), lsn, lsn);
+    cleanup();
+}
 
-                if (is_xct_active(r.tid())) {
-                    if (!r.is_cpsn()) { acquire_lock(r); }
-                }
-                else if (r.xid_prev().is_null()) {
-                    // We won't see this xct again -- delete it
-                    delete_xct(r.tid());
-                }
-            }
+/*
+ * Applies a log record found by a backward scan to the tables. If load_chkpt
+ * is set and the record is the begin of a checkpoint whose file is found, the
+ * file is loaded and true is returned, i.e., the scan can stop.
+ */
+bool chkpt_t::analyze_logrec(lsn_t lsn, logrec_t& r, bool load_chkpt)
+{
+    if (r.is_skip() || r.type() == logrec_t::t_comment) {
+        return false;
+    }
+
+    if (!r.tid().is_null()) {
+        if (r.tid() > get_highest_tid()) {
+            set_highest_tid(r.tid());
         }
 
-        if (r.is_page_update()) {
-            w_assert0(r.is_redo());
-            mark_page_dirty(r.pid(), lsn, lsn);
+        if (r.is_page_update() || r.is_cpsn()) {
+            mark_xct_active(r.tid(), lsn, lsn);
 
-            if (r.is_multi_page()) {
-                w_assert0(r.pid2() != 0);
-                mark_page_dirty(r.pid2(), lsn, lsn);
+            if (is_xct_active(r.tid())) {
+                if (!r.is_cpsn()) { acquire_lock(r); }
+            }
+            else if (r.xid_prev().is_null()) {
+                // We won't see this xct again -- delete it
+                delete_xct(r.tid());
             }
         }
+    }
 
-        switch (r.type())
-        {
-            case logrec_t::t_chkpt_begin:
-                // CS TODO: not needed with file serialization
-                // if (insideChkpt) {
-                //     // Signal to stop backward log scan loop now
-                //     scan_stop = lsn;
-                // }
-                {
-                    fs::path fpath = smlevel_0::log->get_storage()->make_chkpt_path(lsn);
-                    if (fs::exists(fpath)) {
-                        ifstream ifs(fpath.string(), ios::binary);
-                        deserialize_binary(ifs);
-                        ifs.close();
-                        scan_stop = lsn;
-                    }
-                }
+    if (r.is_page_update()) {
+        w_assert0(r.is_redo());
+        mark_page_dirty(r.pid(), lsn, lsn);
+
+        if (r.is_multi_page()) {
+            w_assert0(r.pid2() != 0);
+            mark_page_dirty(r.pid2(), lsn, lsn);
+        }
+    }
 
-                break;
-
-            case logrec_t::t_chkpt_bf_tab:
-                // CS TODO: not needed with file serialization
-                // if (insideChkpt) {
-                //     const chkpt_bf_tab_t* dp = (chkpt_bf_tab_t*) r.data();
-                //     for (uint i = 0; i < dp->count; i++) {
-                //         mark_page_dirty(dp->brec[i].pid, dp->brec[i].page_lsn,
-                //                 dp->brec[i].rec_lsn);
-                //     }
-                // }
-                break;
-
-
-            case logrec_t::t_chkpt_xct_lock:
-                // CS TODO: not needed with file serialization
-                // if (insideChkpt) {
-                //     const chkpt_xct_lock_t* dp = (chkpt_xct_lock_t*) r.data();
-                //     if (is_xct_active(dp->tid)) {
-                //         for (uint i = 0; i < dp->count; i++) {
-                //             add_lock(dp->tid, dp->xrec[i].lock_mode,
-                //                     dp->xrec[i].lock_hash);
-                //         }
-                //     }
-                // }
-                break;
-
-            case logrec_t::t_chkpt_xct_tab:
-                // CS TODO: not needed with file serialization
-                // if (insideChkpt) {
-                //     const chkpt_xct_tab_t* dp = (chkpt_xct_tab_t*) r.data();
-                //     for (size_t i = 0; i < dp->count; ++i) {
-                //         tid_t tid = dp->xrec[i].tid;
-                //         w_assert1(!tid.is_null());
-                //         mark_xct_active(tid, dp->xrec[i].first_lsn,
-                //                 dp->xrec[i].last_lsn);
-                //     }
-                // }
-                break;
-
-
-                // CS TODO: not needed with file serialization
-            // case logrec_t::t_chkpt_end:
-                // checkpoints should not run concurrently
-                // w_assert0(!insideChkpt);
-                // insideChkpt = true;
-                break;
-
-            // CS TODO: why do we need this? Isn't it related to 2PC?
-            // case logrec_t::t_xct_freeing_space:
-            case logrec_t::t_xct_end:
-            case logrec_t::t_xct_abort:
-                mark_xct_ended(r.tid());
-                break;
-
-            case logrec_t::t_xct_end_group:
-                {
-                    // CS TODO: is this type of group commit still used?
-                    w_assert0(false);
-                    const xct_list_t* list = (xct_list_t*) r.data();
-                    uint listlen = list->count;
-                    for(uint i=0; i<listlen; i++) {
-                        tid_t tid = list->xrec[i].tid;
-                        mark_xct_ended(tid);
-                    }
+    switch (r.type())
+    {
+        case logrec_t::t_chkpt_begin:
+            if (load_chkpt) {
+                fs::path fpath = smlevel_0::log->get_storage()->make_chkpt_path(lsn);
+                if (fs::exists(fpath)) {
+                    ifstream ifs(fpath.string(), ios::binary);
+                    deserialize_binary(ifs);
+                    ifs.close();
+                    return true;
                 }
-                break;
+            }
 
-            case logrec_t::t_page_write:
-                {
-                    char* pos = r.data();
+            break;
 
-                    PageID pid = *((PageID*) pos);
-                    pos += sizeof(PageID);
+        case logrec_t::t_chkpt_bf_tab:
+            // CS TODO: not needed with file serialization
+            // if (insideChkpt) {
+            //     const chkpt_bf_tab_t* dp = (chkpt_bf_tab_t*) r.data();
+            //     for (uint i = 0; i < dp->count; i++) {
+            //         mark_page_dirty(dp->brec[i].pid, dp->brec[i].page_lsn,
+            //                 dp->brec[i].rec_lsn);
+            //     }
+            // }
+            break;
 
-                    lsn_t clean_lsn = *((lsn_t*) pos);
-                    pos += sizeof(lsn_t);
 
-                    uint32_t count = *((uint32_t*) pos);
-                    PageID end = pid + count;
+        case logrec_t::t_chkpt_xct_lock:
+            // CS TODO: not needed with file serialization
+            // if (insideChkpt) {
+            //     const chkpt_xct_lock_t* dp = (chkpt_xct_lock_t*) r.data();
+            //     if (is_xct_active(dp->tid)) {
+            //         for (uint i = 0; i < dp->count; i++) {
+            //             add_lock(dp->tid, dp->xrec[i].lock_mode,
+            //                     dp->xrec[i].lock_hash);
+            //         }
+            //     }
+            // }
+            break;
+
+        case logrec_t::t_chkpt_xct_tab:
+            // CS TODO: not needed with file serialization
+            // if (insideChkpt) {
+            //     const chkpt_xct_tab_t* dp = (chkpt_xct_tab_t*) r.data();
+            //     for (size_t i = 0; i < dp->count; ++i) {
+            //         tid_t tid = dp->xrec[i].tid;
+            //         w_assert1(!tid.is_null());
+            //         mark_xct_active(tid, dp->xrec[i].first_lsn,
+            //                 dp->xrec[i].last_lsn);
+            //     }
+            // }
+            break;
+
+
+            // CS TODO: not needed with file serialization
+        // case logrec_t::t_chkpt_end:
+            // checkpoints should not run concurrently
+            // w_assert0(!insideChkpt);
+            // insideChkpt = true;
+            break;
+
+        // CS TODO: why do we need this? Isn't it related to 2PC?
+        // case logrec_t::t_xct_freeing_space:
+        case logrec_t::t_xct_end:
+        case logrec_t::t_xct_abort:
+            mark_xct_ended(r.tid());
+            break;
 
-                    while (pid < end) {
-                        mark_page_clean(pid, clean_lsn);
-                        pid++;
-                    }
+        case logrec_t::t_xct_end_group:
+            {
+                // CS TODO: is this type of group commit still used?
+                w_assert0(false);
+                const xct_list_t* list = (xct_list_t*) r.data();
+                uint listlen = list->count;
+                for(uint i=0; i<listlen; i++) {
+                    tid_t tid = list->xrec[i].tid;
+                    mark_xct_ended(tid);
                 }
-                break;
+            }
+            break;
+
+        case logrec_t::t_page_write:
+            {
+                char* pos = r.data();
+
+                PageID pid = *((PageID*) pos);
+                pos += sizeof(PageID);
 
-            case logrec_t::t_add_backup:
-                {
-                    const char* dev = (const char*)(r.data_ssx());
-                    add_backup(dev);
+                lsn_t clean_lsn = *((lsn_t*) pos);
+                pos += sizeof(lsn_t);
+
+                uint32_t count = *((uint32_t*) pos);
+                PageID end = pid + count;
+
+                while (pid < end) {
+                    mark_page_clean(pid, clean_lsn);
+                    pid++;
                 }
-                break;
+            }
+            break;
 
-            case logrec_t::t_chkpt_backup_tab:
-                // CS TODO
-                break;
+        case logrec_t::t_add_backup:
+            {
+                const char* dev = (const char*)(r.data_ssx());
+                add_backup(dev);
+            }
+            break;
 
-            case logrec_t::t_restore_begin:
-            case logrec_t::t_restore_end:
-            case logrec_t::t_restore_segment:
-            case logrec_t::t_chkpt_restore_tab:
-                // CS TODO - IMPLEMENT!
-                break;
+        case logrec_t::t_chkpt_backup_tab:
+            // CS TODO
+            break;
 
-            default:
-                break;
+        case logrec_t::t_restore_begin:
+        case logrec_t::t_restore_end:
+        case logrec_t::t_restore_segment:
+        case logrec_t::t_chkpt_restore_tab:
+            // CS TODO - IMPLEMENT!
+            break;
 
-        } //switch
-    } //while
+        default:
+            break;
 
-    w_assert0(lsn == scan_stop);
+    } //switch
+
+    return false;
+}
+
+/*
+ * Worker of chkpt_t::scan_log_parallel. Partitions are handed out through a
+ * shared counter, so that threads that happen to get short partitions simply
+ * pick up more of them.
+ */
+class chkpt_scan_thread_t : public smthread_t
+{
+public:
+    chkpt_scan_thread_t(vector<chkpt_t>& partials,
+            const vector<lsn_t>& scan_starts, lsn_t scan_stop,
+            std::atomic<size_t>& next)
+        : smthread_t(t_regular, "chkpt_scan", WAIT_NOT_USED),
+        partials(partials), scan_starts(scan_starts), scan_stop(scan_stop),
+        next(next)
+    {}
+
+    virtual void run()
+    {
+        while (true) {
+            size_t i = next++;
+            if (i >= partials.size()) { break; }
+            if (scan_starts[i].is_null()) { continue; }
+            partials[i].scan_partition(scan_starts[i], scan_stop);
+        }
+    }
+
+private:
+    vector<chkpt_t>& partials;
+    const vector<lsn_t>& scan_starts;
+    const lsn_t scan_stop;
+    std::atomic<size_t>& next;
+};
+
+void chkpt_t::scan_log_parallel(size_t thread_count)
+{
+    init();
+
+    lsn_t scan_end = smlevel_0::log->durable_lsn();
+    if (scan_end == lsn_t(1,0)) { return; }
+
+    // The set of checkpoint files tells directly where the scan must stop,
+    // so that the range to analyze is known upfront and can be split.
+    log_storage* storage = smlevel_0::log->get_storage();
+    lsn_t chkpt_lsn = storage->get_last_checkpoint();
+    lsn_t scan_stop = chkpt_lsn.is_null() ? lsn_t(1,0) : chkpt_lsn;
+    w_assert0(scan_stop <= scan_end);
+
+    // One backward scan per partition; entry 0 is the newest one
+    size_t count = scan_end.hi() - scan_stop.hi() + 1;
+    vector<lsn_t> scan_starts(count);
+    scan_starts[0] = scan_end;
+    for (size_t i = 1; i < count; i++) {
+        auto p = storage->get_partition(scan_end.hi() - i);
+        scan_starts[i] = p ? lsn_t(p->num(), p->get_size()) : lsn_t::null;
+    }
+
+    vector<chkpt_t> partials(count);
+    std::atomic<size_t> next(0);
+    if (thread_count > count) { thread_count = count; }
+
+    vector<unique_ptr<chkpt_scan_thread_t>> threads;
+    for (size_t i = 0; i < thread_count; i++) {
+        threads.emplace_back(new chkpt_scan_thread_t(partials, scan_starts,
+                    scan_stop, next));
+        W_COERCE(threads.back()->fork());
+    }
+    for (auto& t : threads) {
+        W_COERCE(t->join());
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        merge_older(partials[i]);
+    }
+
+    // As in scan_log, the checkpoint is applied last, i.e., as the oldest
+    // part of the log
+    if (!chkpt_lsn.is_null()) {
+        fs::path fpath = storage->make_chkpt_path(chkpt_lsn);
+        ifstream ifs(fpath.string(), ios::binary);
+        deserialize_binary(ifs);
+        ifs.close();
+    }
 
     cleanup();
 }
 
+/*
+ * Backward scan of a single log partition, from scan_start down to (and
+ * including) scan_stop or the beginning of the partition, whichever comes
+ * first. Checkpoint files are not loaded.
+ */
+void chkpt_t::scan_partition(lsn_t scan_start, lsn_t scan_stop)
+{
+    init();
+
+    log_i scan(*smlevel_0::log, scan_start, false); // false == backward scan
+    logrec_t r;
+    lsn_t lsn;
+
+    while (scan.xct_next(lsn, r))
+    {
+        if (lsn.hi() != scan_start.hi() || lsn < scan_stop) { break; }
+        analyze_logrec(lsn, r, false);
+    }
+}
+
+/*
+ * Folds the tables of an older part of the log into this one, giving the same
+ * result as if the backward scan that produced this object had continued into
+ * the older part.
+ */
+void chkpt_t::merge_older(const chkpt_t& older)
+{
+    if (older.highest_tid > highest_tid) { highest_tid = older.highest_tid; }
+
+    for (buf_tab_t::const_iterator it = older.buf_tab.begin();
+            it != older.buf_tab.end(); ++it)
+    {
+        const buf_tab_entry_t& o = it->second;
+        buf_tab_entry_t& e = buf_tab[it->first];
+
+        if (o.clean_lsn > e.clean_lsn) { e.clean_lsn = o.clean_lsn; }
+
+        // The older part only filtered its updates against its own clean
+        // LSN. Its smallest update is a valid rec_lsn only if it is not
+        // below the merged clean LSN; otherwise, if the page was still
+        // updated after that, rec_lsn is conservatively set to the clean
+        // LSN itself, which is never after the first update that counts.
+        if (o.page_lsn >= e.clean_lsn && o.rec_lsn != lsn_t::max) {
+            lsn_t rec_lsn = std::max(o.rec_lsn, e.clean_lsn);
+            if (rec_lsn < e.rec_lsn) { e.rec_lsn = rec_lsn; }
+        }
+        if (o.page_lsn > e.page_lsn) { e.page_lsn = o.page_lsn; }
+    }
+
+    for (xct_tab_t::const_iterator it = older.xct_tab.begin();
+            it != older.xct_tab.end(); ++it)
+    {
+        const xct_tab_entry_t& o = it->second;
+        xct_tab_entry_t& e = xct_tab[it->first];
+
+        if (o.state == xct_t::xct_ended) { e.state = xct_t::xct_ended; }
+        if (o.last_lsn > e.last_lsn) { e.last_lsn = o.last_lsn; }
+        if (o.first_lsn < e.first_lsn) { e.first_lsn = o.first_lsn; }
+
+        // Locks are only relevant for transactions that did not end
+        if (e.state != xct_t::xct_ended) {
+            e.locks.insert(e.locks.end(), o.locks.begin(), o.locks.end());
+        }
+        else {
+            e.locks.clear();
+        }
+    }
+
+    // scan_log keeps the oldest backup it finds
+    if (!older.bkp_path.empty()) { bkp_path = older.bkp_path; }
+}
+
 void chkpt_t::init()
 {
     highest_tid = tid_t::null;
@@ -487,7 +656,7 @@ void chkpt_t::serialize()
         pid.push_back(it->first);
         rec_lsn.push_back(it->second.rec_lsn);
         page_lsn.push_back(it->second.page_lsn);
-         if(pid.size()==chunk || &*it==&*buf_tab.rbegin()) {
+         if(pid.size()==chunk || std::next(it) == buf_tab.end()) {
             LOG_INSERT(chkpt_bf_tab_log(pid.size(), (const PageID*)(&pid[0]),
                                                     (const lsn_t*)(&rec_lsn[0]),
                                                     (const lsn_t*)(&page_lsn[0])), 0);
@@ -515,7 +684,7 @@ void chkpt_t::serialize()
         state.push_back(it->second.state);
         last_lsn.push_back(it->second.last_lsn);
         first_lsn.push_back(it->second.first_lsn);
-        if(tid.size()==chunk || &*it==&*xct_tab.rbegin()) {
+        if(tid.size()==chunk || std::next(it) == xct_tab.end()) {
             LOG_INSERT(chkpt_xct_tab_log(get_highest_tid(), tid.size(),
                                         (const tid_t*)(&tid[0]),
                                         (const smlevel_0::xct_state_t*)(&state[0]),
@@ -566,93 +735,79 @@ void chkpt_t::serialize()
     delete logrec;
 }
 
-void chkpt_t::acquire_lock(logrec_t& r)
+/*
+ * Appends to the given list the key locks that an update, described by the
+ * given log record, requires to be held exclusively until its transaction
+ * ends. Used to re-acquire the locks of active transactions at restart.
+ */
+static void get_update_locks(logrec_t& r, vector<lock_info_t>& locks)
 {
-    w_assert1(is_xct_active(r.tid()));
     w_assert1(!r.is_single_sys_xct());
     w_assert1(!r.is_multi_page());
     w_assert1(!r.is_cpsn());
     w_assert1(r.is_page_update());
 
+    auto add_key_lock = [&](const w_keystr_t& key) {
+        okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
+        lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
+                key.get_length_as_keystr());
+
+        lock_info_t entry;
+        entry.lock_mode = mode;
+        entry.lock_hash = lid.hash();
+        locks.push_back(entry);
+    };
+
+    w_keystr_t key;
     switch (r.type())
     {
         case logrec_t::t_btree_insert:
         case logrec_t::t_btree_insert_nonghost:
             {
                 btree_insert_t* dp = (btree_insert_t*) r.data();
-
-                w_keystr_t key;
                 key.construct_from_keystr(dp->data, dp->klen);
-
-                okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
-                lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
-                        key.get_length_as_keystr());
-
-                add_lock(r.tid(), mode, lid.hash());
+                add_key_lock(key);
             }
             break;
         case logrec_t::t_btree_update:
             {
                 btree_update_t* dp = (btree_update_t*) r.data();
-
-                w_keystr_t key;
                 key.construct_from_keystr(dp->_data, dp->_klen);
-
-                okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
-                lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
-                        key.get_length_as_keystr());
-
-                add_lock(r.tid(), mode, lid.hash());
+                add_key_lock(key);
             }
             break;
         case logrec_t::t_btree_overwrite:
             {
                 btree_overwrite_t* dp = (btree_overwrite_t*) r.data();
-
-                w_keystr_t key;
                 key.construct_from_keystr(dp->_data, dp->_klen);
-
-                okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
-                lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
-                        key.get_length_as_keystr());
-
-                add_lock(r.tid(), mode, lid.hash());
+                add_key_lock(key);
             }
             break;
         case logrec_t::t_btree_ghost_mark:
             {
                 btree_ghost_t* dp = (btree_ghost_t*) r.data();
                 for (size_t i = 0; i < dp->cnt; ++i) {
-                    w_keystr_t key (dp->get_key(i));
-
-                    okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
-                    lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
-                            key.get_length_as_keystr());
-
-                    add_lock(r.tid(), mode, lid.hash());
+                    add_key_lock(dp->get_key(i));
                 }
             }
             break;
         case logrec_t::t_btree_ghost_reserve:
             {
                 btree_ghost_reserve_t* dp = (btree_ghost_reserve_t*) r.data();
-
-                w_keystr_t key;
                 key.construct_from_keystr(dp->data, dp->klen);
-
-                okvl_mode mode = btree_impl::create_part_okvl(okvl_mode::X, key);
-                lockid_t lid (r.stid(), (const unsigned char*) key.buffer_as_keystr(),
-                        key.get_length_as_keystr());
-
-                add_lock(r.tid(), mode, lid.hash());
+                add_key_lock(key);
             }
             break;
         default:
             w_assert0(r.type() == logrec_t::t_page_img_format);
             break;
     }
+}
 
-    return;
+void chkpt_t::acquire_lock(logrec_t& r)
+{
+    w_assert1(is_xct_active(r.tid()));
+    get_update_locks(r, xct_tab[r.tid()].locks);
 }
 
 void chkpt_t::dump(ostream& os)
@@ -691,19 +846,29 @@ void chkpt_m::take()
     LOG_INSERT(chkpt_begin_log(lsn_t::null), &begin_lsn);
     W_COERCE(ss_m::log->flush_all());
 
-    // Collect checkpoint information from log
-    curr_chkpt.scan_log();
-
     // Serialize chkpt to file
     fs::path fpath = smlevel_0::log->get_storage()->make_chkpt_path(lsn_t::null);
     fs::path newpath = smlevel_0::log->get_storage()->make_chkpt_path(begin_lsn);
     ofstream ofs(fpath.string(), ios::binary | ios::trunc);
-    curr_chkpt.serialize_binary(ofs);
+
+    if (_use_log_scan) {
+        // Collect checkpoint information from log
+        curr_chkpt.scan_log();
+        curr_chkpt.serialize_binary(ofs);
+        _min_rec_lsn = curr_chkpt.get_min_rec_lsn();
+        _min_xct_lsn = curr_chkpt.get_min_xct_lsn();
+    }
+    else {
+        // Collect checkpoint information from buffer pool and xct list
+        curr_snapshot.collect(begin_lsn);
+        curr_snapshot.serialize_binary(ofs);
+        _min_rec_lsn = curr_snapshot.get_min_rec_lsn();
+        _min_xct_lsn = curr_snapshot.get_min_xct_lsn();
+    }
+
     ofs.close();
     fs::rename(fpath, newpath);
-
-    _min_rec_lsn = curr_chkpt.get_min_rec_lsn();
-    _min_xct_lsn = curr_chkpt.get_min_xct_lsn();
+    smlevel_0::log->get_storage()->add_checkpoint(begin_lsn);
 
     // Release the 'write' mutex so the next checkpoint request can come in
     chkpt_mutex.release_write();
@@ -711,13 +876,20 @@ void chkpt_m::take()
     delete logrec;
 }
 
-void chkpt_t::serialize_binary(ofstream& ofs)
+/*
+ * Binary checkpoint format shared by chkpt_t and chkpt_snapshot_t. The tables
+ * can be any sequence of (key, entry) pairs, which are written in the order
+ * given.
+ */
+template <class BufTab, class XctTab>
+static void serialize_tables(ofstream& ofs, const tid_t& highest_tid,
+        const BufTab& buf_tab, const XctTab& xct_tab, const string& bkp_path)
 {
     ofs.write((char*)&highest_tid, sizeof(tid_t));
 
     size_t buf_tab_size = buf_tab.size();
     ofs.write((char*)&buf_tab_size, sizeof(size_t));
-    for(buf_tab_t::const_iterator it = buf_tab.begin();
+    for(typename BufTab::const_iterator it = buf_tab.begin();
             it != buf_tab.end(); ++it)
     {
         ofs.write((char*)&it->first, sizeof(PageID));
@@ -726,7 +898,7 @@ void chkpt_t::serialize_binary(ofstream& ofs)
 
     size_t xct_tab_size = xct_tab.size();
     ofs.write((char*)&xct_tab_size, sizeof(size_t));
-    for(xct_tab_t::const_iterator it=xct_tab.begin();
+    for(typename XctTab::const_iterator it=xct_tab.begin();
             it != xct_tab.end(); ++it)
     {
         ofs.write((char*)&it->first, sizeof(tid_t));
@@ -739,17 +911,22 @@ void chkpt_t::serialize_binary(ofstream& ofs)
         for(vector<lock_info_t>::const_iterator jt = it->second.locks.begin();
                 jt != it->second.locks.end(); ++jt)
         {
-            ofs.write((char*)&jt, sizeof(lock_info_t));
+            ofs.write((char*)&(*jt), sizeof(lock_info_t));
         }
     }
 
     size_t bkp_path_size = bkp_path.size();
     ofs.write((char*)&bkp_path_size, sizeof(size_t));
     if (!bkp_path.empty()) {
-        ofs.write((char*)&bkp_path, bkp_path.size());
+        ofs.write(bkp_path.data(), bkp_path.size());
     }
 }
 
+void chkpt_t::serialize_binary(ofstream& ofs)
+{
+    serialize_tables(ofs, highest_tid, buf_tab, xct_tab, bkp_path);
+}
+
 void chkpt_t::deserialize_binary(ifstream& ifs)
 {
     if(!ifs.is_open()) {
@@ -794,31 +971,175 @@ void chkpt_t::deserialize_binary(ifstream& ifs)
 
         if (entry.state != smlevel_0::xct_ended) {
             mark_xct_active(tid, entry.first_lsn, entry.last_lsn);
+        }
 
-            if (is_xct_active(tid)) {
-                size_t lock_tab_size;
-                ifs.read((char*)&lock_tab_size, sizeof(size_t));
-                for(uint j=0; j<lock_tab_size; j++) {
-                    lock_info_t lock_entry;
-                    ifs.read((char*)&lock_entry, sizeof(lock_info_t));
-                    // entry.locks.push_back(lock_entry);
-                    add_lock(tid, lock_entry.lock_mode, lock_entry.lock_hash);
-
-                    DBGOUT1(<< "    lock_mode[]="<<lock_entry.lock_mode
-                            << " , lock_hash[]="<<lock_entry.lock_hash);
-                }
-            }
-            // xct_tab[tid] = entry;
+        // lock list is always serialized, even if empty
+        size_t lock_tab_size;
+        ifs.read((char*)&lock_tab_size, sizeof(size_t));
+        for(uint j=0; j<lock_tab_size; j++) {
+            lock_info_t lock_entry;
+            ifs.read((char*)&lock_entry, sizeof(lock_info_t));
+            // add_lock ignores transactions that are not active
+            add_lock(tid, lock_entry.lock_mode, lock_entry.lock_hash);
+
+            DBGOUT1(<< "    lock_mode[]="<<lock_entry.lock_mode
+                    << " , lock_hash[]="<<lock_entry.lock_hash);
         }
     }
 
     size_t bkp_path_size;
     ifs.read((char*)&bkp_path_size, sizeof(size_t));
-    if (!bkp_path.empty()) {
-        ifs.read((char*)&bkp_path, bkp_path_size);
+    if (bkp_path_size > 0) {
+        bkp_path.resize(bkp_path_size);
+        ifs.read(&bkp_path[0], bkp_path_size);
     }
 }
 
+void chkpt_snapshot_t::collect(lsn_t begin_lsn)
+{
+    highest_tid = xct_t::youngest_tid();
+    buf_tab.clear();
+    xct_tab.clear();
+    bkp_path.clear();
+
+    collect_buf_tab();
+    collect_xct_tab();
+
+    // Collect locks of transactions that were active before the checkpoint.
+    // Their log records after begin_lsn are analyzed at restart anyway.
+    W_COERCE(smlevel_0::log->flush_all());
+    for (xct_array_t::iterator it = xct_tab.begin(); it != xct_tab.end(); ++it) {
+        collect_locks(it->second, begin_lsn);
+    }
+
+    if (smlevel_0::vol) {
+        vector<string> backups;
+        smlevel_0::vol->list_backups(backups);
+        if (!backups.empty()) { bkp_path = backups.back(); }
+    }
+}
+
+void chkpt_snapshot_t::collect_buf_tab()
+{
+    bf_tree_m* bf = smlevel_0::bf;
+    if (!bf) { return; }
+
+    PageID pid;
+    buf_tab_entry_t entry;
+    for (bf_idx idx = 1; idx < bf->get_block_cnt(); idx++) {
+        if (bf->get_rec_lsn(idx, pid, entry.page_lsn, entry.rec_lsn)) {
+            buf_tab.push_back(make_pair(pid, entry));
+        }
+    }
+
+    std::sort(buf_tab.begin(), buf_tab.end(),
+        [] (const buf_array_t::value_type& a, const buf_array_t::value_type& b)
+        {
+            return a.first < b.first;
+        });
+
+    // A concurrent eviction and re-fix may yield the same page twice, in
+    // which case we conservatively merge the entries
+    size_t j = 0;
+    for (size_t i = 1; i < buf_tab.size(); i++) {
+        if (buf_tab[i].first == buf_tab[j].first) {
+            buf_tab_entry_t& e = buf_tab[j].second;
+            const buf_tab_entry_t& dup = buf_tab[i].second;
+            if (dup.page_lsn > e.page_lsn) { e.page_lsn = dup.page_lsn; }
+            if (dup.rec_lsn < e.rec_lsn) { e.rec_lsn = dup.rec_lsn; }
+        }
+        else {
+            buf_tab[++j] = buf_tab[i];
+        }
+    }
+    if (!buf_tab.empty()) { buf_tab.resize(j + 1); }
+}
+
+void chkpt_snapshot_t::collect_xct_tab()
+{
+    xct_i iter(true); // lock list only while copying
+    xct_t* xd = NULL;
+    while ((xd = iter.next())) {
+        // Transactions which are already freeing space have inserted (or are
+        // about to insert) their commit log record and are not considered
+        // losers, just like in the log scan. Transactions without log
+        // records are also irrelevant to restart.
+        smlevel_0::xct_state_t state = xd->state();
+        if (state == smlevel_0::xct_ended || state == smlevel_0::xct_stale
+                || state == smlevel_0::xct_freeing_space
+                || xd->is_sys_xct() || xd->first_lsn().is_null())
+        {
+            continue;
+        }
+
+        xct_tab_entry_t entry;
+        entry.state = smlevel_0::xct_active;
+        entry.first_lsn = xd->first_lsn();
+        entry.last_lsn = xd->last_lsn();
+        xct_tab.push_back(make_pair(xd->tid(), entry));
+    }
+
+    std::sort(xct_tab.begin(), xct_tab.end(),
+        [] (const xct_array_t::value_type& a, const xct_array_t::value_type& b)
+        {
+            return a.first < b.first;
+        });
+}
+
+void chkpt_snapshot_t::collect_locks(xct_tab_entry_t& entry, lsn_t begin_lsn)
+{
+    if (entry.first_lsn >= begin_lsn) { return; }
+
+    // Follow the transaction's own chain of log records, which is much
+    // shorter than the log between two checkpoints
+    logrec_t* lr = new logrec_t;
+    lsn_t lsn = entry.last_lsn;
+    while (!lsn.is_null() && lsn >= entry.first_lsn) {
+        W_COERCE(smlevel_0::log->fetch(lsn, lr, NULL, true));
+        logrec_t& r = *lr;
+        if (lsn < begin_lsn && r.is_page_update() && !r.is_cpsn()
+                && !r.is_multi_page() && !r.is_single_sys_xct())
+        {
+            get_update_locks(r, entry.locks);
+        }
+        lsn = r.xid_prev();
+    }
+    delete lr;
+}
+
+lsn_t chkpt_snapshot_t::get_min_rec_lsn() const
+{
+    lsn_t min_rec_lsn = lsn_t::max;
+    for (buf_array_t::const_iterator it = buf_tab.begin();
+            it != buf_tab.end(); ++it)
+    {
+        if (min_rec_lsn > it->second.rec_lsn) {
+            min_rec_lsn = it->second.rec_lsn;
+        }
+    }
+    if (min_rec_lsn == lsn_t::max) { return lsn_t::null; }
+    return min_rec_lsn;
+}
+
+lsn_t chkpt_snapshot_t::get_min_xct_lsn() const
+{
+    lsn_t min_xct_lsn = lsn_t::max;
+    for (xct_array_t::const_iterator it = xct_tab.begin();
+            it != xct_tab.end(); ++it)
+    {
+        if (min_xct_lsn > it->second.first_lsn) {
+            min_xct_lsn = it->second.first_lsn;
+        }
+    }
+    if (min_xct_lsn == lsn_t::max) { return lsn_t::null; }
+    return min_xct_lsn;
+}
+
+void chkpt_snapshot_t::serialize_binary(ofstream& ofs) const
+{
+    serialize_tables(ofs, highest_tid, buf_tab, xct_tab, bkp_path);
+}
+
 chkpt_thread_t::chkpt_thread_t(int interval)
     : smthread_t(t_time_critical, "chkpt", WAIT_NOT_USED),
     _wakeup(false), _retire(false), _interval(interval)
@@ -69,6 +69,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <limits>
 
@@ -99,8 +100,15 @@ struct xct_tab_entry_t {
         state(xct_t::xct_active), last_lsn(lsn_t::null), first_lsn(lsn_t::max) {}
 };
 
-typedef map<PageID, buf_tab_entry_t>       buf_tab_t;
-typedef map<tid_t, xct_tab_entry_t>        xct_tab_t;
+struct tid_hash_t {
+    size_t operator()(const tid_t& tid) const
+    {
+        return std::hash<tid_t::datum_t>()(tid.as_int64());
+    }
+};
+
+typedef unordered_map<PageID, buf_tab_entry_t>             buf_tab_t;
+typedef unordered_map<tid_t, xct_tab_entry_t, tid_hash_t>  xct_tab_t;
 
 class chkpt_t {
     friend class chkpt_m;
@@ -115,6 +123,14 @@ public: // required for restart for now
 public:
     void scan_log();
 
+    /**
+     * Same result as scan_log(), but each log partition between the last
+     * checkpoint and the end of the log is analyzed by its own backward scan,
+     * running on up to thread_count threads. The per-partition tables are
+     * then merged from newest to oldest.
+     */
+    void scan_log_parallel(size_t thread_count);
+
     void mark_page_dirty(PageID pid, lsn_t page_lsn, lsn_t rec_lsn);
     void mark_page_clean(PageID pid, lsn_t lsn);
 
@@ -141,9 +157,61 @@ private:
     void deserialize_binary(ifstream& ofs);
     void cleanup();
     void acquire_lock(logrec_t& r);
+
+    bool analyze_logrec(lsn_t lsn, logrec_t& r, bool load_chkpt);
+    void scan_partition(lsn_t scan_start, lsn_t scan_stop);
+    void merge_older(const chkpt_t& older);
+
+    friend class chkpt_scan_thread_t;
 };
 
 
+/**
+ * \brief Compact checkpoint image collected without a log scan.
+ *
+ * \details
+ * Instead of reconstructing the dirty page and transaction tables by scanning
+ * the log backwards (see chkpt_t::scan_log), this class takes them directly
+ * from the buffer-pool control blocks (see bf_tree_m::get_rec_lsn) and from
+ * the list of live transactions. Collection is fuzzy, i.e., no latches are
+ * acquired and transactions keep running; anything that changes after the
+ * chkpt_begin log record is covered by the log that follows it, which is
+ * exactly the part analyzed at restart.
+ *
+ * Both tables are kept as arrays sorted on their key. This is also the order
+ * in which they are serialized, so the resulting file is identical to the one
+ * produced from a chkpt_t and can be loaded by chkpt_t::deserialize_binary.
+ */
+class chkpt_snapshot_t {
+public:
+    typedef vector<pair<PageID, buf_tab_entry_t> > buf_array_t;
+    typedef vector<pair<tid_t, xct_tab_entry_t> >  xct_array_t;
+
+    /**
+     * Collects the checkpoint image; begin_lsn is the LSN of the chkpt_begin
+     * log record, which must be durable.
+     */
+    void collect(lsn_t begin_lsn);
+
+    void serialize_binary(ofstream& ofs) const;
+
+    lsn_t get_min_rec_lsn() const;
+    lsn_t get_min_xct_lsn() const;
+
+    const buf_array_t& get_buf_tab() const { return buf_tab; }
+    const xct_array_t& get_xct_tab() const { return xct_tab; }
+
+private:
+    tid_t highest_tid;
+    buf_array_t buf_tab;
+    xct_array_t xct_tab;
+    string bkp_path;
+
+    void collect_buf_tab();
+    void collect_xct_tab();
+    void collect_locks(xct_tab_entry_t& entry, lsn_t begin_lsn);
+};
+
 class chkpt_thread_t;
 
 /*********************************************************************
@@ -194,6 +262,14 @@ private:
     chkpt_t          curr_chkpt;
     occ_rwlock       chkpt_mutex;
 
+    /**
+     * Whether to collect the checkpoint by scanning the log backwards
+     * (chkpt_t::scan_log) rather than from the buffer pool and transaction
+     * list (chkpt_snapshot_t). Option sm_chkpt_use_log_scan.
+     */
+    bool             _use_log_scan;
+    chkpt_snapshot_t curr_snapshot;
+
     void             _acquire_lock(logrec_t& r, chkpt_t& new_chkpt);
 
     // Values cached from the last checkpoint
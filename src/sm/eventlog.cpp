@@ -1,5 +1,6 @@
 #include "eventlog.h"
 #include "log_core.h"
+#include "eventtrace.h"
 
 #include "logdef_gen.cpp"
 
@@ -20,6 +21,13 @@ void sysevent::log(logrec_t::kind_t kind)
 
 void sysevent::log_page_read(PageID shpid, uint32_t count)
 {
+    // Page reads are pure instrumentation: if tracing is enabled, keep them
+    // out of the log
+    if (smlevel_0::tracer) {
+        smlevel_0::tracer->record(trace_event_t::page_read, shpid, count);
+        return;
+    }
+
     logrec_t* lr = new logrec_t();
     lr->header._type = logrec_t::t_page_read;
     lr->header._cat = 0 | logrec_t::t_status;
@@ -33,6 +41,10 @@ void sysevent::log_page_read(PageID shpid, uint32_t count)
 
 void sysevent::log_page_write(PageID shpid, lsn_t lsn, uint32_t count)
 {
+    // Still logged below, since checkpoints use it to clean the dirty page
+    // table
+    event_tracer::trace(trace_event_t::page_write, shpid, count, lsn);
+
     logrec_t* lr = new logrec_t();
     lr->header._type = logrec_t::t_page_write;
     lr->header._cat = 0 | logrec_t::t_status;
@@ -0,0 +1,249 @@
+#include "eventtrace.h"
+
+#include "smthread.h"
+
+#include <condition_variable>
+#include <cstring>
+
+const char* const trace_event_t::names[trace_event_t::type_count] = {
+    NULL,
+    "page_read",
+    "page_write",
+    "page_evict",
+    "dropped"
+};
+
+const char trace_file_header_t::MAGIC[8] = "ZTRACE";
+
+trace_ring_t::trace_ring_t(uint32_t thread, size_t capacity)
+    : orphan(false), _thread(thread), _mask(capacity - 1),
+    _events(capacity), _head(0), _tail(0), _dropped(0),
+    _dropped_reported(0)
+{
+    // capacity must be a power of two
+    w_assert0(capacity > 0 && (capacity & (capacity - 1)) == 0);
+}
+
+size_t trace_ring_t::drain(std::vector<trace_event_t>& out)
+{
+    uint64_t t = _tail.load(std::memory_order_relaxed);
+    uint64_t h = _head.load(std::memory_order_acquire);
+    for (uint64_t i = t; i < h; i++) {
+        out.push_back(_events[i & _mask]);
+    }
+    _tail.store(h, std::memory_order_release);
+    return h - t;
+}
+
+uint64_t trace_ring_t::take_dropped()
+{
+    uint64_t d = _dropped.load(std::memory_order_relaxed);
+    uint64_t ret = d - _dropped_reported;
+    _dropped_reported = d;
+    return ret;
+}
+
+/*
+ * Each thread keeps a reference to its ring in the tracer that created it.
+ * If the SM is restarted within the same process, the tracer id changes
+ * and the thread registers a new ring on its next event. When the thread
+ * exits, the ring is marked as orphan so that the flusher can drop it.
+ */
+struct trace_ring_holder_t {
+    std::shared_ptr<trace_ring_t> ring;
+    uint64_t tracer_id = 0;
+
+    ~trace_ring_holder_t()
+    {
+        if (ring) { ring->orphan.store(true, std::memory_order_release); }
+    }
+};
+
+static thread_local trace_ring_holder_t tls_trace_ring;
+static std::atomic<uint64_t> next_tracer_id(1);
+
+// rings are indexed with a mask, so round capacity up to a power of two
+static size_t ring_capacity(int events)
+{
+    size_t cap = 1;
+    while (cap < (size_t) events) { cap <<= 1; }
+    return cap;
+}
+
+class trace_flusher_thread_t : public smthread_t
+{
+public:
+    trace_flusher_thread_t(event_tracer* tracer, int interval_ms)
+        : smthread_t(t_regular, "trace_flusher"), tracer(tracer),
+        interval_ms(interval_ms), stop(false)
+    {}
+
+    virtual ~trace_flusher_thread_t() {}
+
+    void run()
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lck(mutex);
+                cond.wait_for(lck, std::chrono::milliseconds(interval_ms),
+                        [this] { return stop; });
+                if (stop) { break; }
+            }
+            tracer->flush();
+        }
+        tracer->flush();
+    }
+
+    void shutdown()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        stop = true;
+        cond.notify_one();
+    }
+
+private:
+    event_tracer* tracer;
+    int interval_ms;
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+event_tracer::event_tracer(const sm_options& options)
+    : _id(next_tracer_id++),
+    _ring_capacity(ring_capacity(
+                options.get_int_option("sm_trace_ring_size", 16384))),
+    _start(std::chrono::steady_clock::now()),
+    _next_thread(0), _flusher(NULL), _started(false)
+{
+    std::string path = options.get_string_option("sm_trace_file", "");
+    w_assert0(!path.empty());
+
+    _out.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_out) {
+        W_FATAL_MSG(eOS, << "Could not open trace file " << path);
+    }
+
+    trace_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, trace_file_header_t::MAGIC, sizeof(header.magic));
+    header.version = trace_file_header_t::FORMAT_VERSION;
+    header.event_size = sizeof(trace_event_t);
+    header.start_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    _out.write((const char*) &header, sizeof(header));
+
+    _flusher = new trace_flusher_thread_t(this,
+            options.get_int_option("sm_trace_flush_interval", 100));
+}
+
+event_tracer::~event_tracer()
+{
+    shutdown();
+    delete _flusher;
+    _out.close();
+}
+
+void event_tracer::start()
+{
+    W_COERCE(_flusher->fork());
+    _started = true;
+}
+
+void event_tracer::shutdown()
+{
+    if (_started) {
+        _flusher->shutdown();
+        W_COERCE(_flusher->join());
+        _started = false;
+    }
+    flush();
+}
+
+trace_ring_t* event_tracer::_my_ring()
+{
+    if (tls_trace_ring.tracer_id == _id) {
+        return tls_trace_ring.ring.get();
+    }
+    return _register_thread();
+}
+
+trace_ring_t* event_tracer::_register_thread()
+{
+    std::unique_lock<std::mutex> lck(_rings_mutex);
+    auto ring = std::make_shared<trace_ring_t>(_next_thread++, _ring_capacity);
+    _rings.push_back(ring);
+    lck.unlock();
+
+    // a ring of a previous tracer is released by its owner here
+    if (tls_trace_ring.ring) {
+        tls_trace_ring.ring->orphan.store(true, std::memory_order_release);
+    }
+    tls_trace_ring.ring = ring;
+    tls_trace_ring.tracer_id = _id;
+    return ring.get();
+}
+
+void event_tracer::flush()
+{
+    std::unique_lock<std::mutex> flck(_file_mutex);
+    _flush_buf.clear();
+
+    {
+        std::unique_lock<std::mutex> lck(_rings_mutex);
+        auto it = _rings.begin();
+        while (it != _rings.end()) {
+            trace_ring_t* ring = it->get();
+            // check orphan before draining, so the last events are not lost
+            bool orphan = ring->orphan.load(std::memory_order_acquire);
+            ring->drain(_flush_buf);
+
+            uint64_t dropped = ring->take_dropped();
+            if (dropped > 0) {
+                trace_event_t e;
+                memset(&e, 0, sizeof(e));
+                e.ts = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - _start).count();
+                e.thread = ring->thread();
+                e.type = trace_event_t::dropped;
+                e.count = dropped;
+                _flush_buf.push_back(e);
+            }
+
+            if (orphan) {
+                it = _rings.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+    }
+
+    if (!_flush_buf.empty()) {
+        _out.write((const char*) &_flush_buf[0],
+                _flush_buf.size() * sizeof(trace_event_t));
+        _out.flush();
+    }
+}
+
+trace_reader_t::trace_reader_t(const std::string& path)
+    : _in(path.c_str(), std::ios::in | std::ios::binary)
+{
+    if (!_in) {
+        W_FATAL_MSG(eOS, << "Could not open trace file " << path);
+    }
+    _in.read((char*) &_header, sizeof(_header));
+    if (!_in || memcmp(_header.magic, trace_file_header_t::MAGIC,
+                sizeof(_header.magic)) != 0
+            || _header.version != trace_file_header_t::FORMAT_VERSION
+            || _header.event_size != sizeof(trace_event_t))
+    {
+        W_FATAL_MSG(eBADARGUMENT, << "Invalid trace file " << path);
+    }
+}
+
+bool trace_reader_t::next(trace_event_t& e)
+{
+    _in.read((char*) &e, sizeof(e));
+    return (bool) _in;
+}
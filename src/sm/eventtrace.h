@@ -0,0 +1,202 @@
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include "w_defines.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sm_base.h"
+#include "sm_options.h"
+#include "lsn.h"
+
+/**
+ * \brief Fixed-size binary record of a traced event.
+ *
+ * \details
+ * Timestamps are nanoseconds of the steady clock relative to the start of
+ * the tracer, whose wall-clock time is kept in the file header. The
+ * thread number is assigned by the tracer when a thread records its first
+ * event; it is not an OS thread id.
+ */
+struct trace_event_t {
+    enum type_t {
+        page_read = 1,
+        page_write = 2,
+        page_evict = 3,
+        /// Events lost by a thread because its ring was full (count field)
+        dropped = 4,
+        type_count
+    };
+
+    static const char* const names[type_count];
+
+    uint64_t ts;
+    uint32_t thread;
+    uint16_t type;
+    uint16_t _fill;
+    PageID   pid;
+    uint32_t count;
+    uint64_t lsn;
+
+    static const char* type_name(uint16_t type)
+    {
+        return type < type_count && names[type] ? names[type] : "unknown";
+    }
+};
+
+/**
+ * \brief Header at the beginning of every trace file.
+ */
+struct trace_file_header_t {
+    static const char MAGIC[8];
+    static const uint32_t FORMAT_VERSION = 1;
+
+    char     magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    /// Wall-clock time (microseconds since the Unix epoch) of timestamp 0
+    uint64_t start_usec;
+};
+
+/**
+ * \brief Single-producer, single-consumer ring of trace events.
+ *
+ * \details
+ * Each thread pushes into its own ring without any locks or atomic
+ * read-modify-write operations; the flusher thread is the only consumer.
+ * When the ring is full, events are counted as dropped instead of
+ * blocking the producer.
+ */
+class trace_ring_t {
+public:
+    trace_ring_t(uint32_t thread, size_t capacity);
+
+    bool push(const trace_event_t& e)
+    {
+        uint64_t h = _head.load(std::memory_order_relaxed);
+        if (h - _tail.load(std::memory_order_acquire) >= _events.size()) {
+            _dropped.store(_dropped.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+            return false;
+        }
+        _events[h & _mask] = e;
+        _head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Appends all pending events to out; returns how many were appended
+    size_t drain(std::vector<trace_event_t>& out);
+
+    /// Returns and resets the number of events dropped since last call
+    uint64_t take_dropped();
+
+    uint32_t thread() const { return _thread; }
+
+    /// Set when the owning thread exits; ring is released once drained
+    std::atomic<bool> orphan;
+
+private:
+    const uint32_t _thread;
+    const uint64_t _mask;
+    std::vector<trace_event_t> _events;
+    std::atomic<uint64_t> _head;
+    std::atomic<uint64_t> _tail;
+    std::atomic<uint64_t> _dropped;
+    uint64_t _dropped_reported;
+};
+
+class trace_flusher_thread_t;
+
+/**
+ * \brief Low-overhead binary event tracing (I/O and eviction).
+ *
+ * \details
+ * Replaces the instrumentation log records of sysevent (page reads) with
+ * events kept in per-thread lock-free rings, which a background thread
+ * appends to a separate trace file. Tracing therefore consumes neither log
+ * bandwidth nor log insertion slots. Page writes are still logged by
+ * sysevent because checkpoints rely on them, but are traced as well.
+ *
+ * Enabled with the option sm_trace_file; the file can be converted to CSV
+ * or to the Chrome trace format with the "tracecat" command.
+ */
+class event_tracer {
+public:
+    event_tracer(const sm_options& options);
+    ~event_tracer();
+
+    void start();
+    void shutdown();
+
+    void record(trace_event_t::type_t type, PageID pid,
+            uint32_t count = 1, lsn_t lsn = lsn_t::null)
+    {
+        trace_event_t e;
+        e.ts = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - _start).count();
+        e.type = type;
+        e._fill = 0;
+        e.pid = pid;
+        e.count = count;
+        e.lsn = lsn.data();
+
+        trace_ring_t* ring = _my_ring();
+        e.thread = ring->thread();
+        ring->push(e);
+    }
+
+    /// Drains all rings and appends their events to the trace file
+    void flush();
+
+    /// Convenience wrapper that does nothing when tracing is disabled
+    static void trace(trace_event_t::type_t type, PageID pid,
+            uint32_t count = 1, lsn_t lsn = lsn_t::null)
+    {
+        if (smlevel_0::tracer) {
+            smlevel_0::tracer->record(type, pid, count, lsn);
+        }
+    }
+
+private:
+    trace_ring_t* _my_ring();
+    trace_ring_t* _register_thread();
+
+    const uint64_t _id;
+    const size_t _ring_capacity;
+    const std::chrono::steady_clock::time_point _start;
+
+    std::mutex _rings_mutex;
+    std::vector<std::shared_ptr<trace_ring_t>> _rings;
+    uint32_t _next_thread;
+
+    std::mutex _file_mutex;
+    std::ofstream _out;
+    std::vector<trace_event_t> _flush_buf;
+
+    trace_flusher_thread_t* _flusher;
+    bool _started;
+};
+
+/**
+ * \brief Sequential reader of a trace file written by event_tracer.
+ */
+class trace_reader_t {
+public:
+    trace_reader_t(const std::string& path);
+
+    bool next(trace_event_t& e);
+
+    const trace_file_header_t& header() const { return _header; }
+
+private:
+    std::ifstream _in;
+    trace_file_header_t _header;
+};
+
+#endif
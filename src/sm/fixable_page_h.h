@@ -115,6 +115,14 @@ public:
      */
     w_rc_t refix_direct(bf_idx idx, latch_mode_t mode, bool conditional=false);
 
+    /**
+     * Latches a page that was read optimistically (see
+     * bf_tree_m::optimistic_read_begin()) under the given frame version.
+     * Returns eLATCHQFAIL, leaving this handle unfixed, if the page changed
+     * since that version.
+     */
+    w_rc_t fix_optimistic(bf_idx idx, uint32_t version, latch_mode_t mode);
+
     /**
      * Fixes an existing (not virgin) root page for the given store.  This method doesn't
      * receive page ID because it's already known by bufferpool.
@@ -90,6 +90,7 @@ enum page_tag_t {
     t_alloc_p  = 1,        ///< free-page allocation page
     t_stnode_p = 2,        ///< store node page
     t_btree_p  = 5,        ///< btree page
+    t_overflow_p = 6,      ///< overflow page of a large btree value
 };
 
 
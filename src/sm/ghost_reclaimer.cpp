@@ -0,0 +1,131 @@
+#include "w_defines.h"
+
+#define SM_SOURCE
+
+#include "ghost_reclaimer.h"
+
+#include "bf_tree.h"
+#include "btree_page_h.h"
+#include "btree_impl.h"
+#include "log_core.h"
+#include "log_lsn_tracker.h"
+#include "restart.h"
+
+#include <vector>
+
+ghost_reclaimer_t::ghost_reclaimer_t(const sm_options& options)
+    : worker_thread_t(options.get_int_option(
+                "sm_ghost_reclaim_interval_millisec", 1000))
+{
+    int threshold = options.get_int_option("sm_ghost_reclaim_threshold", 25);
+    w_assert0(threshold > 0 && threshold <= 100);
+    _min_reclaimable = btree_page_data::data_sz * threshold / 100;
+}
+
+ghost_reclaimer_t::~ghost_reclaimer_t()
+{
+}
+
+bool ghost_reclaimer_t::_is_candidate(const btree_page_h& page) const
+{
+    return page.is_leaf() && page.reclaimable_space() >= _min_reclaimable;
+}
+
+void ghost_reclaimer_t::check_page(const generic_page* page, bf_idx idx)
+{
+    if (page->tag != t_btree_p) { return; }
+
+    btree_page_h p;
+    p.fix_nonbufferpool_page(const_cast<generic_page*>(page));
+    if (!_is_candidate(p)) { return; }
+
+    std::unique_lock<std::mutex> lck(_mutex);
+    _candidates[page->pid] = idx;
+}
+
+size_t ghost_reclaimer_t::get_candidate_count()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    return _candidates.size();
+}
+
+void ghost_reclaimer_t::do_work()
+{
+    std::map<PageID, bf_idx> work;
+    {
+        std::unique_lock<std::mutex> lck(_mutex);
+        work.swap(_candidates);
+    }
+    if (work.empty()) { return; }
+
+    // Losers rolled back by instant restart are not tracked as active
+    if (smlevel_0::recovery && smlevel_0::recovery->is_running()) {
+        std::unique_lock<std::mutex> lck(_mutex);
+        _candidates.insert(work.begin(), work.end());
+        return;
+    }
+
+    log_core* log = smlevel_0::log;
+    lsn_t oldest_active =
+        log->get_oldest_lsn_tracker()->get_oldest_active_lsn(log->curr_lsn());
+
+    std::vector<std::pair<PageID, bf_idx> > retries;
+    for (std::map<PageID, bf_idx>::iterator it = work.begin();
+            it != work.end() && !should_exit(); ++it)
+    {
+        bool retry = false;
+        W_COERCE(_reclaim(it->first, it->second, oldest_active, retry));
+        if (retry) {
+            retries.push_back(*it);
+        }
+    }
+
+    std::unique_lock<std::mutex> lck(_mutex);
+    for (size_t i = 0; i < retries.size(); i++) {
+        _candidates.insert(retries[i]);
+    }
+}
+
+rc_t ghost_reclaimer_t::_reclaim(PageID pid, bf_idx idx, lsn_t oldest_active,
+        bool& retry)
+{
+    retry = false;
+
+    // Pin the frame only if it still holds the page. We never fix by page
+    // ID, which would read an evicted page back without its parent.
+    bf_tree_m* bf = smlevel_0::bf;
+    bf_tree_cb_t& cb = bf->get_cb(idx);
+    if (cb.latch().latch_acquire(LATCH_SH, sthread_t::WAIT_IMMEDIATE).is_error()) {
+        retry = true;
+        return RCOK;
+    }
+    bool cached = cb._used && cb._pin_cnt >= 0 && cb._pid == pid;
+    if (cached) { cb.pin(); }
+    cb.latch().latch_release();
+    if (!cached) { return RCOK; }
+
+    pin_for_refix_holder pin_holder(idx);
+    btree_page_h page;
+    if (page.refix_direct(idx, LATCH_EX, true).is_error()) {
+        retry = true;
+        return RCOK;
+    }
+
+    if (page.tag() != t_btree_p || !_is_candidate(page)) {
+        return RCOK;
+    }
+
+    // Ghosts marked by an active transaction must survive its rollback
+    if (page.nghosts() > 0 && page.get_page_lsn() >= oldest_active) {
+        INC_TSTAT(ghost_reclaim_deferred);
+        retry = true;
+        return RCOK;
+    }
+
+    size_t reclaimed = page.reclaimable_space();
+    W_DO(btree_impl::_sx_defrag_page(page));
+
+    INC_TSTAT(ghost_reclaim_pages);
+    ADD_TSTAT(ghost_reclaim_bytes, reclaimed);
+    return RCOK;
+}
@@ -0,0 +1,74 @@
+#ifndef GHOST_RECLAIMER_H
+#define GHOST_RECLAIMER_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "sm_options.h"
+#include "bf_hashtable.h"
+#include "lsn.h"
+#include "worker_thread.h"
+
+#include <map>
+#include <mutex>
+
+class btree_page_h;
+
+/**
+ * \brief Background daemon that reclaims ghost records and defragments
+ * B-tree leaves.
+ *
+ * \details
+ * Deleted records remain on their leaf as ghosts, and removed or shrunk
+ * records leave holes in the item area. Neither is usable by an insert,
+ * which splits the page once contiguous free space runs out. This daemon
+ * keeps such pages dense by running btree_page_h::defrag() on them in a
+ * system transaction, off the insert path.
+ *
+ * Candidate pages are reported by the page cleaner (see
+ * bf_tree_cleaner::latch_and_copy), which already looks at every dirty
+ * frame, and thus at every leaf that recently received deletes. A leaf is a
+ * candidate if the space held by ghosts and holes (see
+ * btree_page_h::reclaimable_space()) exceeds sm_ghost_reclaim_threshold
+ * percent of the page.
+ *
+ * A ghost may still be needed by the transaction which marked it, if that
+ * transaction rolls back. Ghosts are therefore reclaimed only on pages last
+ * updated before the oldest active transaction began (see
+ * PoorMansOldestLsnTracker); other pages are retried in the next round.
+ * Pages which have been evicted in the meantime are simply dropped. Nothing
+ * is reclaimed while instant restart may still be rolling back losers.
+ */
+class ghost_reclaimer_t : public worker_thread_t {
+public:
+    ghost_reclaimer_t(const sm_options& options);
+    virtual ~ghost_reclaimer_t();
+
+    /**
+     * Called with a copy of a latched frame. Records the page as a
+     * candidate if it is a leaf worth defragmenting.
+     */
+    void check_page(const generic_page* page, bf_idx idx);
+
+    /// Number of pages waiting to be defragmented
+    size_t get_candidate_count();
+
+protected:
+    virtual void do_work();
+
+private:
+    /// Whether the page holds enough reclaimable space to be defragmented
+    bool _is_candidate(const btree_page_h& page) const;
+
+    /// Defragments the page if it is still cached in frame idx
+    rc_t _reclaim(PageID pid, bf_idx idx, lsn_t oldest_active, bool& retry);
+
+    /// Minimum reclaimable space for a page to be defragmented
+    size_t _min_reclaimable;
+
+    /// Candidate pages and the frames they were found in
+    std::map<PageID, bf_idx> _candidates;
+    std::mutex _mutex;
+};
+
+#endif // GHOST_RECLAIMER_H
@@ -154,6 +154,7 @@ w_error_codes lock_core_m::acquire_lock(RawXct* xct, uint32_t hash, const okvl_m
                 bool check, bool wait, bool acquire, int32_t timeout, RawLock** out)
 {
     w_assert1(timeout >= 0 || timeout == WAIT_FOREVER);
+    uint64_t lock_start = LATENCY_START();
     uint32_t idx = _table_bucket(hash);
     while (true) {
         w_error_codes er = _htab[idx].acquire(xct, hash, mode, timeout,
@@ -174,6 +175,7 @@ w_error_codes lock_core_m::acquire_lock(RawXct* xct, uint32_t hash, const okvl_m
             atomic_synchronize();
             continue;
         }
+        RECORD_TLATENCY(lock_acquire, lock_start);
         return er;
     }
 }
@@ -73,8 +73,10 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "bf_tree.h"
 
 #include "fixable_page_h.h"
+#include "sm.h"
 
 #include <algorithm>
+#include <fstream>
 #include <sstream>
 #include <w_strstream.h>
 #include <sys/stat.h>
@@ -84,8 +86,9 @@ typedef smlevel_0::fileoff_t fileoff_t;
 class ticker_thread_t : public smthread_t
 {
 public:
-    ticker_thread_t(bool msec = false)
-        : smthread_t(t_regular, "ticker"), msec(msec)
+    ticker_thread_t(bool msec = false, std::string latency_file = "")
+        : smthread_t(t_regular, "ticker"), msec(msec),
+        latency_file(latency_file)
     {
         interval_usec = 1000; // 1ms
         if (!msec) {
@@ -116,13 +119,40 @@ public:
             else {
                 sysevent::log(logrec_t::t_tick_sec);
             }
+
+            // export latencies once per second
+            if (!latency_file.empty() && (!msec || ++ticks % 1000 == 0)) {
+                export_latencies();
+            }
+        }
+    }
+
+    /*
+     * Writes the merged latency histograms of all threads to latency_file.
+     * The file is replaced atomically, so readers never see a partial
+     * export.
+     */
+    void export_latencies()
+    {
+        sm_stats_info_t stats;
+        W_IGNORE(ss_m::gather_stats(stats));
+
+        std::string tmp = latency_file + ".tmp";
+        std::ofstream out(tmp.c_str(), std::ios::out | std::ios::trunc);
+        if (!out) {
+            return;
         }
+        out << stats.lat;
+        out.close();
+        ::rename(tmp.c_str(), latency_file.c_str());
     }
 
 private:
     int interval_usec;
     bool msec;
     bool stop;
+    std::string latency_file;
+    size_t ticks = 0;
     // 80 bytes is enough to hold ticker logrec
     char lrbuf[80];
 };
@@ -394,7 +424,9 @@ log_core::log_core(const sm_options& options)
     _ticker = NULL;
     if (options.get_bool_option("sm_ticker_enable", false)) {
         bool msec = options.get_bool_option("sm_ticker_msec", false);
-        _ticker = new ticker_thread_t(msec);
+        std::string latency_file =
+            options.get_string_option("sm_ticker_latency_file", "");
+        _ticker = new ticker_thread_t(msec, latency_file);
     }
 
     // Load fetch buffers
@@ -947,6 +979,7 @@ rc_t log_core::flush(const lsn_t &to_lsn, bool block, bool signal, bool *ret_flu
             }
             if (ret_flushed) *ret_flushed = false; // not yet flushed
         }  else {
+            uint64_t flush_start = LATENCY_START();
             CRITICAL_SECTION(cs, _wait_flush_lock);
             while(lsn >= *&_durable_lsn) {
                 *&_waiting_for_flush = true;
@@ -955,6 +988,7 @@ rc_t log_core::flush(const lsn_t &to_lsn, bool block, bool signal, bool *ret_flu
                 DO_PTHREAD(pthread_cond_signal(&_flush_cond));
                 DO_PTHREAD(pthread_cond_wait(&_wait_cond, &_wait_flush_lock));
             }
+            RECORD_TLATENCY(log_flush_wait, flush_start);
             if (ret_flushed) *ret_flushed = true;// now flushed!
         }
     } else {
@@ -168,7 +168,9 @@ rc_t restart_m::_collect_spr_logs(
         if (lr->type() == logrec_t::t_btree_split && pid == lr->pid()) {
             break;
         }
-        if (lr->type() == logrec_t::t_page_img_format) {
+        if (lr->type() == logrec_t::t_page_img_format
+                || lr->type() == logrec_t::t_overflow_page_img)
+        {
             break;
         }
     }
@@ -394,6 +394,20 @@ void log_storage::wakeup_recycler()
     _recycler_thread->wakeup();
 }
 
+void log_storage::add_checkpoint(lsn_t lsn)
+{
+    spinlock_write_critical_section cs(&_partition_map_latch);
+    w_assert1(_checkpoints.empty() || _checkpoints.back() < lsn);
+    _checkpoints.push_back(lsn);
+}
+
+lsn_t log_storage::get_last_checkpoint() const
+{
+    spinlock_read_critical_section cs(&_partition_map_latch);
+    if (_checkpoints.empty()) { return lsn_t::null; }
+    return _checkpoints.back();
+}
+
 unsigned log_storage::delete_old_partitions(partition_number_t older_than)
 {
     if (!_delete_old_partitions) { return 0; }
@@ -103,6 +103,13 @@ public:
     fs::path make_log_path(partition_number_t pnum) const;
     fs::path make_chkpt_path(lsn_t lsn) const;
 
+    /// Registers a new checkpoint file, i.e., one that was just renamed to
+    /// make_chkpt_path(lsn)
+    void add_checkpoint(lsn_t lsn);
+
+    /// Begin LSN of the most recent checkpoint file, or null if there is none
+    lsn_t get_last_checkpoint() const;
+
     void wakeup_recycler();
     unsigned delete_old_partitions(partition_number_t older_than = 0);
 
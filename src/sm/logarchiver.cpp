@@ -8,6 +8,8 @@
 #include "log_core.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <sm_base.h>
 #include <sstream>
 #include <sys/stat.h>
@@ -314,9 +316,11 @@ void LogArchiver::WriterThread::run()
 
         size_t blockEnd = BlockAssembly::getEndOfBlock(src);
         size_t actualBlockSize= blockEnd - sizeof(BlockAssembly::BlockHeader);
-        memmove(src, src + sizeof(BlockAssembly::BlockHeader), actualBlockSize);
 
-        W_COERCE(directory->append(src, actualBlockSize));
+        // append copies the data into its own buffer, so the block header
+        // is skipped instead of moved away
+        W_COERCE(directory->append(src + sizeof(BlockAssembly::BlockHeader),
+                    actualBlockSize));
 
         DBGTHRD(<< "Wrote out block " << (void*) src
                 << " with max LSN " << blockLSN);
@@ -329,7 +333,7 @@ LogArchiver::LogArchiver(
         ArchiveDirectory* d, LogConsumer* c, ArchiverHeap* h, BlockAssembly* b)
     :
     smthread_t(t_regular, "LogArchiver"),
-    directory(d), consumer(c), heap(h), blkAssemb(b),
+    directory(d), consumer(c), heap(h), parallelHeap(NULL), blkAssemb(b),
     shutdownFlag(false), control(&shutdownFlag), selfManaged(false),
     flushReqLSN(lsn_t::null)
 {
@@ -338,6 +342,7 @@ LogArchiver::LogArchiver(
 
 LogArchiver::LogArchiver(const sm_options& options)
     : smthread_t(t_regular, "LogArchiver"),
+    heap(NULL), parallelHeap(NULL),
     shutdownFlag(false), control(&shutdownFlag), selfManaged(true),
     flushReqLSN(lsn_t::null)
 {
@@ -348,6 +353,9 @@ LogArchiver::LogArchiver(const sm_options& options)
         options.get_int_option("sm_archiver_block_size", DFT_BLOCK_SIZE);
     size_t bucketSize =
         options.get_int_option("sm_archiver_bucket_size", 0);
+    size_t preallocSize = 1024 * 1024 * // convert MB -> B
+        options.get_int_option("sm_archiver_prealloc_size", DFT_PREALLOC_SIZE);
+    int workers = options.get_int_option("sm_archiver_workers", DFT_WORKERS);
 
     eager = options.get_bool_option("sm_archiver_eager", DFT_EAGER);
     readWholeBlocks = options.get_bool_option(
@@ -360,11 +368,17 @@ LogArchiver::LogArchiver(const sm_options& options)
                 << "Option for archive directory must be specified");
     }
 
-    directory = new ArchiveDirectory(archdir, blockSize, bucketSize);
+    directory = new ArchiveDirectory(archdir, blockSize, bucketSize,
+            lsn_t::null, preallocSize);
     nextActLSN = directory->getStartLSN();
 
     consumer = new LogConsumer(directory->getStartLSN(), blockSize);
-    heap = new ArchiverHeap(workspaceSize);
+    if (workers > 1) {
+        parallelHeap = new ParallelArchiverHeap(workspaceSize, workers);
+    }
+    else {
+        heap = new ArchiverHeap(workspaceSize);
+    }
     blkAssemb = new BlockAssembly(directory);
 }
 
@@ -425,6 +439,7 @@ LogArchiver::~LogArchiver()
         delete blkAssemb;
         delete consumer;
         delete heap;
+        delete parallelHeap;
         delete directory;
     }
 }
@@ -477,11 +492,96 @@ os_dirent_t* LogArchiver::ArchiveDirectory::scanDir(os_dir_t& dir)
     return os_readdir(dir);
 }
 
+/*
+ * Writes run file data in the background, so that the writer thread can
+ * fill the next buffer while the previous one is being written. At most one
+ * write is in flight at a time, which together with the buffer being
+ * filled gives us double buffering.
+ */
+class LogArchiver::ArchiveDirectory::AsyncWriter : public smthread_t
+{
+public:
+    AsyncWriter()
+        : smthread_t(t_regular, "LogArchiver_AsyncWriter"),
+        fd(-1), data(NULL), size(0), offset(0), pending(false), stop(false)
+    {}
+
+    virtual ~AsyncWriter() {}
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        while (true) {
+            cond.wait(lck, [this] { return pending || stop; });
+            if (!pending) { return; }
+
+            lck.unlock();
+            rc_t rc = me()->pwrite(fd, data, size, offset);
+            lck.lock();
+
+            if (rc.is_error() && !lastRC.is_error()) { lastRC = rc; }
+            pending = false;
+            cond.notify_all();
+        }
+    }
+
+    void submit(int fd, const char* data, size_t size, fileoff_t offset)
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        w_assert1(!pending);
+        this->fd = fd;
+        this->data = data;
+        this->size = size;
+        this->offset = offset;
+        pending = true;
+        cond.notify_all();
+    }
+
+    /// Waits for the pending write and returns the first error since the
+    /// last call
+    rc_t wait()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        cond.wait(lck, [this] { return !pending; });
+        rc_t rc = lastRC;
+        lastRC = RCOK;
+        return rc;
+    }
+
+    void shutdown()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        stop = true;
+        cond.notify_all();
+    }
+
+private:
+    int fd;
+    const char* data;
+    size_t size;
+    fileoff_t offset;
+    bool pending;
+    bool stop;
+    rc_t lastRC;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
 LogArchiver::ArchiveDirectory::ArchiveDirectory(std::string archdir,
-        size_t blockSize, size_t bucketSize, lsn_t tailLSN)
+        size_t blockSize, size_t bucketSize, lsn_t tailLSN,
+        size_t preallocSize)
     : archdir(archdir),
-    appendFd(-1), mergeFd(-1), appendPos(0), blockSize(blockSize)
+    appendFd(-1), mergeFd(-1), appendPos(0), blockSize(blockSize),
+    activeBuffer(0), appendBufferSize(WRITE_BATCH_BLOCKS * blockSize),
+    bufferPos(0), bufferOffset(0), preallocSize(preallocSize)
 {
+    // Using direct I/O
+    for (int i = 0; i < 2; i++) {
+        posix_memalign((void**) &appendBuffers[i], IO_ALIGN, appendBufferSize);
+    }
+    asyncWriter = new AsyncWriter();
+    W_COERCE(asyncWriter->fork());
+
     // CS TODO: use boost, just like log_storage
     // open archdir and extract last archived LSN
     {
@@ -585,6 +685,13 @@ LogArchiver::ArchiveDirectory::ArchiveDirectory(std::string archdir,
 
 LogArchiver::ArchiveDirectory::~ArchiveDirectory()
 {
+    W_COERCE(asyncWriter->wait());
+    asyncWriter->shutdown();
+    W_COERCE(asyncWriter->join());
+    delete asyncWriter;
+    free(appendBuffers[0]);
+    free(appendBuffers[1]);
+
     if(archIndex) {
         delete archIndex;
     }
@@ -640,6 +747,9 @@ rc_t LogArchiver::ArchiveDirectory::listFileStats(list<RunFileStats>& list)
  *
  * We assume the rename operation is atomic, even in case of OS crashes.
  *
+ * The file is opened for direct I/O (falling back to buffered I/O on file
+ * systems that do not support it) and preallocated with preallocSize bytes;
+ * space that is not used is released when the run is closed.
  */
 rc_t LogArchiver::ArchiveDirectory::openNewRun()
 {
@@ -647,16 +757,29 @@ rc_t LogArchiver::ArchiveDirectory::openNewRun()
         return RC(fcINTERNAL);
     }
 
-    int flags = smthread_t::OPEN_WRONLY | smthread_t::OPEN_SYNC
-        | smthread_t::OPEN_CREATE;
+    int flags = smthread_t::OPEN_WRONLY | smthread_t::OPEN_CREATE
+        | smthread_t::OPEN_TRUNC;
     int fd;
     // 0744 is the mode_t for the file permissions (like in chmod)
     std::string fname = archdir + "/" + CURR_RUN_FILE;
-    W_DO(me()->open(fname.c_str(), flags, 0744, fd));
+    rc_t rc = me()->open(fname.c_str(), flags | smthread_t::OPEN_DIRECT,
+            0744, fd);
+    if (rc.is_error()) {
+        W_DO(me()->open(fname.c_str(), flags, 0744, fd));
+    }
     DBGTHRD(<< "Opened new output run");
 
+    if (preallocSize > 0) {
+        rc = me()->fallocate(fd, 0, preallocSize);
+        if (rc.is_error() && rc.err_num() != fcNOTIMPLEMENTED) {
+            return rc;
+        }
+    }
+
     appendFd = fd;
     appendPos = 0;
+    bufferPos = 0;
+    bufferOffset = 0;
     return RCOK;
 }
 
@@ -672,6 +795,12 @@ rc_t LogArchiver::ArchiveDirectory::closeCurrentRun(lsn_t runEndLSN)
             return RCOK;
         }
 
+        // write out buffered data, including the trailing skip log record
+        fileoff_t fileEnd = 0;
+        if (appendPos > 0) {
+            W_DO(flushAppendBuffer(true, fileEnd));
+        }
+
         if (lastLSN != runEndLSN) {
             std::stringstream fname;
             fname << archdir << "/" << LogArchiver::RUN_PREFIX
@@ -684,9 +813,18 @@ rc_t LogArchiver::ArchiveDirectory::closeCurrentRun(lsn_t runEndLSN)
                 // and make sure data is written aligned to block boundary
                 appendPos -= appendPos % blockSize;
                 appendPos += blockSize;
-                archIndex->finishRun(lastLSN, runEndLSN, appendFd, appendPos);
+                fileoff_t indexEnd = appendPos;
+                archIndex->finishRun(lastLSN, runEndLSN, appendFd, indexEnd);
+                if (indexEnd > appendPos) {
+                    fileEnd = indexEnd;
+                }
             }
 
+            // Release preallocated space and make the run durable before
+            // it becomes visible under its final name
+            W_DO(me()->ftruncate(appendFd, fileEnd));
+            W_DO(me()->fsync(appendFd));
+
             std::string currentFName = archdir + "/" + CURR_RUN_FILE;
             W_DO(me()->frename(appendFd, currentFName.c_str(), fname.str().c_str()));
 
@@ -708,12 +846,66 @@ rc_t LogArchiver::ArchiveDirectory::append(char* data, size_t length)
 {
     // make sure there is always a skip log record at the end
     w_assert1(length + sizeof(baseLogHeader) <= blockSize);
-    memcpy(data + length, &SKIP_LOGREC, sizeof(baseLogHeader));
+
+    if (bufferPos + blockSize > appendBufferSize) {
+        fileoff_t fileEnd;
+        W_DO(flushAppendBuffer(false, fileEnd));
+    }
+
+    char* dest = appendBuffers[activeBuffer] + bufferPos;
+    memcpy(dest, data, length);
+    memcpy(dest + length, &SKIP_LOGREC, sizeof(baseLogHeader));
 
     INC_TSTAT(la_block_writes);
-    W_DO(me()->pwrite(appendFd, data, length + sizeof(baseLogHeader),
-                appendPos));
+    bufferPos += length;
     appendPos += length;
+    w_assert1(appendPos == bufferOffset + (fileoff_t) bufferPos);
+    return RCOK;
+}
+
+/*
+ * Hands the active append buffer to the asynchronous writer. Direct I/O
+ * requires aligned sizes, so only the aligned prefix is written, and the
+ * remainder (including the trailing skip log record) is carried over to the
+ * other buffer. On the last write of a run, the whole buffer is written,
+ * padded with zeros, and we wait for completion; fileEnd is then set to the
+ * end of the written data.
+ */
+rc_t LogArchiver::ArchiveDirectory::flushAppendBuffer(bool lastWrite,
+        fileoff_t& fileEnd)
+{
+    // the other buffer may only be reused once its write has completed
+    W_DO(asyncWriter->wait());
+
+    char* buf = appendBuffers[activeBuffer];
+    size_t writeSize;
+    if (lastWrite) {
+        size_t dataEnd = bufferPos + sizeof(baseLogHeader);
+        writeSize = IO_ALIGN * ((dataEnd + IO_ALIGN - 1) / IO_ALIGN);
+        w_assert1(writeSize <= appendBufferSize);
+        memset(buf + dataEnd, 0, writeSize - dataEnd);
+    }
+    else {
+        writeSize = bufferPos - (bufferPos % IO_ALIGN);
+        size_t rest = bufferPos - writeSize;
+        memcpy(appendBuffers[1 - activeBuffer], buf + writeSize,
+                rest + sizeof(baseLogHeader));
+    }
+
+    asyncWriter->submit(appendFd, buf, writeSize, bufferOffset);
+    fileEnd = bufferOffset + writeSize;
+
+    if (lastWrite) {
+        W_DO(asyncWriter->wait());
+        bufferPos = 0;
+        bufferOffset = fileEnd;
+    }
+    else {
+        bufferOffset += writeSize;
+        bufferPos -= writeSize;
+        activeBuffer = 1 - activeBuffer;
+    }
+
     return RCOK;
 }
 
@@ -932,7 +1124,8 @@ bool LogArchiver::LogConsumer::next(logrec_t*& lr)
  * The latter simplifies the write process by not allowing records to
  * be split in the middle by block boundaries.
  */
-bool LogArchiver::selection()
+template <class H>
+bool LogArchiver::selection(H* heap)
 {
     if (heap->size() == 0) {
         // if there are no elements in the heap, we have nothing to write
@@ -968,6 +1161,19 @@ bool LogArchiver::selection()
     return true;
 }
 
+bool LogArchiver::selection()
+{
+    if (parallelHeap) {
+        return selection(parallelHeap);
+    }
+    return selection(heap);
+}
+
+size_t LogArchiver::heapSize()
+{
+    return parallelHeap ? parallelHeap->size() : heap->size();
+}
+
 LogArchiver::BlockAssembly::BlockAssembly(ArchiveDirectory* directory)
     : dest(NULL), maxLSNInBlock(lsn_t::null), maxLSNLength(0),
     lastRun(-1), bucketSize(0), nextBucket(0)
@@ -1319,8 +1525,7 @@ void LogArchiver::ArchiveScanner::MergeHeapEntry::moveToNext()
 void LogArchiver::ArchiveScanner::RunMerger::addInput(RunScanner* r)
 {
     w_assert0(!started);
-    MergeHeapEntry entry(r);
-    heap.AddElementDontHeapify(entry);
+    inputs.push_back(MergeHeapEntry(r));
 
     if (endPID == 0) {
         endPID = r->lastPID;
@@ -1332,13 +1537,17 @@ bool LogArchiver::ArchiveScanner::RunMerger::next(logrec_t*& lr)
 {
     stopwatch_t timer;
 
-    if (heap.NumElements() == 0) {
+    if (inputs.size() == 0) {
         return false;
     }
 
     if (!started) {
         started = true;
-        heap.Heapify();
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (inputs[i].active) {
+                heap.push(sortKey(0, inputs[i].pid, inputs[i].lsn), i);
+            }
+        }
     }
     else {
         /*
@@ -1348,42 +1557,45 @@ bool LogArchiver::ArchiveScanner::RunMerger::next(logrec_t*& lr)
          * and calling next before the log record is consumed may cause the
          * pointer to be invalidated if a new block is read into the buffer.
          */
-        heap.First().moveToNext();
-        heap.ReplacedFirst();
+        MergeHeapEntry& top = inputs[heap.top()];
+        top.moveToNext();
+        if (top.active) {
+            heap.replace_top(sortKey(0, top.pid, top.lsn));
+        }
+        else {
+            heap.pop();
+        }
     }
 
-    if (!heap.First().active) {
-        /*
-         * CS: If top run is inactive, then all runs are and scan is done
-         * Memory of each scanner must be released here instead of when
-         * destructing heap, because the heap internally copies entries and
-         * destructs these copies in operations like SiftDown(). Therefore the
-         * underlying buffer may get wrongly deleted
-         */
+    if (heap.empty()) {
+        // all runs are exhausted
         close();
         return false;
     }
 
     ADD_TSTAT(la_merge_heap_time, timer.time_us());
 
-    lr = heap.First().lr;
+    lr = inputs[heap.top()].lr;
     return true;
 }
 
 void LogArchiver::ArchiveScanner::RunMerger::close()
 {
-    while (heap.NumElements() > 0) {
-        delete heap.RemoveFirst().runScan;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        delete inputs[i].runScan;
     }
+    inputs.clear();
 }
 
 void LogArchiver::ArchiveScanner::RunMerger::dumpHeap(ostream& out)
 {
-    heap.Print(out);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        out << inputs[i] << endl;
+    }
 }
 
 LogArchiver::ArchiverHeap::ArchiverHeap(size_t workspaceSize)
-    : currentRun(0), filledFirst(false), w_heap(heapCmp)
+    : currentRun(0), filledFirst(false), w_heap(1024)
 {
     workspace = new fixed_lists_mem_t(workspaceSize);
 }
@@ -1400,7 +1612,7 @@ slot_t LogArchiver::ArchiverHeap::allocate(size_t length)
 
     if (!dest.address) {
         // workspace full -> do selection until space available
-        DBGTHRD(<< "Heap full! Size: " << w_heap.NumElements()
+        DBGTHRD(<< "Heap full! Size: " << w_heap.size()
                 << " alloc size: " << length);
         if (!filledFirst) {
             // first run generated by first full load of w_heap
@@ -1454,7 +1666,7 @@ bool LogArchiver::ArchiverHeap::push(logrec_t* lr, bool duplicate)
         // if we are not duplicating a log record -- otherwise two new runs
         // would be created.
         if (filledFirst &&
-                (size() == 0 || w_heap.First().run == currentRun)) {
+                (size() == 0 || topRun() == currentRun)) {
             currentRun++;
             DBGTHRD(<< "Replacement starting new run " << (int) currentRun
                     << " on LSN " << lr->lsn_ck());
@@ -1466,10 +1678,7 @@ bool LogArchiver::ArchiverHeap::push(logrec_t* lr, bool duplicate)
     //        lr->length() << " into run " << (int) currentRun);
 
     // insert key and pointer into w_heap
-    HeapEntry k(currentRun, pid, lsn, dest);
-
-    // CS: caution: AddElementDontHeapify does NOT work!!!
-    w_heap.AddElement(k);
+    w_heap.push(sortKey(currentRun, pid, lsn), dest);
 
     return true;
 }
@@ -1477,10 +1686,10 @@ bool LogArchiver::ArchiverHeap::push(logrec_t* lr, bool duplicate)
 void LogArchiver::ArchiverHeap::pop()
 {
     // DBGTHRD(<< "Selecting for output: "
-    //         << *((logrec_t*) w_heap.First().slot.address));
+    //         << *((logrec_t*) w_heap.top().address));
 
-    workspace->free(w_heap.First().slot);
-    w_heap.RemoveFirst();
+    workspace->free(w_heap.top());
+    w_heap.pop();
 
     if (size() == 0) {
         // If heap becomes empty, run generation must be reset with a new run
@@ -1491,20 +1700,246 @@ void LogArchiver::ArchiverHeap::pop()
 
 logrec_t* LogArchiver::ArchiverHeap::top()
 {
-    return (logrec_t*) w_heap.First().slot.address;
+    return (logrec_t*) w_heap.top().address;
 }
 
-// gt is actually a less than function, to produce ascending order
-bool LogArchiver::ArchiverHeap::Cmp::gt(const HeapEntry& a,
-        const HeapEntry& b) const
+/*
+ * Sort worker of ParallelArchiverHeap. Log records are copied into a private
+ * workspace by the archiver thread, which then requests a sort of the keys
+ * and waits for it to finish. Workspace contents are only accessed by the
+ * worker while a sort is pending, so the mutex protects just the handover.
+ */
+class LogArchiver::ParallelArchiverHeap::SortWorker : public smthread_t
 {
-    if (a.run != b.run) {
-        return a.run < b.run;
+public:
+    struct SortEntry {
+        w_packed_key_t key;
+        size_t offset;
+
+        SortEntry(w_packed_key_t key, size_t offset)
+            : key(key), offset(offset)
+        {}
+
+        bool operator<(const SortEntry& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+    SortWorker(size_t capacity)
+        : smthread_t(t_regular, "LogArchiver_SortWorker"),
+        capacity(capacity), used(0), cursor(0), requested(false), stop(false)
+    {
+        buffer = new char[capacity];
     }
-    if (a.pid != b.pid) {
-        return a.pid< b.pid;
+
+    virtual ~SortWorker()
+    {
+        delete[] buffer;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        while (true) {
+            cond.wait(lck, [this] { return requested || stop; });
+            if (stop) { return; }
+
+            lck.unlock();
+            std::sort(entries.begin(), entries.end());
+            lck.lock();
+
+            requested = false;
+            cond.notify_all();
+        }
+    }
+
+    bool hasRoom(size_t length)
+    {
+        return used + length <= capacity;
+    }
+
+    /// If secondPage is set, the copy is assigned to pid2 of a multi-page
+    /// log record
+    void add(logrec_t* lr, bool secondPage = false)
+    {
+        w_assert1(hasRoom(lr->length()));
+        logrec_t* dest = (logrec_t*) (buffer + used);
+        memcpy(dest, lr, lr->length());
+        if (secondPage) {
+            dest->set_pid(dest->pid2());
+            dest->set_page_prev_lsn(dest->page2_prev_lsn());
+        }
+        entries.push_back(
+                SortEntry(sortKey(0, dest->pid(), dest->lsn()), used));
+        used += lr->length();
+    }
+
+    void sortAsync()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        requested = true;
+        cond.notify_all();
+    }
+
+    void waitSorted()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        cond.wait(lck, [this] { return !requested; });
+    }
+
+    void shutdown()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        stop = true;
+        cond.notify_all();
+    }
+
+    // iteration over sorted entries, used by the merge
+    bool hasCurrent() { return cursor < entries.size(); }
+    const SortEntry& currentEntry() { return entries[cursor]; }
+    void advance() { cursor++; }
+
+    logrec_t* current()
+    {
+        return (logrec_t*) (buffer + entries[cursor].offset);
+    }
+
+    void reset()
+    {
+        used = 0;
+        cursor = 0;
+        entries.clear();
+    }
+
+private:
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    std::vector<SortEntry> entries;
+    size_t cursor;
+
+    bool requested;
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+LogArchiver::ParallelArchiverHeap::ParallelArchiverHeap(size_t workspaceSize,
+        size_t workerCount)
+    : nextWorker(0), count(0), currentRun(0), sorted(false),
+    mergeHeap(workerCount)
+{
+    w_assert0(workerCount > 0);
+    // a worker must fit any log record and its duplicate
+    size_t workerSize = std::max(workspaceSize / workerCount,
+            2 * MAX_LOGREC_SIZE);
+    for (size_t i = 0; i < workerCount; i++) {
+        SortWorker* w = new SortWorker(workerSize);
+        W_COERCE(w->fork());
+        workers.push_back(w);
+    }
+}
+
+LogArchiver::ParallelArchiverHeap::~ParallelArchiverHeap()
+{
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->shutdown();
+        W_COERCE(workers[i]->join());
+        delete workers[i];
+    }
+}
+
+bool LogArchiver::ParallelArchiverHeap::push(logrec_t* lr, bool duplicate)
+{
+    if (sorted) {
+        // current batch must be emptied by selection first
+        return false;
+    }
+
+    SortWorker* w = workers[nextWorker];
+    size_t length = lr->length();
+    if (!w->hasRoom(duplicate ? 2 * length : length)) {
+        DBGTHRD(<< "sort worker " << nextWorker << " full for logrec: "
+                << lr->type_str() << " at " << lr->lsn());
+        return false;
+    }
+
+    w->add(lr);
+    count++;
+
+    // Multi-page log records are replicated just like in ArchiverHeap::push,
+    // but the copy is modified instead of the caller's log record
+    if (duplicate) {
+        w->add(lr, true);
+        count++;
+    }
+
+    nextWorker = (nextWorker + 1) % workers.size();
+    return true;
+}
+
+void LogArchiver::ParallelArchiverHeap::sortBatch()
+{
+    w_assert1(!sorted);
+    w_assert1(mergeHeap.empty());
+
+    DBGTHRD(<< "Sorting batch of " << count << " log records for run "
+            << currentRun);
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->sortAsync();
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->waitSorted();
+        if (workers[i]->hasCurrent()) {
+            mergeHeap.push(workers[i]->currentEntry().key, i);
+        }
+    }
+    sorted = true;
+}
+
+void LogArchiver::ParallelArchiverHeap::resetBatch()
+{
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->reset();
+    }
+    nextWorker = 0;
+    sorted = false;
+    // each batch is a run of its own
+    currentRun++;
+}
+
+run_number_t LogArchiver::ParallelArchiverHeap::topRun()
+{
+    if (!sorted && count > 0) { sortBatch(); }
+    return currentRun;
+}
+
+logrec_t* LogArchiver::ParallelArchiverHeap::top()
+{
+    if (!sorted) { sortBatch(); }
+    return workers[mergeHeap.top()]->current();
+}
+
+void LogArchiver::ParallelArchiverHeap::pop()
+{
+    w_assert1(sorted && count > 0);
+
+    SortWorker* w = workers[mergeHeap.top()];
+    w->advance();
+    count--;
+
+    if (w->hasCurrent()) {
+        mergeHeap.replace_top(w->currentEntry().key);
+    }
+    else {
+        mergeHeap.pop();
+    }
+
+    if (count == 0) {
+        w_assert1(mergeHeap.empty());
+        resetBatch();
     }
-    return a.lsn < b.lsn;
 }
 
 /**
@@ -1553,6 +1988,17 @@ void LogArchiver::replacement()
 }
 
 void LogArchiver::pushIntoHeap(logrec_t* lr, bool duplicate)
+{
+    if (parallelHeap) {
+        pushIntoHeap(parallelHeap, lr, duplicate);
+    }
+    else {
+        pushIntoHeap(heap, lr, duplicate);
+    }
+}
+
+template <class H>
+void LogArchiver::pushIntoHeap(H* heap, logrec_t* lr, bool duplicate)
 {
     while (!heap->push(lr, duplicate)) {
         if (heap->size() == 0) {
@@ -1652,7 +2098,7 @@ bool LogArchiver::processFlushRequest()
             // consume whole heap
             while (selection()) {}
             // Heap empty: Wait for all blocks to be consumed and writen out
-            w_assert0(heap->size() == 0);
+            w_assert0(heapSize() == 0);
             while (blkAssemb->hasPendingBlocks()) {
                 ::usleep(10000); // 10ms
             }
@@ -1804,7 +2250,7 @@ void LogArchiver::run()
     DBGTHRD(<< "Archiver exiting -- last round of selection to empty heap");
     while (selection()) {}
 
-    w_assert0(heap->size() == 0);
+    w_assert0(heapSize() == 0);
 }
 
 bool LogArchiver::requestFlushAsync(lsn_t reqLSN)
@@ -1981,8 +2427,8 @@ LogArchiver::ArchiveIndex::ArchiveIndex(size_t blockSize, lsn_t startLSN,
     bucketSize(bucketSize)
 {
     DO_PTHREAD(pthread_mutex_init(&mutex, NULL));
-    writeBuffer = new char[blockSize];
     // Using direct I/O
+    posix_memalign((void**) &writeBuffer, IO_ALIGN, blockSize);
     posix_memalign((void**) &readBuffer, IO_ALIGN, blockSize);
     // readBuffer = new char[blockSize];
 
@@ -1995,9 +2441,8 @@ LogArchiver::ArchiveIndex::ArchiveIndex(size_t blockSize, lsn_t startLSN,
 LogArchiver::ArchiveIndex::~ArchiveIndex()
 {
     DO_PTHREAD(pthread_mutex_destroy(&mutex));
-    delete[] writeBuffer;
-
     // Using direct I/O
+    free(writeBuffer);
     free(readBuffer);
     // delete[] readBuffer;
 }
@@ -2034,7 +2479,7 @@ void LogArchiver::ArchiveIndex::newBlock(const vector<pair<PageID, size_t> >&
 }
 
 rc_t LogArchiver::ArchiveIndex::finishRun(lsn_t first, lsn_t last, int fd,
-        fileoff_t offset)
+        fileoff_t& offset)
 {
     CRITICAL_SECTION(cs, mutex);
     w_assert1(offset % blockSize == 0);
@@ -2054,7 +2499,7 @@ rc_t LogArchiver::ArchiveIndex::finishRun(lsn_t first, lsn_t last, int fd,
 }
 
 rc_t LogArchiver::ArchiveIndex::serializeRunInfo(RunInfo& run, int fd,
-        fileoff_t offset)
+        fileoff_t& offset)
 {
     // Assumption: mutex is held by caller
 
@@ -7,7 +7,7 @@
 
 #include "sm_base.h"
 
-#include "w_heap.h"
+#include "w_losertree.h"
 #include "ringbuffer.h"
 #include "mem_mgmt.h"
 #include "log_storage.h"
@@ -100,7 +100,8 @@ struct ArchiverControl {
  * - LogArchiver::LogConsumer, which encapsulates a reader thread and parsing
  *   individual log records from the recovery log.
  * - LogArchiver::ArchiverHeap, which performs run generation by sorting the
- *   input stream given by the log consumer.
+ *   input stream given by the log consumer (or
+ *   LogArchiver::ParallelArchiverHeap, if multiple sort workers are used).
  * - LogArchiver::BlockAssembly, which consumes the sorted output from the
  *   heap, builds indexed blocks of log records (used for instant restore), and
  *   passes them over to the asynchronous writer thread
@@ -234,7 +235,7 @@ public:
         void newBlock(PageID firstPID);
         void newBlock(const vector<pair<PageID, size_t> >& buckets);
 
-        rc_t finishRun(lsn_t first, lsn_t last, int fd, fileoff_t);
+        rc_t finishRun(lsn_t first, lsn_t last, int fd, fileoff_t&);
         void probe(std::vector<ProbeResult>& probes,
                 PageID startPID, PageID endPID, lsn_t startLSN);
 
@@ -299,7 +300,7 @@ public:
         // binary search
         size_t findEntry(RunInfo* run, PageID pid,
                 int from = -1, int to = -1);
-        rc_t serializeRunInfo(RunInfo&, int fd, fileoff_t);
+        rc_t serializeRunInfo(RunInfo&, int fd, fileoff_t&);
         rc_t deserializeRunInfo(RunInfo&, const char* fname);
 
     };
@@ -313,7 +314,10 @@ public:
      *   a system crash.
      * - Support run generation by providing operations to open a new run,
      *   append blocks of data to the current run, and closing the current run
-     *   by renaming its file with the given LSN boundaries.
+     *   by renaming its file with the given LSN boundaries. Run files are
+     *   preallocated and written with direct I/O, so that archiving does not
+     *   pollute the OS page cache. Appended blocks are batched in one of two
+     *   aligned buffers while the other one is written asynchronously.
      * - Support scans by opening files given their LSN boundaries (which are
      *   determined by the archive index), reading arbitrary blocks of data
      *   from them, and closing them.
@@ -328,7 +332,8 @@ public:
     class ArchiveDirectory {
     public:
         ArchiveDirectory(std::string archdir, size_t blockSize,
-                size_t bucketSize = 0, lsn_t tailLSN = lsn_t::null);
+                size_t bucketSize = 0, lsn_t tailLSN = lsn_t::null,
+                size_t preallocSize = 0);
         virtual ~ArchiveDirectory();
 
         struct RunFileStats {
@@ -358,6 +363,8 @@ public:
         static lsn_t parseLSN(const char* str, bool end = true);
         static size_t getFileSize(int fd);
     private:
+        class AsyncWriter;
+
         ArchiveIndex* archIndex;
         std::string archdir;
         lsn_t startLSN;
@@ -371,7 +378,20 @@ public:
         // the writer thread and the archiver thread in processFlushRequest
         pthread_mutex_t mutex;
 
+        // Appended data is staged in the active buffer; once it is (almost)
+        // full, its aligned prefix is handed to asyncWriter and the
+        // remainder is moved to the other buffer. Invariant:
+        // appendPos == bufferOffset + bufferPos
+        char* appendBuffers[2];
+        int activeBuffer;
+        size_t appendBufferSize;
+        size_t bufferPos;
+        fileoff_t bufferOffset;
+        size_t preallocSize;
+        AsyncWriter* asyncWriter;
+
         rc_t openNewRun();
+        rc_t flushAppendBuffer(bool lastWrite, fileoff_t& fileEnd);
         os_dirent_t* scanDir(os_dir_t& dir);
     };
 
@@ -559,7 +579,6 @@ public:
 
             MergeHeapEntry(RunScanner* runScan);
 
-            // required by w_heap
             MergeHeapEntry() : runScan(NULL) {}
 
             virtual ~MergeHeapEntry() {}
@@ -578,23 +597,11 @@ public:
             }
         };
 
-        struct MergeHeapCmp {
-            bool gt(const MergeHeapEntry& a, const MergeHeapEntry& b) const
-            {
-                if (!a.active) return false;
-                if (!b.active) return true;
-                if (a.pid != b.pid) {
-                    return a.pid< b.pid;
-                }
-                return a.lsn < b.lsn;
-            }
-        };
-
     public:
         // Scan interface exposed to caller
         struct RunMerger {
             RunMerger()
-                : heap(cmp), started(false), endPID(0)
+                : started(false), endPID(0)
             {}
 
             virtual ~RunMerger() {}
@@ -604,12 +611,13 @@ public:
             void dumpHeap(ostream& out);
             void close();
 
-            size_t heapSize() { return heap.NumElements(); }
+            size_t heapSize() { return inputs.size(); }
             PageID getEndPID() { return endPID; }
 
         private:
-            MergeHeapCmp cmp;
-            Heap<MergeHeapEntry, MergeHeapCmp> heap;
+            std::vector<MergeHeapEntry> inputs;
+            // active inputs, keyed on their current (pid, lsn)
+            LoserTree<size_t> heap;
             bool started;
             PageID endPID;
         };
@@ -622,9 +630,10 @@ public:
      * LogArchiver instance. It contains a heap data structure as well as a
      * memory manager for the variable-length log records.
      *
-     * The heap contains instances of HeapEntry, which contains the sort key of
-     * log records (run number, page id, lsn) and a pointer to the log record
-     * data in the memory manager workspace (slot_t).
+     * The heap is a tournament tree (see LoserTree) keyed on the sort key of
+     * log records (run number, page id, lsn), packed into integers by
+     * sortKey(), whose values point to the log record data in the memory
+     * manager workspace (slot_t).
      *
      * This class is more than just a heap data structure because it is aware
      * of run boundaries.  Therefore, it can be seen as a replacement-selection
@@ -653,8 +662,11 @@ public:
         logrec_t* top();
         void pop();
 
-        run_number_t topRun() { return w_heap.First().run; }
-        size_t size() { return w_heap.NumElements(); }
+        run_number_t topRun()
+        {
+            return (run_number_t) (w_heap.top_key().hi >> 32);
+        }
+        size_t size() { return w_heap.size(); }
     private:
         run_number_t currentRun;
         bool filledFirst;
@@ -662,36 +674,54 @@ public:
 
         mem_mgmt_t::slot_t allocate(size_t length);
 
-        struct HeapEntry {
-            mem_mgmt_t::slot_t slot;
-            lsn_t lsn;
-            run_number_t run;
-            PageID pid;
+        LoserTree<mem_mgmt_t::slot_t> w_heap;
+    };
 
-            HeapEntry(run_number_t run, PageID pid, lsn_t lsn,
-                    mem_mgmt_t::slot_t slot)
-                : slot(slot), lsn(lsn), run(run), pid(pid)
-            {}
+    /** \brief Run generation with multiple sort workers.
+     *
+     * Alternative to ArchiverHeap with the same interface (push, top, pop,
+     * topRun, size), used when the option sm_archiver_workers is greater
+     * than one. Incoming log records are distributed round-robin among N
+     * sort workers, each with its own share of the workspace. When a worker
+     * is full, the batch is closed: all workers sort their records in
+     * parallel, and the sorted partitions are merged by the caller of top()
+     * and pop(), which only costs log(N) comparisons per record. Each batch
+     * becomes one run, so runs still map to contiguous, non-overlapping LSN
+     * ranges, as required by ArchiveIndex and by the resume logic of
+     * ArchiveDirectory. Replacement (i.e., filling the workspace) and
+     * selection do not overlap, so runs are as large as the workspace and
+     * not twice as large as with replacement selection.
+     *
+     * The expensive part of run generation, which is the comparison-based
+     * sort, therefore scales with the number of workers, while the archiver
+     * thread only copies records in and merges them out.
+     */
+    class ParallelArchiverHeap {
+    public:
+        ParallelArchiverHeap(size_t workspaceSize, size_t workerCount);
+        virtual ~ParallelArchiverHeap();
 
-            HeapEntry()
-                : slot(NULL, 0), lsn(lsn_t::null), run(0), pid(0)
-            {}
+        bool push(logrec_t* lr, bool duplicate);
+        logrec_t* top();
+        void pop();
 
-            friend std::ostream& operator<<(std::ostream& os,
-                    const HeapEntry& e)
-            {
-                os << "[run " << e.run << ", " << e.pid << ", " << e.lsn <<
-                    ", slot(" << e.slot.address << ", " << e.slot.length << ")]";
-                return os;
-            }
-        };
+        run_number_t topRun();
+        size_t size() { return count; }
+    private:
+        class SortWorker;
 
-        struct Cmp {
-            bool gt(const HeapEntry& a, const HeapEntry& b) const;
-        };
+        std::vector<SortWorker*> workers;
+        size_t nextWorker;
+        size_t count;
+        run_number_t currentRun;
+        // set once the current batch is sorted and being merged
+        bool sorted;
 
-        Cmp heapCmp;
-        Heap<HeapEntry, Cmp> w_heap;
+        // sorted partitions, keyed on their current record
+        LoserTree<size_t> mergeHeap;
+
+        void sortBatch();
+        void resetBatch();
     };
 
     /** \brief Provides a record-at-a-time interface to the recovery log using
@@ -805,6 +835,12 @@ public:
 
     static void initLogScanner(LogScanner* logScanner);
 
+    /// Packs the sort key of log records in the archive for LoserTree
+    static w_packed_key_t sortKey(run_number_t run, PageID pid, lsn_t lsn)
+    {
+        return w_packed_key_t(((uint64_t) run << 32) | pid, lsn.data());
+    }
+
     /*
      * IMPORTANT: the block size must be a multiple of the log
      * page size to ensure that logrec headers are not truncated
@@ -814,8 +850,11 @@ public:
     const static bool DFT_EAGER = true;
     const static bool DFT_READ_WHOLE_BLOCKS = true;
     const static int DFT_GRACE_PERIOD = 1000000; // 1 sec
+    const static int DFT_PREALLOC_SIZE = 100; // 100MB
+    const static int DFT_WORKERS = 1;
 
     const static int IO_BLOCK_COUNT = 8; // total buffer = 8MB
+    const static int WRITE_BATCH_BLOCKS = 4; // blocks per run file write
     const static char* RUN_PREFIX;
     const static char* CURR_RUN_FILE;
     const static char* CURR_MERGE_FILE;
@@ -826,6 +865,8 @@ private:
     ArchiveDirectory* directory;
     LogConsumer* consumer;
     ArchiverHeap* heap;
+    // used instead of heap if there are multiple sort workers
+    ParallelArchiverHeap* parallelHeap;
     BlockAssembly* blkAssemb;
 
     bool shutdownFlag;
@@ -840,6 +881,9 @@ private:
     void replacement();
     bool selection();
     void pushIntoHeap(logrec_t*, bool duplicate);
+    size_t heapSize();
+    template <class H> bool selection(H* h);
+    template <class H> void pushIntoHeap(H* h, logrec_t*, bool duplicate);
     bool waitForActivation();
     bool processFlushRequest();
     bool isLogTooSlow();
@@ -14,6 +14,8 @@ public:
         slot_t(char* a, size_t l)
             : address(a), length(l)
         {}
+
+        slot_t() : address(NULL), length(0) {}
     };
 
     virtual rc_t allocate(size_t length, slot_t& slot) = 0;
@@ -2,7 +2,6 @@
 
 #include "logrec.h"
 #include "fixable_page_h.h"
-#include "bf_tree_cb.h"
 #include "log_core.h"
 #include "eventlog.h"
 
@@ -22,11 +21,11 @@ void page_cleaner_decoupled::do_work()
 {
     lsn_t last_lsn = smlevel_0::logArchiver->getDirectory()->getLastLSN();
     if(last_lsn <= _clean_lsn) {
-        ERROUT(<< "Nothing archived to clean.");
+        DBGTHRD(<< "Nothing archived to clean.");
         return;
     }
 
-    ERROUT(<< "Cleaner thread activated from " << _clean_lsn);
+    DBGTHRD(<< "Cleaner thread activated from " << _clean_lsn);
 
     LogArchiver::ArchiveScanner logScan(smlevel_0::logArchiver->getDirectory());
     // CS TODO block size
@@ -34,7 +33,11 @@ void page_cleaner_decoupled::do_work()
             _clean_lsn, 1048576);
 
     generic_page* page = nullptr;
+    // Workspace holds pages [firstPid, firstPid + _workspace_size) and only
+    // the range [wsBegin, wsEnd) has been touched by replay
     PageID currentPid = 0, firstPid = 0;
+    size_t wsBegin = 0, wsEnd = 0;
+    size_t redoneOnPage = 0;
     logrec_t* lr;
     while (merger && merger->next(lr)) {
         if (!lr->is_redo()) {
@@ -42,25 +45,34 @@ void page_cleaner_decoupled::do_work()
         }
 
         PageID lrpid = lr->pid();
+        w_assert1(!page || lrpid >= currentPid);
+
+        if (page && lrpid != currentPid && redoneOnPage > 0) {
+            // done with current page
+            page->checksum = page->calculate_checksum();
+            redoneOnPage = 0;
+        }
+
         if (!page || lrpid - firstPid >= _workspace_size) {
             // first iteration of the loop or time to read new buffer
             if (page) {
-                fill_cb_indexes();
-                flush_workspace(0, _workspace_size);
-                sysevent::log_page_write(firstPid, last_lsn, _workspace_size);
+                write_pages(firstPid, wsBegin, wsEnd, last_lsn);
             }
-            currentPid = lrpid;
             firstPid = (lrpid / _workspace_size) * _workspace_size;
-            W_COERCE(smlevel_0::vol->read_many_pages(firstPid, &(_workspace[0]), _workspace_size));
-            page = &_workspace[lrpid - firstPid];
+            W_COERCE(smlevel_0::vol->read_many_pages(firstPid,
+                        &(_workspace[0]), _workspace_size));
+            wsBegin = lrpid - firstPid;
         }
 
-        if (lrpid > currentPid) {
-            // move to next page
-            w_assert1(page);
-            page->checksum = page->calculate_checksum();
-            page += lrpid - currentPid;
-            currentPid = lrpid;
+        currentPid = lrpid;
+        page = &_workspace[lrpid - firstPid];
+        wsEnd = lrpid - firstPid + 1;
+
+        if (page->pid != lrpid) {
+            // Set PID and null LSN manually on virgin pages; this is also
+            // required to redo a split on the new foster child
+            page->pid = lrpid;
+            page->lsn = lsn_t::null;
         }
 
         if(page->lsn >= lr->lsn()) {
@@ -69,33 +81,42 @@ void page_cleaner_decoupled::do_work()
             continue;
         }
 
-        // CS TODO setting the pid is required to redo a split on the new foster child
-        page->pid = lrpid;
         fixable_page_h fixable;
         fixable.setup_for_restore(page);
         lr->redo(&fixable);
+        redoneOnPage++;
 
         DBGOUT(<<"Replayed log record " << lr->lsn_ck() << " for page " << page->pid);
     }
 
     if (merger) { delete merger; }
 
-    if(page && currentPid - firstPid > 0) {
-        page->checksum = page->calculate_checksum();
-        fill_cb_indexes();
-        flush_workspace(0, _workspace_size);
-        sysevent::log_page_write(firstPid, last_lsn, _workspace_size);
+    if (page) {
+        if (redoneOnPage > 0) {
+            page->checksum = page->calculate_checksum();
+        }
+        write_pages(firstPid, wsBegin, wsEnd, last_lsn);
     }
 
-    DBGTHRD(<< "Cleaner thread deactivating. Cleaned until " << _clean_lsn);
     _clean_lsn = last_lsn;
+
+    // All updates archived until last_lsn are now on the volume, which makes
+    // every frame whose page LSN is below it clean. Control blocks are not
+    // touched, so the cleaner never interferes with the transaction path.
+    _bufferpool->set_decoupled_clean_lsn(_clean_lsn);
+
+    DBGTHRD(<< "Cleaner thread deactivating. Cleaned until " << _clean_lsn);
 }
 
-void page_cleaner_decoupled::fill_cb_indexes()
+void page_cleaner_decoupled::write_pages(PageID first_pid, size_t from,
+        size_t to, lsn_t clean_lsn)
 {
-    for(size_t i = 0; i < _workspace_size; i++)
-    {
-        bf_idx idx = _bufferpool->lookup(_workspace[i].pid);
-        _workspace_cb_indexes[i] = idx;
+    if (to <= from) {
+        return;
     }
+    w_assert1(to <= _workspace_size);
+
+    W_COERCE(smlevel_0::vol->write_many_pages(
+                first_pid + from, &(_workspace[from]), to - from));
+    sysevent::log_page_write(first_pid + from, clean_lsn, to - from);
 }
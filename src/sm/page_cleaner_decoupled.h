@@ -9,6 +9,18 @@
 #include "smthread.h"
 #include "page_cleaner.h"
 
+/**
+ * \brief Page cleaner that propagates updates from the log archive.
+ *
+ * Instead of copying dirty frames out of the buffer pool, this cleaner reads
+ * the sorted runs of the log archive (see LogArchiver::ArchiveScanner) along
+ * with the current page images on the volume, replays the archived updates
+ * on the workspace, and writes the newer page versions back. Buffer-pool
+ * frames are never latched nor pinned. Once a round is complete, every
+ * update archived up to the round's end LSN is reflected on the volume,
+ * which is reported back to the buffer pool with a single clean LSN (see
+ * bf_tree_m::set_decoupled_clean_lsn).
+ */
 class page_cleaner_decoupled : public page_cleaner_base{
 public:
     page_cleaner_decoupled(bf_tree_m* _bufferpool, const sm_options& _options);
@@ -18,7 +30,12 @@ protected:
     virtual void do_work();
 
 private:
-    void fill_cb_indexes();
+    /**
+     * Writes pages [from, to) of the workspace, which holds the pages
+     * starting at first_pid, to the volume. No log flush is required, since
+     * the log archive only contains durable log records.
+     */
+    void write_pages(PageID first_pid, size_t from, size_t to, lsn_t clean_lsn);
 };
 
 #endif // PAGE_CLEANER_H
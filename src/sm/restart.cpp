@@ -77,6 +77,8 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 restart_m::restart_m(const sm_options& options)
     : _restart_thread(NULL)
 {
+    _log_analysis_threads =
+        options.get_int_option("sm_restart_log_analysis_threads", 1);
 }
 
 restart_m::~restart_m()
@@ -92,7 +94,12 @@ void restart_m::log_analysis()
 {
     stopwatch_t timer;
 
-    chkpt.scan_log();
+    if (_log_analysis_threads > 1) {
+        chkpt.scan_log_parallel(_log_analysis_threads);
+    }
+    else {
+        chkpt.scan_log();
+    }
 
     //Re-create transactions
     xct_t::update_youngest_tid(chkpt.get_highest_tid());
@@ -344,6 +351,7 @@ void restart_m::_redo_log_with_pid(logrec_t& r, PageID pid,
     w_assert1(r.is_redo());
 
     bool virgin_page = r.type() == logrec_t::t_page_img_format
+            || r.type() == logrec_t::t_overflow_page_img
             || (r.type() == logrec_t::t_btree_split && pid == r.pid());
 
     fixable_page_h page;
@@ -566,5 +574,6 @@ void restart_thread_t::run()
     smlevel_0::recovery->redo_page_pass();
     smlevel_0::recovery->undo_pass();
     smlevel_0::log->discard_fetch_buffers();
+    working = false;
 };
 
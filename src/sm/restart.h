@@ -53,7 +53,8 @@ public:
     NORET restart_thread_t()
         : smthread_t(t_regular, "restart", WAIT_NOT_USED)
     {
-        working = false;
+        // created only to be forked right away
+        working = true;
     };
     NORET ~restart_thread_t()
     {
@@ -102,6 +103,9 @@ public:
 
     chkpt_t* get_chkpt() { return &chkpt; }
 
+    /// Whether REDO and UNDO are still running concurrently (instant restart)
+    bool is_running() { return _restart_thread && _restart_thread->in_restart(); }
+
 private:
 
     // System state object, updated by log analysis
@@ -109,6 +113,11 @@ private:
 
     bool instantRestart;
 
+    // Number of threads used to scan log partitions during log analysis;
+    // with 1, a single backward scan is performed (option
+    // sm_restart_log_analysis_threads)
+    int _log_analysis_threads;
+
     // Child thread, used only if open system after Log Analysis phase while REDO and UNDO
     // will be performed with concurrent user transactions
     restart_thread_t*           _restart_thread;
@@ -10,50 +10,51 @@
 #include "backup_reader.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 #include "stopwatch.h"
 
 RestoreBitmap::RestoreBitmap(size_t size)
-    : bits(size, false) // initialize all bits to false
+    : size(size)
 {
+    size_t count = (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    words = new std::atomic<uint64_t>[count];
+    // initialize all bits to false
+    for (size_t i = 0; i < count; i++) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
 }
 
 RestoreBitmap::~RestoreBitmap()
 {
+    delete[] words;
 }
 
 bool RestoreBitmap::get(unsigned i)
 {
-    spinlock_read_critical_section cs(&mutex);
-    return bits.at(i);
+    w_assert1(i < size);
+    return getBit(i);
 }
 
 void RestoreBitmap::set(unsigned i)
 {
-    spinlock_write_critical_section cs(&mutex);
-    bits.at(i) = true;
+    w_assert1(i < size);
+    words[i / BITS_PER_WORD].fetch_or(1ULL << (i % BITS_PER_WORD),
+            std::memory_order_release);
 }
 
 void RestoreBitmap::serialize(char* buf, size_t from, size_t to)
 {
-    spinlock_read_critical_section cs(&mutex);
     w_assert0(from < to);
-    w_assert0(to <= bits.size());
+    w_assert0(to <= size);
 
-    /*
-     * vector<bool> does not provide access to the internal bitmap structure,
-     * so we stick with this non-efficient loop mechanism. If this becomes a
-     * performance concern, the options are:
-     * 1) Implement our own bitmap
-     * 2) Reuse a bitmap with serialization support (e.g., Boost)
-     * 3) In C++11, there is a data() method that returns the underlying array.
-     *    Maybe that would work here.
-     */
     size_t byte = 0, j = 0;
     for (size_t i = from; i < to; i++) {
         // set bit j on current byte
-        // C++ guarantees that "true" expands to the integer 1
-        buf[byte] |= (bits[i] << j++);
+        if (getBit(i)) { buf[byte] |= (1 << j); }
+        j++;
 
         // wrap around next byte
         if (j == 8) {
@@ -65,14 +66,20 @@ void RestoreBitmap::serialize(char* buf, size_t from, size_t to)
 
 void RestoreBitmap::deserialize(char* buf, size_t from, size_t to)
 {
-    spinlock_write_critical_section cs(&mutex);
     w_assert0(from < to);
-    w_assert0(to <= bits.size());
+    w_assert0(to <= size);
 
     size_t byte = 0, j = 0;
     for (size_t i = from; i < to; i++) {
         // set if bit on position j is a one
-        bits[i] = buf[byte] & (1 << j++);
+        uint64_t mask = 1ULL << (i % BITS_PER_WORD);
+        if (buf[byte] & (1 << j++)) {
+            words[i / BITS_PER_WORD].fetch_or(mask, std::memory_order_release);
+        }
+        else {
+            words[i / BITS_PER_WORD].fetch_and(~mask,
+                    std::memory_order_release);
+        }
 
         // wrap around next byte
         if (j == 8) {
@@ -84,22 +91,32 @@ void RestoreBitmap::deserialize(char* buf, size_t from, size_t to)
 
 void RestoreBitmap::getBoundaries(size_t& lowestFalse, size_t& highestTrue)
 {
-    spinlock_read_critical_section cs(&mutex);
-
     lowestFalse = 0;
     highestTrue = 0;
     bool allTrueSoFar = true;
-    for (size_t i = 0; i < bits.size(); i++) {
-        if (bits[i]) highestTrue = i;
-        if (allTrueSoFar && bits[i]) {
-            lowestFalse = i + 1;
+    size_t count = (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    for (size_t w = 0; w < count; w++) {
+        uint64_t word = words[w].load(std::memory_order_acquire);
+        size_t base = w * BITS_PER_WORD;
+        size_t valid = size - base < BITS_PER_WORD ? size - base : BITS_PER_WORD;
+        if (valid < BITS_PER_WORD) {
+            word &= (1ULL << valid) - 1;
         }
-        else {
-            allTrueSoFar = false;
+
+        if (word != 0) {
+            // position of the highest one
+            highestTrue = base + BITS_PER_WORD - 1 - __builtin_clzll(word);
+        }
+        if (allTrueSoFar) {
+            // number of trailing ones
+            size_t ones = ~word == 0 ? BITS_PER_WORD : __builtin_ctzll(~word);
+            if (ones > valid) { ones = valid; }
+            lowestFalse = base + ones;
+            allTrueSoFar = ones == valid;
         }
     }
-    w_assert0(lowestFalse <= bits.size());
-    w_assert0(highestTrue < bits.size());
+    w_assert0(lowestFalse <= size);
+    w_assert0(highestTrue < size || size == 0);
 }
 
 RestoreScheduler::RestoreScheduler(const sm_options& options,
@@ -126,24 +143,22 @@ RestoreScheduler::~RestoreScheduler()
 
 void RestoreScheduler::enqueue(const PageID& pid)
 {
-    spinlock_write_critical_section cs(&mutex);
     queue.push(pid);
 }
 
 bool RestoreScheduler::hasWaitingRequest()
 {
-    return onDemand && queue.size() > 0;
+    return onDemand && !queue.empty();
 }
 
 bool RestoreScheduler::next(PageID& next, bool peek)
 {
-    spinlock_write_critical_section cs(&mutex);
-
+    // Only invoked from the restore loop (see comment below), which is the
+    // single consumer of the request queue
     next = firstNotRestored;
-    if (onDemand && queue.size() > 0) {
-        next = queue.front();
+    if (onDemand && queue.peek(next)) {
         if (!peek) {
-            queue.pop();
+            queue.pop(next);
             INC_TSTAT(restore_sched_queued);
         }
     }
@@ -181,26 +196,34 @@ bool RestoreScheduler::next(PageID& next, bool peek)
 
 void RestoreScheduler::setSinglePass(bool singlePass)
 {
-    spinlock_write_critical_section cs(&mutex);
     trySinglePass = singlePass;
 }
 
 /** Asynchronous writer for restored segments
  *  CS: Placed here on cpp file because it isn't used anywhere else.
+ *
+ *  Segments are copied into batch buffers taken from a small pool, so that
+ *  the restore workspace (e.g., a slot of the backup prefetcher) is released
+ *  immediately. A segment adjacent to the last one in the batch being filled
+ *  is appended to it, so that runs of restored segments are written with a
+ *  single large I/O instead of one call per segment. A batch is sealed when
+ *  it is full or a non-adjacent segment arrives, and the writer thread also
+ *  takes the batch being filled whenever it is idle, so that coalescing does
+ *  not delay writes (and on-demand restore) while the device keeps up.
  */
 class SegmentWriter : public smthread_t {
 public:
-    SegmentWriter(RestoreMgr* restore);
+    SegmentWriter(RestoreMgr* restore, size_t batchSegments,
+            size_t numBuffers);
     virtual ~SegmentWriter();
 
     /** \brief Request async write of a segment.
      *
-     * If there is a write going on, i.e., mutex is held, then we wait
-     * until that write is completed to place the request. This makes the
-     * request mechanism simpler, since it does not require a queue.
-     * Furthermore, we don't expect writes to the replacement device to be
-     * (much) slower than reads from the backup device, which means this
-     * situation should not occur often.
+     * The segment is copied before this method returns. If all buffers of
+     * the pool are taken, we wait until a write is completed. We don't
+     * expect writes to the replacement device to be (much) slower than
+     * reads from the backup device, which means this situation should not
+     * occur often.
      */
     void requestWrite(char* workspace, unsigned segment, size_t count);
 
@@ -208,27 +231,39 @@ public:
 
     void shutdown();
 
-    struct Request {
-        char* workspace;
-        unsigned segment;
-        size_t count;
-
-        Request(char* w, unsigned s, size_t c)
-            : workspace(w), segment(s), count(c) {}
+    struct Batch {
+        char* buffer;
+        unsigned firstSegment;
+        size_t segments;
+        /// Pages of the last segment (only the last one of the volume may
+        /// be incomplete)
+        size_t lastCount;
     };
 
 private:
-    // Queue of requests
-    std::queue<Request> requests;
+    // Restore manager which owns this object
+    RestoreMgr* restore;
+
+    // Size of segment in pages
+    size_t segmentSize;
+
+    // Maximum number of segments per batch
+    size_t batchSegments;
+
+    // Buffers of batchSegments segments, aligned for direct I/O
+    std::vector<char*> buffers;
+    std::vector<char*> freeBuffers;
+
+    // Batch being filled (buffer is null if none) and sealed batches
+    Batch current;
+    std::deque<Batch> sealed;
 
     // Signal to writer thread that it must exit
     bool shutdownFlag;
 
-    // Restore manager which owns this object
-    RestoreMgr* restore;
-
-    pthread_cond_t requestCond;
-    pthread_mutex_t requestMutex;
+    std::mutex mutex;
+    std::condition_variable writerCond;
+    std::condition_variable freeCond;
 };
 
 RestoreMgr::RestoreMgr(const sm_options& options,
@@ -244,6 +279,7 @@ RestoreMgr::RestoreMgr(const sm_options& options,
 
     instantRestore = options.get_bool_option("sm_restore_instant", true);
     preemptive = options.get_bool_option("sm_restore_preemptive", false);
+    incremental = false;
 
     segmentSize = options.get_int_option("sm_restore_segsize", 1024);
     if (segmentSize <= 0) {
@@ -285,16 +321,13 @@ RestoreMgr::RestoreMgr(const sm_options& options,
             int numSegments = options.get_int_option(
                     "sm_backup_prefetcher_segments", 5);
             w_assert0(numSegments > 0);
-            backup = new BackupPrefetcher(volume, numSegments, segmentSize);
+            int numIOs = options.get_int_option(
+                    "sm_backup_prefetcher_ios", 4);
+            w_assert0(numIOs > 0);
+            backup = new BackupPrefetcher(volume, numSegments, segmentSize,
+                    numIOs);
             dynamic_cast<BackupPrefetcher*>(backup)->fork();
 
-            // Construct asynchronous writer object
-            // Note that this is only valid with a prefetcher reader, because
-            // otherwise only one segment can be fixed at a time
-            if (options.get_bool_option("sm_backup_async_write", true)) {
-                asyncWriter = new SegmentWriter(this);
-                asyncWriter->fork();
-            }
         }
         else {
             W_FATAL_MSG(eBADOPTION,
@@ -310,6 +343,18 @@ RestoreMgr::RestoreMgr(const sm_options& options,
         backup = new DummyBackupReader(segmentSize);
     }
 
+    // Construct asynchronous writer object
+    // Segments are copied by the writer, so any backup reader can be used
+    if (options.get_bool_option("sm_backup_async_write", true)) {
+        int batchSegments = options.get_int_option(
+                "sm_restore_write_batch", 4);
+        int numBuffers = options.get_int_option(
+                "sm_restore_write_buffers", 2);
+        w_assert0(batchSegments > 0 && numBuffers > 0);
+        asyncWriter = new SegmentWriter(this, batchSegments, numBuffers);
+        asyncWriter->fork();
+    }
+
     scheduler = new RestoreScheduler(options, this);
     bitmap = new RestoreBitmap(lastUsedPid / segmentSize + 1);
     replayedBitmap = new RestoreBitmap(lastUsedPid / segmentSize + 1);
@@ -387,6 +432,11 @@ void RestoreMgr::setInstant(bool instant)
     instantRestore = instant;
 }
 
+void RestoreMgr::setIncremental(bool incr)
+{
+    incremental = incr;
+}
+
 bool RestoreMgr::requestRestore(const PageID& pid, generic_page* addr)
 {
     if (pid > lastUsedPid) {
@@ -564,8 +614,12 @@ void RestoreMgr::restoreLoop()
 
         timer.reset();
 
-        char* workspace = backup->fix(segment);
-        ADD_TSTAT(restore_time_read, timer.time_us());
+        // For an incremental backup, the segment is only read if it changed
+        char* workspace = NULL;
+        if (!incremental) {
+            workspace = backup->fix(segment);
+            ADD_TSTAT(restore_time_read, timer.time_us());
+        }
 
         PageID startPID = firstPage;
         PageID endPID = preemptive ? 0 : firstPage + segmentSize;
@@ -582,12 +636,29 @@ void RestoreMgr::restoreLoop()
 
         if (!merger || merger->heapSize() == 0) {
             // segment does not need any log replay
+            INC_TSTAT(restore_skipped_segs);
+            if (incremental) {
+                // unchanged since the previous backup -- nothing to write
+                // (but the async writer marks segments restored in order)
+                replayedBitmap->set(segment);
+                if (asyncWriter) {
+                    asyncWriter->requestWrite(NULL, segment, 0);
+                }
+                else {
+                    markSegmentRestored(segment, true /* redo */);
+                }
+                continue;
+            }
             // CS TODO BUG -- this may be the last seg, so short I/O happens
             finishSegment(workspace, segment, segmentSize);
-            INC_TSTAT(restore_skipped_segs);
             continue;
         }
 
+        if (incremental) {
+            workspace = backup->fix(segment);
+            ADD_TSTAT(restore_time_read, timer.time_us());
+        }
+
         DBG(<< "Restoring segment " << getSegmentForPid(firstPage) << " (pages "
                 << firstPage << " - " << firstPage + segmentSize << ")");
 
@@ -635,8 +706,9 @@ void RestoreMgr::finishSegment(char* workspace, unsigned segment, size_t count)
 
     if (asyncWriter) {
         // place write request on asynchronous writer and move on
-        // (it basically calls writeSegment from another thread)
+        // (the segment is copied, so the workspace can be released)
         asyncWriter->requestWrite(workspace, segment, count);
+        backup->unfix(segment);
     }
     else {
         writeSegment(workspace, segment, count);
@@ -649,7 +721,8 @@ void RestoreMgr::finishSegment(char* workspace, unsigned segment, size_t count)
         if (scheduler->hasWaitingRequest()) {
             PageID next;
             if (scheduler->next(next, true /* peek */)) {
-                backup->prefetch(next);
+                // on-demand requests overtake single-pass prefetching
+                backup->prefetch(getSegmentForPid(next), 1);
             }
         } else {
             backup->prefetch(segment + 1);
@@ -657,20 +730,25 @@ void RestoreMgr::finishSegment(char* workspace, unsigned segment, size_t count)
     }
 }
 
+void RestoreMgr::writePages(PageID first, size_t count, char* buf)
+{
+    // write pages back to replacement device (or backup)
+    if (takeBackup) {
+        W_COERCE(volume->write_backup(first, count, buf));
+    }
+    else {
+        W_COERCE(volume->write_many_pages(first, (generic_page*) buf,
+                    count, true /* ignoreRestore */));
+    }
+}
+
 void RestoreMgr::writeSegment(char* workspace, unsigned segment, size_t count)
 {
     if (count > 0) {
         PageID firstPage = getPidForSegment(segment);
         w_assert0(count <= segmentSize);
 
-        // write pages back to replacement device (or backup)
-        if (takeBackup) {
-            W_COERCE(volume->write_backup(firstPage, count, workspace));
-        }
-        else {
-            W_COERCE(volume->write_many_pages(firstPage, (generic_page*) workspace,
-                        count, true /* ignoreRestore */));
-        }
+        writePages(firstPage, count, workspace);
         DBG(<< "Wrote out " << count << " pages of segment " << segment);
     }
 
@@ -745,7 +823,8 @@ void RestoreMgr::run()
     }
 
     // if doing offline or single-pass restore, prefetch all segments
-    if (!scheduler->isOnDemand() || !instantRestore) {
+    // (unless only the changed ones will be read)
+    if ((!scheduler->isOnDemand() || !instantRestore) && !incremental) {
         unsigned last = getSegmentForPid(lastUsedPid);
         for (unsigned i = 0; i <= last; i++) {
             backup->prefetch(i);
@@ -767,68 +846,125 @@ void RestoreMgr::run()
     w_assert0(finished());
 }
 
-SegmentWriter::SegmentWriter(RestoreMgr* restore)
+SegmentWriter::SegmentWriter(RestoreMgr* restore, size_t batchSegments,
+        size_t numBuffers)
     : smthread_t(t_regular, "SegmentWriter"),
-    shutdownFlag(false), restore(restore)
+    restore(restore), segmentSize(restore->getSegmentSize()),
+    batchSegments(batchSegments), shutdownFlag(false)
 {
     w_assert1(restore);
-    DO_PTHREAD(pthread_mutex_init(&requestMutex, NULL));
-    DO_PTHREAD(pthread_cond_init(&requestCond, NULL));
+
+    size_t bufferSize = batchSegments * segmentSize * sizeof(generic_page);
+    for (size_t i = 0; i < numBuffers; i++) {
+        // Using direct I/O
+        char* buf = NULL;
+        posix_memalign((void**) &buf, LogArchiver::IO_ALIGN, bufferSize);
+        w_assert0(buf);
+        buffers.push_back(buf);
+        freeBuffers.push_back(buf);
+    }
+
+    current.buffer = NULL;
+    current.segments = 0;
 }
 
 SegmentWriter::~SegmentWriter()
 {
-    DO_PTHREAD(pthread_cond_destroy(&requestCond));
-    DO_PTHREAD(pthread_mutex_destroy(&requestMutex));
+    for (size_t i = 0; i < buffers.size(); i++) {
+        free(buffers[i]);
+    }
 }
 
 void SegmentWriter::requestWrite(char* workspace,
         unsigned segment, size_t count)
 {
-    CRITICAL_SECTION(cs, &requestMutex);
-    // mutex held => writer thread waiting for us
+    std::unique_lock<std::mutex> lock(mutex);
+
+    bool append = current.buffer && current.segments < batchSegments
+        && current.lastCount == segmentSize
+        && segment == current.firstSegment + current.segments;
+
+    if (!append) {
+        if (current.buffer) {
+            sealed.push_back(current);
+            current.buffer = NULL;
+        }
+        while (freeBuffers.empty()) {
+            freeCond.wait(lock);
+        }
+        current.buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        current.firstSegment = segment;
+        current.segments = 0;
+    }
 
-    Request req(workspace, segment, count);
-    requests.push(req);
+    // copy under the mutex, since an idle writer may take the batch
+    char* dest = current.buffer
+        + current.segments * segmentSize * sizeof(generic_page);
+    if (count > 0) {
+        memcpy(dest, workspace, count * sizeof(generic_page));
+    }
+    current.segments++;
+    current.lastCount = count;
 
-    pthread_cond_signal(&requestCond);
+    writerCond.notify_one();
 }
 
 void SegmentWriter::run()
 {
     while (true) {
-        DO_PTHREAD(pthread_mutex_lock(&requestMutex));
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (sealed.empty() && !current.buffer) {
+                if (shutdownFlag) { return; }
+                writerCond.wait(lock);
+            }
 
-        while(requests.size() == 0) {
-            struct timespec timeout;
-            sthread_t::timeout_to_timespec(100, timeout); // 100ms
-            int code = pthread_cond_timedwait(&requestCond, &requestMutex,
-                    &timeout);
-            if (code == ETIMEDOUT) {
-                if (shutdownFlag) {
-                    DO_PTHREAD(pthread_mutex_unlock(&requestMutex));
-                    return;
-                }
+            if (!sealed.empty()) {
+                batch = sealed.front();
+                sealed.pop_front();
+            }
+            else {
+                // writer is idle -- take the batch being filled
+                batch = current;
+                current.buffer = NULL;
             }
-            DO_PTHREAD_TIMED(code);
         }
 
-        // copy values to perform write without holding mutex
-        Request req = requests.front();
-        requests.pop();
-
-        DO_PTHREAD(pthread_mutex_unlock(&requestMutex));
-
         stopwatch_t timer;
 
-        restore->writeSegment(req.workspace, req.segment, req.count);
+        size_t pages = (batch.segments - 1) * segmentSize + batch.lastCount;
+        if (pages > 0) {
+            restore->writePages(restore->getPidForSegment(batch.firstSegment),
+                    pages, batch.buffer);
+            DBG(<< "Wrote out " << pages << " pages of segments "
+                    << batch.firstSegment << " - "
+                    << batch.firstSegment + batch.segments - 1);
+        }
+
+        // taking a backup should not generate log records
+        for (size_t i = 0; i < batch.segments; i++) {
+            restore->markSegmentRestored(batch.firstSegment + i,
+                    restore->takeBackup /* redo */);
+        }
 
+        INC_TSTAT(restore_write_batches);
         ADD_TSTAT(restore_async_write_time, timer.time_us());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeBuffers.push_back(batch.buffer);
+        }
+        freeCond.notify_one();
     }
 }
 
 void SegmentWriter::shutdown()
 {
-    CRITICAL_SECTION(cs, &requestMutex);
-    shutdownFlag = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutdownFlag = true;
+    }
+    writerCond.notify_all();
 }
@@ -6,9 +6,11 @@
 #include "sm_base.h"
 #include "logarchiver.h"
 
-#include <queue>
+#include <atomic>
 #include <map>
 
+#include "w_mpsc_queue.h"
+
 class sm_options;
 class RestoreBitmap;
 class RestoreScheduler;
@@ -88,6 +90,13 @@ public:
      */
     void setInstant(bool instant = true);
 
+    /** \brief Set incremental policy
+     *
+     * If true, segments without log records since the backup LSN are
+     * neither read nor written. Used for taking an incremental backup.
+     */
+    void setIncremental(bool incremental = true);
+
     /** \brief Sets the LSN of the restore_begin log record
      *
      * This is required so that we know (up to) which LSN to request from the
@@ -190,6 +199,9 @@ protected:
      */
     bool instantRestore;
 
+    /** \brief Whether to skip unchanged segments (incremental backup) */
+    bool incremental;
+
     /** \brief Always restore sequentially from the requested segment until
      * the next already-restored segment or EOF, unless a new request is
      * waiting in the scheduler. In this case, the current restore is
@@ -258,15 +270,21 @@ protected:
     /** \brief Concludes restore of a segment
      * Processes buffer pool requests when reuse is activated and calls
      * writeSegment() if backup is on synchronous mode. Otherwise places
-     * a write request on the asynchronous SegmentWriter;
+     * a write request on the asynchronous SegmentWriter, which copies the
+     * segment, so that the workspace is released right away.
      */
     void finishSegment(char* workspace, unsigned segment, size_t count);
 
     /** \brief Writes a segment to the replacement device and marks it restored
-     * Used by finishSegment() and SegmentWriter
+     * Used by finishSegment() in synchronous mode
      */
     void writeSegment(char* workspace, unsigned segment, size_t count);
 
+    /** \brief Writes pages to the replacement device (or new backup)
+     * Used by writeSegment() and SegmentWriter
+     */
+    void writePages(PageID first, size_t count, char* buf);
+
     /** \brief Mark a segment as restored in the bitmap
      * Used by writeSegment() and restore_segment_log::redo
      */
@@ -285,13 +303,20 @@ protected:
  * segment has been restored. This class is completely oblivious to pages
  * inside a segment -- it is the callers resposibility to interpret what a
  * segment consists of.
+ *
+ * Bits are packed into atomic 64-bit words, so that get() -- which is called
+ * by RestoreMgr::isRestored() on every buffer pool fix during instant restore
+ * -- is a single load and set() a single fetch-or, without any latch. Since
+ * bits only go from false to true during restore, a concurrent serialize()
+ * or getBoundaries() may miss recent updates but never sees an inconsistent
+ * state.
  */
 class RestoreBitmap {
 public:
     RestoreBitmap(size_t size);
     virtual ~RestoreBitmap();
 
-    size_t getSize() { return bits.size(); }
+    size_t getSize() { return size; }
 
     bool get(unsigned i);
     void set(unsigned i);
@@ -308,8 +333,16 @@ public:
     void getBoundaries(size_t& lowestFalse, size_t& highestTrue);
 
 protected:
-    std::vector<bool> bits;
-    srwlock_t mutex;
+    static const size_t BITS_PER_WORD = 64;
+
+    size_t size;
+    std::atomic<uint64_t>* words;
+
+    bool getBit(size_t i)
+    {
+        return words[i / BITS_PER_WORD].load(std::memory_order_acquire)
+            & (1ULL << (i % BITS_PER_WORD));
+    }
 };
 
 /** \brief Scheduler for restore operations. Decides what page to restore next.
@@ -336,11 +369,13 @@ public:
 protected:
     RestoreMgr* restore;
 
-    srwlock_t mutex;
-    std::queue<PageID> queue;
+    /** Requests are enqueued by transaction threads, which must not block
+     * on each other, and consumed only by the restore loop.
+     */
+    MPSCQueue<PageID> queue;
 
     /// Perform single-pass restore while no requests are available
-    bool trySinglePass;
+    std::atomic<bool> trySinglePass;
     /// Support on-demand scheduling (if false, trySinglePass must be true)
     bool onDemand;
 
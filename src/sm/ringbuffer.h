@@ -9,6 +9,9 @@
 #include "smthread.h"
 #include "sm_base.h"
 
+#include <atomic>
+#include <sched.h>
+
 /**
  * Simple implementation of a circular IO buffer for the archiver reader,
  * which reads log records from the recovery log, and the archiver writer,
@@ -24,9 +27,13 @@
  *
  * The allocation of buffer blocks (by both producers and consumers)
  * must be done in two stages:
- * 1) Request a block, waiting on a condvar if buffer is empty/full
+ * 1) Request a block, spinning and then sleeping if buffer is empty/full
  * 2) Once done, release it to the other producer/consumer thread
  *
+ * Since there is a single producer and a single consumer, the handoff is
+ * lock-free: each side only advances its own counter with release
+ * semantics and reads the other one with acquire semantics.
+ *
  * Requests could be implemented in a single step if we copy
  * the block to the caller's memory, but we want to avoid that.
  * Again, this assumes that only one thread is consuming and one is
@@ -43,144 +50,135 @@ public:
     char* consumerRequest();
     void consumerRelease();
 
-    bool isFull() { return begin == end && bparity != eparity; }
-    bool isEmpty() { return begin == end && bparity == eparity; }
+    bool isFull()
+    {
+        return end.load(std::memory_order_acquire)
+            - begin.load(std::memory_order_acquire) == blockCount;
+    }
+    bool isEmpty()
+    {
+        return end.load(std::memory_order_acquire)
+            == begin.load(std::memory_order_acquire);
+    }
     size_t getBlockSize() { return blockSize; }
     size_t getBlockCount() { return blockCount; }
-    void set_finished(bool f = true) { finished = f; }
-    bool* get_finished() { return &finished; } // not thread-safe
+    void set_finished(bool f = true)
+    {
+        finished.store(f, std::memory_order_release);
+    }
     bool isFinished(); // thread-safe
 
 
     AsyncRingBuffer(size_t bsize, size_t bcount)
-        : begin(0), end(0), bparity(true), eparity(true),
-        finished(false), blockSize(bsize), blockCount(bcount)
+        : begin(0), end(0), finished(false),
+        blockSize(bsize), blockCount(bcount)
     {
-        buf = new char[blockCount * blockSize];
-        DO_PTHREAD(pthread_mutex_init(&mutex, NULL));
-        DO_PTHREAD(pthread_cond_init(&notEmpty, NULL));
-        DO_PTHREAD(pthread_cond_init(&notFull, NULL));
+        // Blocks are aligned so that they can be used for direct I/O
+        int res = posix_memalign((void**) &buf, BUFFER_ALIGN,
+                blockCount * blockSize);
+        w_assert0(res == 0);
     }
 
     ~AsyncRingBuffer()
     {
-        delete buf;
-        DO_PTHREAD(pthread_mutex_destroy(&mutex));
-        DO_PTHREAD(pthread_cond_destroy(&notEmpty));
-        DO_PTHREAD(pthread_cond_destroy(&notFull));
+        free(buf);
     }
 
+    static const size_t BUFFER_ALIGN = 4096;
+
 private:
     char * buf;
-    int begin;
-    int end;
-    bool bparity;
-    bool eparity;
-    bool finished;
+
+    /*
+     * Monotonically increasing block counters; the block index is the
+     * counter modulo blockCount. Only the consumer modifies begin and only
+     * the producer modifies end, so no read-modify-write is needed.
+     */
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+    std::atomic<bool> finished;
 
     const size_t blockSize;
     const size_t blockCount;
 
-    pthread_mutex_t mutex;
-    pthread_cond_t notEmpty;
-    pthread_cond_t notFull;
-
-    bool wait(pthread_cond_t*);
+    bool wait(unsigned& rounds);
 
-    void increment(int& p, bool& parity) { 
-        p = (p + 1) % blockCount;
-        if (p == 0) {
-            parity = !parity;
-        }
-    }
+    char* blockAt(uint64_t p) { return buf + ((p % blockCount) * blockSize); }
 };
 
 
-inline bool AsyncRingBuffer::wait(pthread_cond_t* cond)
+/*
+ * Called by a producer or consumer while the buffer is full or empty,
+ * respectively. Spins for a short while, since the other side is usually
+ * just about to release a block, and then backs off by sleeping. Returns
+ * false if the request should be aborted, i.e., if the finished flag is set
+ * and there are no more blocks to consume.
+ */
+inline bool AsyncRingBuffer::wait(unsigned& rounds)
 {
-    struct timespec timeout;
-    sthread_t::timeout_to_timespec(100, timeout); // 100ms
-    // caller must have locked mutex!
-    int code = pthread_cond_timedwait(cond, &mutex, &timeout);
-    if (code == ETIMEDOUT) {
-        //DBGTHRD(<< "Wait timed out -- try again");
-        if (finished && isEmpty()) {
-            DBGTHRD(<< "Wait aborted: finished flag is set");
-            return false;
-        }
+    if (finished.load(std::memory_order_acquire) && isEmpty()) {
+        DBGTHRD(<< "Wait aborted: finished flag is set");
+        return false;
+    }
+
+    const unsigned SPIN_ROUNDS = 128;
+    if (rounds++ < SPIN_ROUNDS) {
+        ::sched_yield();
+    }
+    else {
+        ::usleep(100);
     }
-    DO_PTHREAD_TIMED(code);
     return true;
 }
 
 inline char* AsyncRingBuffer::producerRequest()
 {
-    CRITICAL_SECTION(cs, mutex);
+    unsigned rounds = 0;
     while (isFull()) {
-        DBGTHRD(<< "Waiting for condition notFull ...");
-        if (!wait(&notFull)) {
+        if (!wait(rounds)) {
             DBGTHRD(<< "Produce request failed!");
             return NULL;
         }
     }
-    DBGTHRD(<< "Producer request: block " << end);
-    return buf + (end * blockSize);
+    DBGTHRD(<< "Producer request: block " << end % blockCount);
+    return blockAt(end.load(std::memory_order_relaxed));
 }
 
 inline void AsyncRingBuffer::producerRelease()
 {
-    CRITICAL_SECTION(cs, mutex);
-    bool wasEmpty = isEmpty();
-    increment(end, eparity);
-    DBGTHRD(<< "Producer release, new end is " << end);
-
-    if (wasEmpty) {
-        DBGTHRD(<< "Signal buffer not empty");
-        DO_PTHREAD(pthread_cond_signal(&notEmpty));
-    }
+    end.store(end.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    DBGTHRD(<< "Producer release, new end is " << end % blockCount);
 }
 
 inline char* AsyncRingBuffer::consumerRequest()
 {
-    CRITICAL_SECTION(cs, mutex);
+    unsigned rounds = 0;
     while (isEmpty()) {
-        DBGTHRD(<< "Waiting for condition notEmpty ...");
-        if (!wait(&notEmpty)) {
+        if (!wait(rounds)) {
             DBGTHRD(<< "Consume request failed!");
             return NULL;
         }
     }
-    DBGTHRD(<< "Consumer request: block " << begin);
-    return buf + (begin * blockSize);
+    DBGTHRD(<< "Consumer request: block " << begin % blockCount);
+    return blockAt(begin.load(std::memory_order_relaxed));
 }
 
 inline void AsyncRingBuffer::consumerRelease()
 {
-    CRITICAL_SECTION(cs, mutex);
-    bool wasFull = isFull();
-    increment(begin, bparity);
-    DBGTHRD(<< "Consumer release, new begin is " << begin);
-
-    if (wasFull) {
-        DBGTHRD(<< "Signal buffer not full");
-        DO_PTHREAD(pthread_cond_signal(&notFull));
-    }
+    begin.store(begin.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    DBGTHRD(<< "Consumer release, new begin is " << begin % blockCount);
 }
 
 inline bool AsyncRingBuffer::isFinished()
 {
     /*
-     * Acquiring the mutex here is done to ensure consistency
-     * of modifications to the finished flag. It creates a memory
-     * fence to ensure the correct order of operations in the case
-     * where one thread reading the flag after another one has set it.
-     *
      * Caution! This does not mean that there are no blocks left for
      * consumption---just that someone set the finished flag. The former
      * case must be checked by calling producerRequest()
      */
-    CRITICAL_SECTION(cs, mutex);
-    return finished;
+    return finished.load(std::memory_order_acquire);
 }
 
 #endif
@@ -76,11 +76,16 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "bf_tree.h"
 #include "stopwatch.h"
 #include "alloc_cache.h"
+#include "version_store.h"
+#include "ghost_reclaimer.h"
+#include "btree_maintainer.h"
+#include "btree_partition.h"
 
 #include "allocator.h"
 #include "plog_xct.h"
 #include "log_core.h"
 #include "eventlog.h"
+#include "eventtrace.h"
 
 
 bool         smlevel_0::shutdown_clean = false;
@@ -101,6 +106,7 @@ bool        smlevel_0::logging_enabled = true;
 bool        smlevel_0::do_prefetch = false;
 
 bool        smlevel_0::statistics_enabled = true;
+bool        smlevel_0::latency_stats_enabled = false;
 
 /*
  * _being_xct_mutex: Used to prevent xct creation during volume dismount.
@@ -119,6 +125,7 @@ bf_tree_m* smlevel_0::bf = 0;
 log_core* smlevel_0::log = 0;
 log_core* smlevel_0::clog = 0;
 LogArchiver* smlevel_0::logArchiver = 0;
+event_tracer* smlevel_0::tracer = 0;
 
 lock_m* smlevel_0::lm = 0;
 
@@ -130,6 +137,11 @@ restart_m* smlevel_0::recovery = 0;
 
 btree_m* smlevel_0::bt = 0;
 
+version_store_t* smlevel_0::versions = 0;
+ghost_reclaimer_t* smlevel_0::reclaimer = 0;
+btree_maintainer_t* smlevel_0::maintainer = 0;
+partition_table_t* smlevel_0::partitions = 0;
+
 ss_m* smlevel_top::SSM = 0;
 
 smlevel_0::xct_impl_t smlevel_0::xct_impl
@@ -244,6 +256,13 @@ ss_m::_construct_once()
     //     shutdown_clean = true;
     // }
 
+    // Event tracing must be up before the volume is opened, so that all
+    // page reads are captured
+    if (!_options.get_string_option("sm_trace_file", "").empty()) {
+        tracer = new event_tracer(_options);
+        tracer->start();
+    }
+
     ERROUT(<< "[" << timer.time_ms() << "] Initializing lock manager");
 
     lm = new lock_m(_options);
@@ -291,6 +310,14 @@ ss_m::_construct_once()
 
     ERROUT(<< "[" << timer.time_ms() << "] Initializing volume manager");
 
+    // Page layouts are compiled for SM_PAGESIZE, so it is the only page size
+    // a volume can be formatted or opened with
+    int page_size = _options.get_int_option("sm_page_size", SM_PAGESIZE);
+    if (page_size != SM_PAGESIZE) {
+        W_FATAL_MSG(eBADPAGESIZE, << "Requested page size " << page_size
+                << " but SM_PAGESIZE is " << SM_PAGESIZE);
+    }
+
     // If not instant restart, pass null dirty page table, which disables REDO
     // recovery based on SPR so that it is done explicitly by restart_m below.
     vol = new vol_t(_options,
@@ -317,6 +344,8 @@ ss_m::_construct_once()
     }
 
     smlevel_0::statistics_enabled = _options.get_bool_option("sm_statistics", true);
+    smlevel_0::latency_stats_enabled =
+        _options.get_bool_option("sm_latency_stats", false);
 
     ERROUT(<< "[" << timer.time_ms() << "] Initializing buffer cleaner and other services");
 
@@ -325,6 +354,19 @@ ss_m::_construct_once()
         W_FATAL(eOUTOFMEMORY);
     }
     bt->construct_once();
+    partitions = new partition_table_t();
+
+    if (_options.get_bool_option("sm_snapshot_reads", false)) {
+        versions = new version_store_t();
+    }
+
+    if (_options.get_bool_option("sm_ghost_reclaim", false)) {
+        reclaimer = new ghost_reclaimer_t(_options);
+    }
+
+    if (_options.get_bool_option("sm_btree_maintenance", false)) {
+        maintainer = new btree_maintainer_t(_options);
+    }
 
     chkpt = new chkpt_m(_options);
     if (! chkpt)  {
@@ -369,6 +411,14 @@ ss_m::_construct_once()
         // }
     }
 
+    if (reclaimer) {
+        W_COERCE(reclaimer->fork());
+    }
+
+    if (maintainer) {
+        W_COERCE(maintainer->fork());
+    }
+
     ERROUT(<< "[" << timer.time_ms() << "] Finished SM initialization");
 }
 
@@ -406,6 +456,14 @@ ss_m::_destruct_once()
         me()->detach_xct(xct());
     }
 
+    if (reclaimer) {
+        reclaimer->stop();
+    }
+
+    if (maintainer) {
+        maintainer->stop();
+    }
+
     ERROUT(<< "Terminating recovery manager");
     if (recovery) {
         delete recovery;
@@ -456,6 +514,8 @@ ss_m::_destruct_once()
     lm->assert_empty(); // no locks should be left
     bt->destruct_once();
     delete bt; bt = 0; // btree manager
+    delete partitions; partitions = 0;
+    delete versions; versions = 0;
     delete lm; lm = 0;
 
     ERROUT(<< "Terminating log archiver");
@@ -479,6 +539,8 @@ ss_m::_destruct_once()
         delete logArchiver; // LL: decoupled cleaner in bf still needs archiver
         logArchiver = 0;    //     so we delete it only after bf is gone
     }
+    delete reclaimer; reclaimer = 0; // also reported to by the cleaner
+    delete maintainer; maintainer = 0;
 
     ERROUT(<< "Terminating volume");
     // this should come before xct and log shutdown so that any
@@ -495,6 +557,13 @@ ss_m::_destruct_once()
     }
     log = 0;
 
+    if (tracer) {
+        event_tracer* t = tracer;
+        tracer = 0;
+        t->shutdown();
+        delete t;
+    }
+
      w_rc_t        e;
      char        *unused;
      e = smthread_t::set_bufsize(0, unused);
@@ -562,6 +631,36 @@ ss_m::begin_xct(tid_t& tid, timeout_in_ms timeout)
     return RCOK;
 }
 
+rc_t
+ss_m::begin_snapshot_xct(timeout_in_ms timeout)
+{
+    if (!versions) {
+        return RC(eNOSNAPSHOTS);
+    }
+
+    tid_t tid;
+    W_DO(_begin_xct(0, tid, timeout));
+    xct()->set_query_concurrency(t_cc_none);
+    xct()->set_snapshot(versions->begin_snapshot());
+    return RCOK;
+}
+
+/*
+ * Releases the snapshot of a snapshot transaction, or stamps (on commit) or
+ * discards (on abort) the record versions saved by an updating transaction.
+ */
+static void end_xct_versions(xct_t& x, const tid_t& tid, bool committed)
+{
+    if (!smlevel_0::versions || x.is_sys_xct()) { return; }
+
+    if (x.is_snapshot_xct()) {
+        smlevel_0::versions->end_snapshot(x.get_snapshot());
+    }
+    else {
+        smlevel_0::versions->end_writer(tid, committed);
+    }
+}
+
 rc_t ss_m::begin_sys_xct(bool single_log_sys_xct,
     sm_stats_info_t *stats, timeout_in_ms timeout)
 {
@@ -998,6 +1097,7 @@ ss_m::_commit_xct(sm_stats_info_t*& _stats, bool lazy,
     w_assert1(x.ssx_chain_len() == 0);
 
     W_DO( x.commit(lazy,plastlsn) );
+    end_xct_versions(x, x.tid(), true);
 
     if(x.is_instrumented()) {
         _stats = x.steal_stats();
@@ -1079,6 +1179,7 @@ ss_m::_commit_xct_group(xct_t *list[], int listlen)
         me()->attach_xct(x);
         W_DO(x->commit_free_locks());
         me()->detach_xct(x);
+        end_xct_versions(*x, x->tid(), true);
         delete x;
     }
     return RCOK;
@@ -1096,8 +1197,14 @@ ss_m::_chain_xct(
     w_assert3(xct() != 0);
     xct_t* x = xct();
 
+    tid_t old_tid = x->tid();
     W_DO( x->chain(lazy) );
     w_assert3(xct() == x);
+    end_xct_versions(*x, old_tid, true);
+    if (x->is_snapshot_xct()) {
+        // the chained transaction sees the commits made so far
+        x->set_snapshot(versions->begin_snapshot());
+    }
     if(x->is_instrumented()) {
         _stats = x->steal_stats();
         _stats->compute();
@@ -1126,6 +1233,7 @@ ss_m::_abort_xct(sm_stats_info_t*&             _stats)
     bool was_sys_xct W_IFDEBUG3(= x.is_sys_xct());
 
     W_DO( x.abort(true /* save _stats structure */) );
+    end_xct_versions(x, x.tid(), false);
     if(x.is_instrumented()) {
         _stats = x.steal_stats();
         _stats->compute();
@@ -1327,6 +1435,7 @@ operator<<(ostream &o, const sm_stats_info_t &s)
 {
     o << s.bfht;
     o << s.sm;
+    o << s.lat;
     return o;
 }
 
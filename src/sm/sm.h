@@ -74,6 +74,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include <smstats.h> // declares sm_stats_info_t and sm_config_info_t
 #include <lsn.h>
 #include <string>
+#include <vector>
 #include "sm_options.h"
 
 /* DOXYGEN Documentation : */
@@ -179,6 +180,14 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
  *      - default: no
  *      - required?: no
  *
+ * -sm_bufferpool_optimistic_reads
+ *      - type: Boolean
+ *      - description: Lets B-tree traversals read interior pages without
+ *      latching them, validating frame versions instead. Only effective
+ *      with sm_bufferpool_swizzle.
+ *      - default: yes
+ *      - required?: no
+ *
  * -sm_num_page_writers
  *      - type: number
  *      - description: greater than or equal to 1; this is the number of
@@ -222,6 +231,45 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
  *      - default: no
  *      - required?: no
  *
+ * -sm_latency_stats
+ *      - type: Boolean
+ *      - description: Enables per-thread latency histograms for page fixes,
+ *      lock acquisitions, log flush waits and commits (see
+ *      sm_latency_stats_t).
+ *      - default: no
+ *      - required?: no
+ *
+ * -sm_ticker_latency_file
+ *      - type: string
+ *      - description: If set (and sm_ticker_enable is on), the ticker
+ *      thread writes the merged latency histograms to this file every
+ *      second.
+ *      - default: none
+ *      - required?: no
+ *
+ * -sm_trace_file
+ *      - type: string
+ *      - description: If set, page reads, page writes and evictions are
+ *      recorded in per-thread binary trace buffers and appended to this file
+ *      by a background thread (see event_tracer). Page reads are then no
+ *      longer logged. Use the "tracecat" command to convert the file.
+ *      - default: none
+ *      - required?: no
+ *
+ * -sm_trace_ring_size
+ *      - type: number
+ *      - description: Capacity (in events) of each per-thread trace buffer;
+ *      events are dropped when a buffer is full.
+ *      - default: 16384
+ *      - required?: no
+ *
+ * -sm_trace_flush_interval
+ *      - type: number
+ *      - description: Interval in milliseconds at which trace buffers are
+ *      written to the trace file.
+ *      - default: 100
+ *      - required?: no
+ *
  * -sm_restart
  *  - type: number
  *  - description: control internal restart/recovery mode
@@ -277,6 +325,23 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
  *      - description: Size of sort workspace of log archiver
  *      - default: 104857600 (100 MB)
  *      - required?: no
+ *
+ *  -sm_archiver_workers;
+ *      - type:  int
+ *      - description: Number of sort workers used by the log archiver for
+ *      run generation. The workspace is divided among them and each run is
+ *      sorted in parallel. With a single worker, replacement selection is
+ *      used.
+ *      - default: 1
+ *      - required?: no
+ *
+ *  -sm_archiver_prealloc_size;
+ *      - type:  int
+ *      - description: Space in MB preallocated for each run file of the log
+ *      archiver (unused space is released when the run is closed). Zero
+ *      disables preallocation.
+ *      - default: 100
+ *      - required?: no
  *
   */
 
@@ -406,6 +471,8 @@ class w_keystr_t;
 class verify_volume_result;
 class lil_global_table;
 struct okvl_mode;
+class overflow_writer_t;
+class overflow_reader_t;
 
 class key_ranges_map;
 /**\addtogroup SSMSP
@@ -687,6 +754,22 @@ public:
         tid_t&                   tid,
         timeout_in_ms            timeout = WAIT_SPECIFIED_BY_THREAD);
 
+    /**\brief Begin a read-only snapshot transaction.
+     *\ingroup SSMXCT
+     * @param[in] timeout   Optional, controls blocking behavior.
+     * \details
+     * The transaction sees the committed state of the database as of its
+     * start in find_assoc and bt_cursor_t, without acquiring any locks, and
+     * fails with eSNAPSHOTUPDATE if it tries to update. It is ended with
+     * commit_xct or abort_xct like any other transaction.
+     *
+     * Requires option sm_snapshot_reads (eNOSNAPSHOTS otherwise), which makes
+     * updating transactions save the before-images of the records they
+     * modify; see version_store_t.
+     */
+    static rc_t           begin_snapshot_xct(
+        timeout_in_ms            timeout = WAIT_SPECIFIED_BY_THREAD);
+
     /**
      * \brief Being a new system transaction which might be a nested transaction.
      * \ingroup SSMXCT
@@ -1195,6 +1278,38 @@ public:
      */
     static rc_t            destroy_index(const StoreID& iid);
 
+    /**\brief Create a B+-Tree index partitioned by key range.
+     * \ingroup SSMBTREE
+     * @param[out] stid New store ID of the partitioned index will be returned here.
+     * @param[in] bounds  Lowest key of each partition but the first, in
+     * increasing order. The index has bounds.size()+1 partitions.
+     * \details
+     * Each partition is a B-tree with its own root page, so that inserts
+     * into different partitions neither latch nor lock the same root.
+     * The returned ID is used with the functions of this class like that of
+     * any other index: operations on a key are routed to its partition,
+     * and a bt_cursor_t returns the keys of all partitions in order.
+     * See partition_table_t.
+     */
+    static rc_t            create_partitioned_index(
+                StoreID&               stid,
+                const std::vector<w_keystr_t>& bounds
+    );
+
+    /**\brief Create a B+-Tree index partitioned by a hash of the key.
+     * \ingroup SSMBTREE
+     * @param[out] stid New store ID of the partitioned index will be returned here.
+     * @param[in] count  Number of partitions.
+     * \details
+     * Like create_partitioned_index(StoreID&, const std::vector<w_keystr_t>&),
+     * but spreads any key distribution evenly, at the cost of a merge over
+     * all partitions in every cursor.
+     */
+    static rc_t            create_partitioned_index(
+                StoreID&               stid,
+                uint32_t               count
+    );
+
     /**\cond skip */
     static rc_t            print_index(StoreID stid);
     /**\endcond skip */
@@ -1283,6 +1398,37 @@ public:
         const w_keystr_t&             key
     );
 
+    /** \brief Remove all entries in a key range of a B+-Tree index.
+     * \ingroup SSMBTREE
+     * @param[in] stid  ID of the index.
+     * @param[in] low   Lowest key removed.
+     * @param[in] high  First key after the removed range, or supremum.
+     * \details
+     * Meant for bulk purges: instead of a ghost-mark log record per key,
+     * each leaf in the range is cleared with one log record holding only
+     * the range, and emptied leaves are merged away and freed.
+     *
+     * Like a TRUNCATE, this cannot run in an active transaction
+     * (eINTRANS) and is not undone: it runs in its own transaction, which
+     * holds an exclusive lock on the index while removing the range and
+     * commits when done. A failure or a crash in the middle may leave only
+     * part of the range removed.
+     */
+    static rc_t            remove_range(
+        StoreID                   stid,
+        const w_keystr_t&         low,
+        const w_keystr_t&         high
+    );
+
+    /** \brief Remove all entries of a B+-Tree index.
+     * \ingroup SSMBTREE
+     * @param[in] stid  ID of the index.
+     * \details
+     * Same as remove_range() over the whole key space. The index itself
+     * remains, empty.
+     */
+    static rc_t            truncate_index(StoreID stid);
+
     /** \brief Find an entry associated with a key in a B+-Tree index.
      * \ingroup SSMBTREE
      *
@@ -1306,6 +1452,53 @@ public:
         bool&                   found
     );
 
+    /**
+     * \brief Create or replace an entry with a large value in a B+-Tree index.
+     * \ingroup SSMBTREE
+     *
+     * @param[in] stid  ID of the index.
+     * @param[in] key  Key for the association to be created or replaced.
+     * @param[in] writer  Writer into which the value was streamed; it is
+     *                    finished by this call.
+     *
+     * Unlike put_assoc, the size of the value is not limited by \ref
+     * max_entry_size. The value is kept in overflow pages outside of the
+     * index (see btree_overflow.h) and the entry only holds a reference to
+     * them. A large value previously associated with the key is deallocated.
+     */
+    static rc_t            put_large_assoc(
+        StoreID                   stid,
+        const w_keystr_t&        key,
+        overflow_writer_t&       writer
+    );
+
+    /** \brief Find an entry with a large value in a B+-Tree index.
+     * \ingroup SSMBTREE
+     *
+     * @param[in] stid  ID of the index.
+     * @param[in] key   Key of the entry.
+     * @param[out] reader  Opened on the value of the entry, if found.
+     * @param[out] found   True if an entry is found.
+     *
+     * Returns eNOTOVERFLOW if the entry was not created with put_large_assoc.
+     */
+    static rc_t            find_large_assoc(
+        StoreID                  stid,
+        const w_keystr_t&        key,
+        overflow_reader_t&       reader,
+        bool&                    found
+    );
+
+    /** \brief Remove an entry with a large value from a B+-Tree index.
+     * \ingroup SSMBTREE
+     * @param[in] stid  ID of the index.
+     * @param[in] key   Key of the entry to be removed.
+     */
+    static rc_t            destroy_large_assoc(
+        StoreID                   stid,
+        const w_keystr_t&             key
+    );
+
     /**
      * \brief Defrags the given page to remove holes and ghost records in the page.
      * \ingroup SSMBTREE
@@ -99,6 +99,7 @@ class comm_m;
 class log_core;
 class lock_m;
 class LogArchiver;
+class event_tracer;
 
 class tid_t;
 class option_t;
@@ -111,6 +112,10 @@ class sm_tls_allocator;
 class chkpt_m;
 class restart_m;
 class btree_m;
+class version_store_t;
+class ghost_reclaimer_t;
+class btree_maintainer_t;
+class partition_table_t;
 class ss_m;
 
 #ifndef        SM_EXTENTSIZE
@@ -310,6 +315,7 @@ public:
     static log_core* log;
     static log_core* clog;
     static LogArchiver* logArchiver;
+    static event_tracer* tracer;
 
     static int    dcommit_timeout; // to convey option to coordinator,
                                    // if it is created by VAS
@@ -331,6 +337,7 @@ public:
     static bool         lock_caching_default;
     static bool         do_prefetch;
     static bool         statistics_enabled;
+    static bool         latency_stats_enabled;
 
     // This is a zeroed page for use wherever initialized memory
     // is needed.
@@ -413,6 +420,18 @@ public:
 
     static btree_m* bt;
 
+    /// Versions for snapshot reads, NULL unless sm_snapshot_reads is set
+    static version_store_t* versions;
+
+    /// Background defragmentation of leaves, NULL unless sm_ghost_reclaim is set
+    static ghost_reclaimer_t* reclaimer;
+
+    /// Background adopts and merges, NULL unless sm_btree_maintenance is set
+    static btree_maintainer_t* maintainer;
+
+    /// Maps of the partitioned indexes, see ss_m::create_partitioned_index
+    static partition_table_t* partitions;
+
     static ss_m*    SSM;    // we will change to lower case later
 
     /**\brief Store property that controls logging of pages in the store.
@@ -12,11 +12,56 @@
 #include "btree.h"
 #include "suppress_unused.h"
 #include "vol.h"
+#include "version_store.h"
+#include "btree_partition.h"
+#include "btcursor.h"
+
+#include <vector>
 
 /*==============================================================*
  *  Physical ID version of all the index operations                *
  *==============================================================*/
 
+static bool in_snapshot_xct()
+{
+    xct_t* x = xct();
+    return x && x->is_snapshot_xct();
+}
+
+/*
+ * Called before a record is modified, to save its current state for
+ * snapshot transactions (see version_store_t).
+ */
+static rc_t save_version(StoreID stid, const w_keystr_t& key)
+{
+    if (in_snapshot_xct()) {
+        return RC(eSNAPSHOTUPDATE);
+    }
+    xct_t* x = xct();
+    if (!smlevel_0::versions || !x || x->is_sys_xct()) {
+        return RCOK;
+    }
+
+    std::vector<char> el(SM_PAGESIZE);
+    smsize_t elen = el.size();
+    bool found;
+    W_DO(smlevel_0::bt->lookup(stid, key, &el[0], elen, found));
+    smlevel_0::versions->save(stid, key, x->tid(), found, &el[0], elen);
+    return RCOK;
+}
+
+/*
+ * Replaces the ID of a partitioned index with that of the partition holding
+ * the key (see partition_table_t).
+ */
+static rc_t route_key(StoreID& stid, const w_keystr_t& key)
+{
+    if (partition_table_t::is_partitioned(stid)) {
+        W_DO(smlevel_0::partitions->route(stid, key));
+    }
+    return RCOK;
+}
+
 rc_t ss_m::create_index(StoreID &stid)
 {
     // W_DO(lm->intent_vol_lock(vid, okvl_mode::IX)); // take IX on volume
@@ -31,6 +76,24 @@ rc_t ss_m::create_index(StoreID &stid)
     return RCOK;
 }
 
+rc_t ss_m::create_partitioned_index(StoreID &stid,
+        const std::vector<w_keystr_t>& bounds)
+{
+    partitioning_t map;
+    map.kind = partitioning_t::t_range;
+    map.bounds = bounds;
+    W_DO(partitions->create(map, bounds.size() + 1, stid));
+    return RCOK;
+}
+
+rc_t ss_m::create_partitioned_index(StoreID &stid, uint32_t count)
+{
+    partitioning_t map;
+    map.kind = partitioning_t::t_hash;
+    W_DO(partitions->create(map, count, stid));
+    return RCOK;
+}
+
 rc_t ss_m::destroy_index(const StoreID& stid)
 {
     // take IX on volume, X on the index
@@ -42,6 +105,14 @@ rc_t ss_m::destroy_index(const StoreID& stid)
 
 rc_t ss_m::print_index(StoreID stid)
 {
+    if (partition_table_t::is_partitioned(stid)) {
+        const partitioning_t* map;
+        W_DO(partitions->get(stid, map));
+        for (size_t i = 0; i < map->stores.size(); ++i) {
+            W_DO(print_index(map->stores[i]));
+        }
+        return RCOK;
+    }
     PageID root_pid;
     W_DO(open_store_nolock (stid, root_pid)); // this method is for debugging
     bt->print(root_pid);
@@ -50,6 +121,17 @@ rc_t ss_m::print_index(StoreID stid)
 
 rc_t ss_m::touch_index(StoreID stid, uint64_t &page_count)
 {
+    if (partition_table_t::is_partitioned(stid)) {
+        const partitioning_t* map;
+        W_DO(partitions->get(stid, map));
+        page_count = 0;
+        for (size_t i = 0; i < map->stores.size(); ++i) {
+            uint64_t count;
+            W_DO(touch_index(map->stores[i], count));
+            page_count += count;
+        }
+        return RCOK;
+    }
     PageID root_pid;
     W_DO(open_store_nolock (stid, root_pid)); // this method is for debugging
     bt->touch_all(stid, page_count);
@@ -58,24 +140,30 @@ rc_t ss_m::touch_index(StoreID stid, uint64_t &page_count)
 
 rc_t ss_m::create_assoc(StoreID stid, const w_keystr_t& key, const vec_t& el)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     W_DO(open_store (stid, root_pid, true));
+    W_DO(save_version(stid, key));
     W_DO( bt->insert(stid, key, el) );
     return RCOK;
 }
 
 rc_t ss_m::update_assoc(StoreID stid, const w_keystr_t& key, const vec_t& el)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     W_DO( open_store (stid, root_pid, true));
+    W_DO(save_version(stid, key));
     W_DO( bt->update(stid, key, el) );
     return RCOK;
 }
 
 rc_t ss_m::put_assoc(StoreID stid, const w_keystr_t& key, const vec_t& el)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     W_DO( open_store (stid, root_pid, true));
+    W_DO(save_version(stid, key));
     W_DO( bt->put(stid, key, el) );
     return RCOK;
 }
@@ -83,32 +171,177 @@ rc_t ss_m::put_assoc(StoreID stid, const w_keystr_t& key, const vec_t& el)
 rc_t ss_m::overwrite_assoc(StoreID stid, const w_keystr_t &key,
     const char *el, smsize_t offset, smsize_t elen)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     W_DO( open_store (stid, root_pid, true));
+    W_DO(save_version(stid, key));
     W_DO( bt->overwrite(stid, key, el, offset, elen) );
     return RCOK;
 }
 
 rc_t ss_m::destroy_assoc(StoreID stid, const w_keystr_t& key)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     W_DO(open_store (stid, root_pid, true));
+    W_DO(save_version(stid, key));
     W_DO( bt->remove(stid, key) );
     return RCOK;
 }
 
+/*
+ * Saves the current state of every record in [low, high) for snapshot
+ * transactions, before remove_range drops them.
+ */
+static rc_t save_range_versions(StoreID stid, const w_keystr_t& low,
+        const w_keystr_t& high)
+{
+    if (!smlevel_0::versions) {
+        return RCOK;
+    }
+    bt_cursor_t cursor(stid, low, true, high, false, true);
+    while (true) {
+        W_DO(cursor.next());
+        if (cursor.eof()) {
+            break;
+        }
+        smlevel_0::versions->save(stid, cursor.key(), xct()->tid(), true,
+                cursor.elem(), cursor.elen());
+    }
+    return RCOK;
+}
+
+static rc_t remove_range_core(StoreID stid, const w_keystr_t& low,
+        const w_keystr_t& high)
+{
+    PageID root_pid;
+    W_DO(ss_m::open_store_nolock(stid, root_pid));
+    // nothing is undone, so no one else may have uncommitted updates here
+    W_DO(smlevel_0::lm->intent_store_lock(stid, okvl_mode::X));
+    W_DO(save_range_versions(stid, low, high));
+    W_DO(smlevel_0::bt->remove_range(stid, low, high));
+    return RCOK;
+}
+
+rc_t ss_m::remove_range(StoreID stid, const w_keystr_t& low,
+        const w_keystr_t& high)
+{
+    if (xct()) {
+        return RC(eINTRANS);
+    }
+    if (partition_table_t::is_partitioned(stid)) {
+        const partitioning_t* map;
+        W_DO(partitions->get(stid, map));
+        for (size_t i = 0; i < map->stores.size(); ++i) {
+            if (map->overlaps(i, low, high)) {
+                W_DO(remove_range(map->stores[i], low, high));
+            }
+        }
+        return RCOK;
+    }
+
+    W_DO(begin_xct());
+    rc_t rc = remove_range_core(stid, low, high);
+    if (rc.is_error()) {
+        W_DO(abort_xct());
+        return rc;
+    }
+    W_DO(commit_xct());
+    return RCOK;
+}
+
+rc_t ss_m::truncate_index(StoreID stid)
+{
+    w_keystr_t infimum, supremum;
+    infimum.construct_neginfkey();
+    supremum.construct_posinfkey();
+    W_DO(remove_range(stid, infimum, supremum));
+    return RCOK;
+}
+
 rc_t ss_m::find_assoc(StoreID stid, const w_keystr_t& key,
                  void* el, smsize_t& elen, bool& found)
 {
+    W_DO(route_key(stid, key));
     PageID root_pid;
     bool for_update = g_xct_does_ex_lock_for_select();
     W_DO(open_store (stid, root_pid, for_update));
-    W_DO( bt->lookup(stid, key, el, elen, found) );
+
+    if (!in_snapshot_xct()) {
+        W_DO( bt->lookup(stid, key, el, elen, found) );
+        return RCOK;
+    }
+
+    // The current state must be read before checking versions: a version is
+    // always saved before the record is modified
+    smsize_t capacity = elen;
+    rc_t rc = bt->lookup(stid, key, el, elen, found);
+    if (rc.is_error() && rc.err_num() != eRECWONTFIT) {
+        return rc;
+    }
+
+    bool exists;
+    std::string old_el;
+    if (versions->lookup(stid, key, xct()->get_snapshot(), exists, old_el)) {
+        INC_TSTAT(snapshot_versions_applied);
+        found = exists;
+        elen = exists ? old_el.size() : 0;
+        if (elen > capacity) {
+            return RC(eRECWONTFIT);
+        }
+        memcpy(el, old_el.data(), elen);
+        return RCOK;
+    }
+    return rc;
+}
+
+rc_t ss_m::put_large_assoc(StoreID stid, const w_keystr_t& key,
+        overflow_writer_t& writer)
+{
+    W_DO(route_key(stid, key));
+    PageID root_pid;
+    W_DO( open_store (stid, root_pid, true));
+    if (in_snapshot_xct()) {
+        return RC(eSNAPSHOTUPDATE);
+    }
+    W_DO( bt->put_large(stid, key, writer) );
+    return RCOK;
+}
+
+rc_t ss_m::find_large_assoc(StoreID stid, const w_keystr_t& key,
+        overflow_reader_t& reader, bool& found)
+{
+    W_DO(route_key(stid, key));
+    PageID root_pid;
+    bool for_update = g_xct_does_ex_lock_for_select();
+    W_DO(open_store (stid, root_pid, for_update));
+    W_DO( bt->lookup_large(stid, key, reader, found) );
+    return RCOK;
+}
+
+rc_t ss_m::destroy_large_assoc(StoreID stid, const w_keystr_t& key)
+{
+    W_DO(route_key(stid, key));
+    PageID root_pid;
+    W_DO(open_store (stid, root_pid, true));
+    if (in_snapshot_xct()) {
+        return RC(eSNAPSHOTUPDATE);
+    }
+    W_DO( bt->remove_large(stid, key) );
     return RCOK;
 }
 
 rc_t ss_m::verify_index(StoreID stid, int hash_bits, bool &consistent)
 {
+    if (partition_table_t::is_partitioned(stid)) {
+        const partitioning_t* map;
+        W_DO(partitions->get(stid, map));
+        consistent = true;
+        for (size_t i = 0; i < map->stores.size() && consistent; ++i) {
+            W_DO(verify_index(map->stores[i], hash_bits, consistent));
+        }
+        return RCOK;
+    }
     PageID root_pid;
     W_DO( open_store (stid, root_pid));
     W_DO( bt->verify_tree(stid,  hash_bits, consistent) );
@@ -131,6 +364,9 @@ rc_t ss_m::open_store (StoreID stid, PageID &root_pid, bool for_update)
 }
 rc_t ss_m::open_store_nolock (StoreID stid, PageID &root_pid)
 {
+    if (partition_table_t::is_partitioned(stid)) {
+        return RC(eBADSTID); // only its partitions have a root
+    }
     PageID shpid = vol->get_store_root(stid);
     if (shpid == 0) {
         return RC(eBADSTID);
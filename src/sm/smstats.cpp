@@ -39,6 +39,8 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 // smstats_info_t is the collected stats from various
 // sm parts.  Each part is separately-generate from .dat files.
 #include "smstats.h"
+#include <algorithm>
+#include <chrono>
 #include "sm_stats_t_inc_gen.cpp"
 #include "sm_stats_t_dec_gen.cpp"
 #include "sm_stats_t_out_gen.cpp"
@@ -85,10 +87,108 @@ void sm_stats_t::compute()
     }
 }
 
+uint32_t latency_histogram_t::bucket_of(uint64_t nsec)
+{
+    if (nsec < SUB_BUCKETS) {
+        return nsec;
+    }
+    // position of the highest bit determines the power of two; the next
+    // SUB_BUCKET_BITS bits below it determine the sub-bucket
+    uint32_t shift = (63 - __builtin_clzll(nsec)) - SUB_BUCKET_BITS;
+    uint32_t bucket = (shift + 1) * SUB_BUCKETS
+        + (uint32_t) ((nsec >> shift) - SUB_BUCKETS);
+    return std::min(bucket, (uint32_t) BUCKETS - 1);
+}
+
+uint64_t latency_histogram_t::bucket_max(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32_t shift = bucket / SUB_BUCKETS - 1;
+    uint64_t top = bucket % SUB_BUCKETS + SUB_BUCKETS;
+    return ((top + 1) << shift) - 1;
+}
+
+uint64_t latency_histogram_t::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t latency_histogram_t::percentile(double q) const
+{
+    if (_count == 0) {
+        return 0;
+    }
+    // rank of the requested value, counting from 1
+    uint64_t rank = (uint64_t) (q * _count + 0.5);
+    if (rank == 0) { rank = 1; }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKETS; i++) {
+        seen += _counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_max(i), _max);
+        }
+    }
+    return _max;
+}
+
+latency_histogram_t& latency_histogram_t::operator+=(const latency_histogram_t& other)
+{
+    for (uint32_t i = 0; i < BUCKETS; i++) {
+        _counts[i] += other._counts[i];
+    }
+    _count += other._count;
+    _sum += other._sum;
+    _max = std::max(_max, other._max);
+    return *this;
+}
+
+latency_histogram_t& latency_histogram_t::operator-=(const latency_histogram_t& other)
+{
+    for (uint32_t i = 0; i < BUCKETS; i++) {
+        _counts[i] -= other._counts[i];
+    }
+    _count -= other._count;
+    _sum -= other._sum;
+    // the maximum cannot be subtracted; keep the one of the minuend
+    return *this;
+}
+
+const char* sm_latency_stats_t::names[kind_count] = {
+    "fix_hit",
+    "fix_miss",
+    "lock_acquire",
+    "log_flush_wait",
+    "xct_commit"
+};
+
+ostream& operator<<(ostream& o, const sm_latency_stats_t& s)
+{
+    o << "# latency_ns count mean p50 p90 p99 p999 max" << endl;
+    for (int i = 0; i < sm_latency_stats_t::kind_count; i++) {
+        const latency_histogram_t& h = s.hist[i];
+        o << sm_latency_stats_t::names[i]
+            << " " << h.count()
+            << " " << h.mean()
+            << " " << h.percentile(0.5)
+            << " " << h.percentile(0.9)
+            << " " << h.percentile(0.99)
+            << " " << h.percentile(0.999)
+            << " " << h.max()
+            << endl;
+    }
+    return o;
+}
+
 sm_stats_info_t &operator+=(sm_stats_info_t &s, const sm_stats_info_t &t)
 {
     s.bfht += t.bfht;
     s.sm += t.sm;
+    for (int i = 0; i < sm_latency_stats_t::kind_count; i++) {
+        s.lat.hist[i] += t.lat.hist[i];
+    }
     return s;
 }
 
@@ -96,6 +196,9 @@ sm_stats_info_t &operator-=(sm_stats_info_t &s, const sm_stats_info_t &t)
 {
     s.bfht -= t.bfht;
     s.sm -= t.sm;
+    for (int i = 0; i < sm_latency_stats_t::kind_count; i++) {
+        s.lat.hist[i] -= t.lat.hist[i];
+    }
     return s;
 }
 
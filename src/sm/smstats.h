@@ -146,6 +146,83 @@ public:
 #include "bf_htab_stats_t_struct_gen.h"
 };
 
+/**\brief Log-linear (HDR-style) latency histogram.
+ * \details
+ * Values are recorded in nanoseconds. Values below SUB_BUCKETS are counted
+ * exactly; above that, every power of two is split into SUB_BUCKETS buckets,
+ * so the relative error of any reported percentile is below
+ * 1/SUB_BUCKETS. Like all other counters in sm_stats_info_t, histograms
+ * are plain per-thread memory (no atomics) that is merged on demand.
+ */
+class latency_histogram_t {
+public:
+    enum {
+        SUB_BUCKET_BITS = 3,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        /// covers values up to 2^42 ns (more than an hour)
+        BUCKETS = 40 * SUB_BUCKETS
+    };
+
+    void record(uint64_t nsec) {
+        _counts[bucket_of(nsec)]++;
+        _count++;
+        _sum += nsec;
+        if (nsec > _max) { _max = nsec; }
+    }
+
+    uint64_t count() const { return _count; }
+    uint64_t max() const { return _max; }
+    uint64_t mean() const { return _count ? _sum / _count : 0; }
+
+    /**
+     * Returns the highest value equivalent to the q-quantile (0 < q <= 1),
+     * e.g., percentile(0.99) for p99. Returns 0 if nothing was recorded.
+     */
+    uint64_t percentile(double q) const;
+
+    latency_histogram_t& operator+=(const latency_histogram_t& other);
+    latency_histogram_t& operator-=(const latency_histogram_t& other);
+
+    static uint32_t bucket_of(uint64_t nsec);
+    /// highest value that falls into the given bucket
+    static uint64_t bucket_max(uint32_t bucket);
+
+    /// current time in nanoseconds, from a monotonic clock
+    static uint64_t now();
+
+private:
+    uint64_t _counts[BUCKETS];
+    uint64_t _count;
+    uint64_t _sum;
+    uint64_t _max;
+};
+
+/**\brief Latency histograms kept per thread along with the counters.
+ * \details
+ * Only recorded if the sm_latency_stats option is on (see
+ * LATENCY_START and RECORD_TLATENCY in smthread.h).
+ * The output operator prints one line per histogram, preceded by a
+ * header line starting with '#', in a whitespace-separated format meant for
+ * scripts. The ticker thread periodically writes it to the file given by
+ * sm_ticker_latency_file.
+ */
+class sm_latency_stats_t {
+public:
+    enum kind_t {
+        fix_hit = 0,      ///< bf_tree_m::fix() of a cached page
+        fix_miss,         ///< bf_tree_m::fix() reading the page from disk
+        lock_acquire,     ///< lock_core_m::acquire_lock(), including waits
+        log_flush_wait,   ///< blocking log_core::flush()
+        xct_commit,       ///< xct_t::commit()
+        kind_count
+    };
+    static const char* names[kind_count];
+
+    latency_histogram_t hist[kind_count];
+
+    friend ostream& operator<<(ostream&, const sm_latency_stats_t& s);
+};
+
 /**\brief Storage Manager Statistics 
  *
  * The storage manager is instrumented; it collects the statistics
@@ -159,6 +236,7 @@ class sm_stats_info_t {
 public:
     bf_htab_stats_t  bfht;
     sm_stats_t       sm;
+    sm_latency_stats_t lat;
     void    compute() { 
         bfht.compute(); 
         sm.compute(); 
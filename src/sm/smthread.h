@@ -503,6 +503,20 @@ public:
  */
 #define SET_TSTAT(x,y) me()->TL_stats().sm.x = (y)
 
+/**\def LATENCY_START()
+ *\brief Start time for RECORD_TLATENCY, or 0 if latencies are not recorded
+ */
+#define LATENCY_START() \
+    (smlevel_0::latency_stats_enabled ? latency_histogram_t::now() : 0)
+
+/**\def RECORD_TLATENCY(x,start)
+ *\brief Record the time since start (from LATENCY_START) in the per-thread
+ * latency histogram named x (see sm_latency_stats_t::kind_t)
+ */
+#define RECORD_TLATENCY(x,start) \
+    if (start) { me()->TL_stats().lat.hist[sm_latency_stats_t::x].record( \
+            latency_histogram_t::now() - (start)); }
+
 
     /**\cond skip */
     /*
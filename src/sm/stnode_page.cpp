@@ -25,6 +25,13 @@ stnode_cache_t::stnode_cache_t(bool create)
         memcpy(&_stnode_page, p.get_generic_page(), sizeof(stnode_page));
         prev_page_lsn = p.lsn();
         p.unfix(true /* evict */);
+
+        uint32_t page_size = _stnode_page.get_page_size();
+        if (page_size != 0 && page_size != stnode_page::page_sz) {
+            W_FATAL_MSG(eBADPAGESIZE, << "Volume was formatted with "
+                    << page_size << "-byte pages, but SM_PAGESIZE is "
+                    << stnode_page::page_sz);
+        }
     }
 }
 
@@ -140,6 +147,8 @@ rc_t stnode_cache_t::write_page(lsn_t rec_lsn)
 
     lsn_t emlsn = get_page_lsn();
     W_DO(smlevel_0::vol->read_page_verify(stnode_page::stpid, buf, emlsn));
+    // page image is rebuilt from the log, which does not carry the page size
+    ((stnode_page*) buf)->set_page_size(stnode_page::page_sz);
     W_DO(smlevel_0::vol->write_page(stnode_page::stpid, buf));
     sysevent::log_page_write(stnode_page::stpid, rec_lsn, 1);
 
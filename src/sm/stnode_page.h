@@ -68,11 +68,22 @@ public:
 
     extent_id_t get_last_extent() { return last_extent; }
 
+    /**
+     * Page size with which the volume was formatted, kept in the reserved
+     * header field. It is 0 in volumes written before it was recorded.
+     */
+    uint32_t get_page_size() const { return (uint32_t) reserved; }
+
+    void set_page_size(uint32_t size) { reserved = size; }
+
     lsn_t getBackupLSN() { return backupLSN; }
 
+    void setBackupLSN(lsn_t lsn) { backupLSN = lsn; }
+
     void format_empty() {
         memset(this, 0, sizeof(generic_page_header));
         pid = stnode_page::stpid;
+        set_page_size(page_sz);
 
         backupLSN = lsn_t(0,0);
         last_extent = 0;
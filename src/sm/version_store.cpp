@@ -0,0 +1,204 @@
+#include "w_defines.h"
+
+#define SM_SOURCE
+
+#include "version_store.h"
+
+#include "sm_base.h"
+#include "smthread.h"
+
+version_store_t::version_store_t()
+    : _clock(0), _version_count(0)
+{
+}
+
+version_store_t::~version_store_t()
+{
+}
+
+static std::string as_keystr(const w_keystr_t& key)
+{
+    return std::string((const char*) key.buffer_as_keystr(),
+            key.get_length_as_keystr());
+}
+
+uint64_t version_store_t::begin_snapshot()
+{
+    spinlock_write_critical_section cs(&_latch);
+    _snapshots.insert(_clock);
+    return _clock;
+}
+
+void version_store_t::end_snapshot(uint64_t snapshot)
+{
+    spinlock_write_critical_section cs(&_latch);
+    std::multiset<uint64_t>::iterator it = _snapshots.find(snapshot);
+    w_assert1(it != _snapshots.end());
+    _snapshots.erase(it);
+    _collect();
+}
+
+void version_store_t::save(StoreID store, const w_keystr_t& key,
+        const tid_t& writer, bool existed, const char* el, smsize_t elen)
+{
+    chain_key_t ckey(store, as_keystr(key));
+
+    spinlock_write_critical_section cs(&_latch);
+    std::vector<version_t>& chain = _chains[ckey];
+    if (!chain.empty() && chain.back().writer == writer
+            && chain.back().commit_ts == 0)
+    {
+        // before-image of this writer is already known
+        return;
+    }
+
+    version_t v;
+    v.writer = writer;
+    v.commit_ts = 0;
+    v.existed = existed;
+    if (existed) { v.el.assign(el, elen); }
+    chain.push_back(v);
+    _version_count++;
+
+    _writers[writer].push_back(ckey);
+    INC_TSTAT(snapshot_versions_saved);
+}
+
+bool version_store_t::has_versions(const tid_t& writer) const
+{
+    spinlock_read_critical_section cs(&_latch);
+    return _writers.count(writer) > 0;
+}
+
+void version_store_t::end_writer(const tid_t& writer, bool committed)
+{
+    spinlock_write_critical_section cs(&_latch);
+
+    std::map<tid_t, std::vector<chain_key_t> >::iterator w =
+        _writers.find(writer);
+    if (w == _writers.end()) { return; }
+
+    uint64_t ts = committed ? ++_clock : 0;
+    for (size_t i = 0; i < w->second.size(); i++) {
+        chain_map_t::iterator c = _chains.find(w->second[i]);
+        if (c == _chains.end()) { continue; }
+
+        std::vector<version_t>& chain = c->second;
+        for (size_t j = 0; j < chain.size(); ) {
+            version_t& v = chain[j];
+            if (v.writer != writer || v.commit_ts != 0) { j++; continue; }
+
+            if (committed) {
+                v.commit_ts = ts;
+                _committed.push_back(std::make_pair(ts, c->first));
+                j++;
+            }
+            else {
+                // rollback restored the before-image in the B-tree
+                chain.erase(chain.begin() + j);
+                _version_count--;
+            }
+        }
+        if (chain.empty()) { _chains.erase(c); }
+    }
+
+    _writers.erase(w);
+    _collect();
+}
+
+void version_store_t::_collect()
+{
+    uint64_t oldest = _snapshots.empty() ? _clock : *_snapshots.begin();
+
+    while (!_committed.empty() && _committed.front().first <= oldest) {
+        chain_map_t::iterator c = _chains.find(_committed.front().second);
+        _committed.pop_front();
+        if (c == _chains.end()) { continue; }
+
+        // Every snapshot stops at the newest version visible to all of them,
+        // so that version and all older ones are no longer needed
+        std::vector<version_t>& chain = c->second;
+        size_t keep = chain.size();
+        while (keep > 0) {
+            const version_t& v = chain[keep - 1];
+            if (v.commit_ts != 0 && v.commit_ts <= oldest) { break; }
+            keep--;
+        }
+        _version_count -= keep;
+        chain.erase(chain.begin(), chain.begin() + keep);
+        if (chain.empty()) { _chains.erase(c); }
+    }
+}
+
+bool version_store_t::_visible_state(const std::vector<version_t>& chain,
+        uint64_t snapshot, bool& exists, std::string& el)
+{
+    bool found = false;
+    for (size_t i = chain.size(); i > 0; i--) {
+        const version_t& v = chain[i - 1];
+        if (v.commit_ts != 0 && v.commit_ts <= snapshot) { break; }
+        found = true;
+        exists = v.existed;
+        el = v.el;
+    }
+    return found;
+}
+
+bool version_store_t::lookup(StoreID store, const w_keystr_t& key,
+        uint64_t snapshot, bool& exists, std::string& el) const
+{
+    chain_key_t ckey(store, as_keystr(key));
+
+    spinlock_read_critical_section cs(&_latch);
+    chain_map_t::const_iterator c = _chains.find(ckey);
+    if (c == _chains.end()) { return false; }
+    return _visible_state(c->second, snapshot, exists, el);
+}
+
+bool version_store_t::next(StoreID store, const w_keystr_t& from,
+        bool from_inclusive, const w_keystr_t& bound, bool bound_inclusive,
+        bool forward, uint64_t snapshot, w_keystr_t& key, bool& exists,
+        std::string& el) const
+{
+    chain_key_t cfrom(store, as_keystr(from));
+    std::string cbound = as_keystr(bound);
+
+    spinlock_read_critical_section cs(&_latch);
+    if (forward) {
+        chain_map_t::const_iterator c = _chains.lower_bound(cfrom);
+        for (; c != _chains.end() && c->first.first == store; ++c) {
+            if (!from_inclusive && c->first == cfrom) { continue; }
+            int cmp = c->first.second.compare(cbound);
+            if (cmp > 0 || (cmp == 0 && !bound_inclusive)) { break; }
+
+            if (_visible_state(c->second, snapshot, exists, el)) {
+                key.construct_from_keystr(c->first.second.data(),
+                        c->first.second.size());
+                return true;
+            }
+        }
+    }
+    else {
+        chain_map_t::const_iterator c = _chains.upper_bound(cfrom);
+        while (c != _chains.begin()) {
+            --c;
+            if (c->first.first != store) { break; }
+            if (!from_inclusive && c->first == cfrom) { continue; }
+            int cmp = c->first.second.compare(cbound);
+            if (cmp < 0 || (cmp == 0 && !bound_inclusive)) { break; }
+
+            if (_visible_state(c->second, snapshot, exists, el)) {
+                key.construct_from_keystr(c->first.second.data(),
+                        c->first.second.size());
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t version_store_t::get_version_count() const
+{
+    spinlock_read_critical_section cs(&_latch);
+    return _version_count;
+}
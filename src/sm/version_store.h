@@ -0,0 +1,127 @@
+#ifndef VERSION_STORE_H
+#define VERSION_STORE_H
+
+#include "w_defines.h"
+
+#include "sm_base.h"
+#include "w_key.h"
+#include "tid_t.h"
+#include "srwlock.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Before-images of B-tree records for snapshot reads.
+ *
+ * \details
+ * Snapshot transactions (see ss_m::begin_snapshot_xct) read the committed
+ * state of the database as of the moment they started, without acquiring
+ * any locks. They read the current B-tree like any other transaction and
+ * then correct what they read with the versions kept here.
+ *
+ * Whenever a regular transaction modifies a record through the ss_m
+ * interface, the state of the key before the modification (absent, or
+ * present with a value) is recorded as a version tagged with the writer's
+ * tid, before the B-tree is changed. Versions of the same key form a chain
+ * ordered by the time of the change, which key locks make consistent with
+ * the order of commits. When the writer commits, its versions are stamped
+ * with a commit timestamp taken from a logical clock; when it aborts, they
+ * are discarded after rollback, since the B-tree is then back to their
+ * before-images.
+ *
+ * A snapshot is the value of the clock when the snapshot transaction began.
+ * A version is invisible to a snapshot if its writer had not committed by
+ * then, i.e., it is unstamped or stamped later. The state of a key visible to
+ * a snapshot is the before-image of the oldest invisible version in its
+ * chain, or the current B-tree state if there is none.
+ *
+ * Committed versions are needed only while a snapshot older than their
+ * commit timestamp is active, and are garbage-collected as snapshots and
+ * writers end. Versions are kept in memory only; they are not needed after
+ * restart, when no snapshot is active.
+ *
+ * Large values (see btree_overflow.h) are not versioned, and are always read
+ * in their current state.
+ */
+class version_store_t {
+public:
+    version_store_t();
+    ~version_store_t();
+
+    /// Begins a snapshot and returns its timestamp
+    uint64_t begin_snapshot();
+
+    void end_snapshot(uint64_t snapshot);
+
+    /**
+     * Records the state of a key before it is modified by writer. Only the
+     * first modification of each key by a writer needs a version.
+     */
+    void save(StoreID store, const w_keystr_t& key, const tid_t& writer,
+            bool existed, const char* el, smsize_t elen);
+
+    /// Whether writer has saved any version
+    bool has_versions(const tid_t& writer) const;
+
+    /// Stamps (on commit) or discards (on abort) the versions of writer
+    void end_writer(const tid_t& writer, bool committed);
+
+    /**
+     * If the state of the key visible to the snapshot differs from its
+     * current state, returns true and the visible state in exists and el.
+     */
+    bool lookup(StoreID store, const w_keystr_t& key, uint64_t snapshot,
+            bool& exists, std::string& el) const;
+
+    /**
+     * Finds the first key after from (or at from, if from_inclusive) in the
+     * direction of the scan, and not beyond bound, whose visible state differs
+     * from its current state. Returns false if there is none.
+     */
+    bool next(StoreID store, const w_keystr_t& from, bool from_inclusive,
+            const w_keystr_t& bound, bool bound_inclusive, bool forward,
+            uint64_t snapshot, w_keystr_t& key, bool& exists,
+            std::string& el) const;
+
+    size_t get_version_count() const;
+
+private:
+    struct version_t {
+        tid_t       writer;
+        /// Commit timestamp of the writer, 0 while it is active
+        uint64_t    commit_ts;
+        /// State of the key before the writer modified it
+        bool        existed;
+        std::string el;
+    };
+
+    /// Store and key (as keystr, which sorts like w_keystr_t)
+    typedef std::pair<StoreID, std::string> chain_key_t;
+    /// Chains of versions, oldest first
+    typedef std::map<chain_key_t, std::vector<version_t> > chain_map_t;
+
+    chain_map_t _chains;
+    /// Keys modified by each active writer which saved versions
+    std::map<tid_t, std::vector<chain_key_t> > _writers;
+    /// Keys of committed versions, in commit order, for garbage collection
+    std::deque<std::pair<uint64_t, chain_key_t> > _committed;
+    /// Active snapshots
+    std::multiset<uint64_t> _snapshots;
+    /// Logical clock of commits
+    uint64_t _clock;
+    size_t _version_count;
+
+    mutable srwlock_t _latch;
+
+    static bool _visible_state(const std::vector<version_t>& chain,
+            uint64_t snapshot, bool& exists, std::string& el);
+
+    /// Removes committed versions not needed by any active snapshot
+    void _collect();
+};
+
+#endif
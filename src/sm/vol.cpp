@@ -20,9 +20,11 @@
 
 #include "alloc_cache.h"
 #include "restore.h"
+#include "backup_delta.h"
 #include "logarchiver.h"
 #include "eventlog.h"
 #include "restart.h"
+#include "w_lz.h"
 
 #include "sm.h"
 
@@ -37,13 +39,15 @@ vol_t::vol_t(const sm_options& options, chkpt_t* chkpt_info)
                _failed(false),
                _restore_mgr(NULL), _dirty_pages(NULL), _backup_fd(-1),
                _current_backup_lsn(lsn_t::null), _backup_write_fd(-1),
-               _log_page_reads(false)
+               _backup_delta_writer(NULL), _log_page_reads(false)
 {
     string dbfile = options.get_string_option("sm_dbfile", "db");
     bool truncate = options.get_bool_option("sm_format", false);
     _readonly = options.get_bool_option("sm_vol_readonly", false);
     _log_page_reads = options.get_bool_option("sm_vol_log_reads", false);
     _use_o_direct = options.get_bool_option("sm_vol_o_direct", false);
+    _alloc_slab_size = options.get_int_option("sm_alloc_slab_size", 8);
+    _compress_pages = options.get_bool_option("sm_vol_compress", false);
 
     spinlock_write_critical_section cs(&_mutex);
 
@@ -91,7 +95,8 @@ void vol_t::build_caches(bool truncate)
     w_assert1(_stnode_cache);
     _stnode_cache->dump(cerr);
 
-    _alloc_cache = new alloc_cache_t(*_stnode_cache, truncate);
+    _alloc_cache = new alloc_cache_t(*_stnode_cache, truncate,
+            _alloc_slab_size);
     w_assert1(_alloc_cache);
 }
 
@@ -119,7 +124,15 @@ void vol_t::delete_dirty_page(PageID pid)
 rc_t vol_t::open_backup()
 {
     // mutex held by caller -- no concurrent backup being added
-    string backupFile = _backups.back();
+
+    // Incremental backups are applied on top of the last full backup
+    size_t base = _backups.size() - 1;
+    while (base > 0 && _backup_is_delta[base]) { base--; }
+    if (_backup_is_delta[base]) {
+        return RC(eNO_BACKUP_FILE);
+    }
+
+    string backupFile = _backups[base];
     // Using direct I/O
     int open_flags = smthread_t::OPEN_RDONLY | smthread_t::OPEN_SYNC;
     if (_use_o_direct) {
@@ -127,11 +140,45 @@ rc_t vol_t::open_backup()
     }
     W_DO(me()->open(backupFile.c_str(), open_flags, 0666, _backup_fd));
     w_assert0(_backup_fd > 0);
+
+    for (size_t i = base + 1; i < _backups.size(); i++) {
+        DeltaBackupFile* delta = new DeltaBackupFile(_backups[i]);
+        _backup_deltas.push_back(delta);
+        rc_t rc = delta->open(_use_o_direct);
+        if (!rc.is_error()
+                && delta->getHeader().baseLSN != _backup_lsns[i - 1])
+        {
+            // delta was not taken from the preceding backup
+            rc = RC(eBAD_BACKUPPAGE);
+        }
+        if (rc.is_error()) {
+            W_COERCE(close_backup());
+            return rc;
+        }
+    }
+
     _current_backup_lsn = _backup_lsns.back();
 
     return RCOK;
 }
 
+rc_t vol_t::close_backup()
+{
+    // mutex held by caller
+    for (size_t i = 0; i < _backup_deltas.size(); i++) {
+        delete _backup_deltas[i];
+    }
+    _backup_deltas.clear();
+
+    if (_backup_fd > 0) {
+        W_DO(me()->close(_backup_fd));
+        _backup_fd = -1;
+    }
+    _current_backup_lsn = lsn_t::null;
+
+    return RCOK;
+}
+
 lsn_t vol_t::get_backup_lsn()
 {
     spinlock_read_critical_section cs(&_mutex);
@@ -250,12 +297,8 @@ bool vol_t::check_restore_finished()
             delete _restore_mgr;
             _restore_mgr = NULL;
 
-            // close backup file
-            if (_backup_fd > 0) {
-                W_COERCE(me()->close(_backup_fd));
-                _backup_fd = -1;
-                _current_backup_lsn = lsn_t::null;
-            }
+            // close backup files
+            W_COERCE(close_backup());
 
             set_failed(false);
             return true;
@@ -286,11 +329,7 @@ rc_t vol_t::dismount(bool abrupt)
             // wait for ongoing restore to complete
             _restore_mgr->setSinglePass();
             _restore_mgr->join();
-            if (_backup_fd > 0) {
-                W_COERCE(me()->close(_backup_fd));
-                _backup_fd = -1;
-                _current_backup_lsn = lsn_t::null;
-            }
+            W_COERCE(close_backup());
             set_failed(false);
         }
         // CS TODO -- also make sure no restart is ongoing
@@ -324,7 +363,8 @@ void vol_t::list_backups(
 rc_t vol_t::sx_add_backup(string path, bool redo)
 {
     // Make sure backup volume header matches this volume
-    stnode_page stpage;
+    lsn_t backupLSN = lsn_t::null;
+    bool isDelta = false;
     {
         int fd = -1;
         int open_flags = smthread_t::OPEN_RDWR | smthread_t::OPEN_SYNC;
@@ -333,7 +373,20 @@ rc_t vol_t::sx_add_backup(string path, bool redo)
             W_IGNORE(me()->close(fd));
             return RC_AUGMENT(rc);
         }
-        rc = me()->read(fd, &stpage, sizeof(generic_page));
+
+        // Incremental backups start with their own header; full backups
+        // keep the backup LSN in the stnode page
+        backup_delta_header_t header;
+        rc = DeltaBackupFile::readHeader(fd, header, isDelta);
+        if (!rc.is_error() && isDelta) {
+            backupLSN = header.backupLSN;
+        }
+        else if (!rc.is_error()) {
+            stnode_page stpage;
+            rc = me()->pread(fd, &stpage, sizeof(generic_page),
+                    stnode_page::stpid * sizeof(generic_page));
+            backupLSN = stpage.getBackupLSN();
+        }
         if (rc.is_error())  {
             W_IGNORE(me()->close(fd));
             return RC_AUGMENT(rc);
@@ -342,8 +395,6 @@ rc_t vol_t::sx_add_backup(string path, bool redo)
         W_DO(me()->close(fd));
     }
 
-    lsn_t backupLSN = stpage.getBackupLSN();
-
     // will change vol_t state -- start critical section
     // Multiple adds of the same backup file are weird, but not an error.
     // The mutex is just ot protect against mounts and checkpoints
@@ -351,6 +402,7 @@ rc_t vol_t::sx_add_backup(string path, bool redo)
 
     _backups.push_back(path);
     _backup_lsns.push_back(backupLSN);
+    _backup_is_delta.push_back(isDelta);
     w_assert1(_backups.size() == _backup_lsns.size());
 
     if (!redo) {
@@ -499,6 +551,84 @@ rc_t vol_t::read_page_verify(PageID pnum, generic_page* const buf, lsn_t emlsn)
     return RCOK;
 }
 
+/*
+ * Header of a compressed page slot on the volume. The first two fields
+ * overlap the checksum and the page ID of generic_page_header; since no page
+ * has the marker as its ID, compressed slots cannot be mistaken for pages.
+ * The compressed image follows the header, and the rest of the slot, rounded
+ * up to a file system block, is a hole in the file.
+ */
+struct compressed_slot_t {
+    static const uint32_t MAGIC = 0x5a504147; // "ZPAG"
+    static const PageID MARKER = 0xFFFFFFFF;
+    /// Granularity of hole punching
+    static const size_t BLOCK_SIZE = 4096;
+
+    uint32_t magic;
+    PageID   marker;
+    /// Size of the compressed image
+    uint32_t length;
+    uint32_t fill;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+
+    bool is_valid() const { return magic == MAGIC && marker == MARKER; }
+};
+
+/*
+ * Compresses a page into slot, which must have room for a whole page.
+ * Returns the number of bytes of slot to be written, which is a multiple of
+ * the block size, or 0 if compression would not free any block.
+ */
+static size_t compress_page(const generic_page* page, char* slot)
+{
+    const size_t page_size = sizeof(generic_page);
+    const size_t block = compressed_slot_t::BLOCK_SIZE;
+    if (page_size <= block) { return 0; }
+
+    compressed_slot_t* hdr = reinterpret_cast<compressed_slot_t*>(slot);
+    size_t capacity = page_size - block - sizeof(compressed_slot_t);
+    size_t length = w_lz::compress(reinterpret_cast<const char*>(page),
+            page_size, hdr->data(), capacity);
+    if (length == 0) { return 0; }
+
+    hdr->magic = compressed_slot_t::MAGIC;
+    hdr->marker = compressed_slot_t::MARKER;
+    hdr->length = length;
+    hdr->fill = 0;
+
+    size_t used = sizeof(compressed_slot_t) + length;
+    size_t size = (used + block - 1) / block * block;
+    memset(slot + used, 0, size - used);
+    return size;
+}
+
+/*
+ * Replaces a compressed slot read from the volume with the page image.
+ * Scratch space is allocated on the first call which needs it. A slot which
+ * fails to decompress is left as is; it then fails checksum verification
+ * like any other corrupted page.
+ */
+static void decompress_page(generic_page* page, char*& scratch)
+{
+    compressed_slot_t* hdr = reinterpret_cast<compressed_slot_t*>(page);
+    if (!hdr->is_valid()) { return; }
+
+    const size_t page_size = sizeof(generic_page);
+    if (hdr->length > page_size - sizeof(compressed_slot_t)) { return; }
+
+    if (!scratch) { scratch = new char[page_size]; }
+    size_t length = w_lz::decompress(hdr->data(), hdr->length, scratch,
+            page_size);
+    if (length != page_size) {
+        DBG(<< "Malformed compressed page slot");
+        return;
+    }
+
+    memcpy(page, scratch, page_size);
+    INC_TSTAT(vol_pages_decompressed);
+}
+
 /*********************************************************************
  *
  *  vol_t::read_many_pages(first_page, buf, cnt)
@@ -595,6 +725,12 @@ rc_t vol_t::read_many_pages(PageID first_page, generic_page* const buf, int cnt,
     W_DO(me()->pread_short(_unix_fd, (char *) buf, cnt * sizeof(generic_page),
                 offset, read_count));
 
+    char* scratch = NULL;
+    for (int i = 0; i < cnt; i++) {
+        decompress_page(&buf[i], scratch);
+    }
+    delete[] scratch;
+
     if (_log_page_reads) {
         sysevent::log_page_read(first_page, cnt);
     }
@@ -621,6 +757,11 @@ rc_t vol_t::read_backup(PageID first, size_t count, void* buf)
     W_DO(me()->pread_short(_backup_fd, (char *) buf, count * sizeof(generic_page),
                 offset, read_count));
 
+    // Apply incremental backups on top, oldest first
+    for (size_t i = 0; i < _backup_deltas.size(); i++) {
+        W_DO(_backup_deltas[i]->overlay(first, count, (char*) buf));
+    }
+
     // Short I/O is still possible because backup is only taken until last used
     // page, i.e., the file may be smaller than the total quota.
     if (read_count < (int) count) {
@@ -639,10 +780,11 @@ rc_t vol_t::read_backup(PageID first, size_t count, void* buf)
     return RCOK;
 }
 
-rc_t vol_t::take_backup(string path, bool flushArchive)
+rc_t vol_t::take_backup(string path, bool flushArchive, bool incremental)
 {
     // Open old backup file, if available
     bool useBackup = false;
+    bool openedBackup = false;
     {
         spinlock_write_critical_section cs(&_mutex);
 
@@ -651,7 +793,7 @@ rc_t vol_t::take_backup(string path, bool flushArchive)
         }
 
         _backup_write_path = path;
-        int flags = smthread_t::OPEN_SYNC | smthread_t::OPEN_WRONLY
+        int flags = smthread_t::OPEN_SYNC | smthread_t::OPEN_RDWR
             | smthread_t::OPEN_TRUNC | smthread_t::OPEN_CREATE;
         W_DO(me()->open(path.c_str(), flags, 0666, _backup_write_fd));
 
@@ -660,7 +802,15 @@ rc_t vol_t::take_backup(string path, bool flushArchive)
         if (useBackup && _backup_fd < 0) {
             // no ongoing restore -- we must open old backup ourselves
             W_DO(open_backup());
+            openedBackup = true;
         }
+
+        // Without a previous backup, the only option is a full one
+        if (incremental && useBackup) {
+            _backup_delta_writer = new DeltaBackupWriter(_backup_write_fd,
+                    _backup_lsns.back());
+        }
+        incremental = _backup_delta_writer != NULL;
     }
 
     // No need to hold latch here -- mutual exclusion is guaranteed because
@@ -697,24 +847,50 @@ rc_t vol_t::take_backup(string path, bool flushArchive)
             this, useBackup, true /* takeBackup */);
     restore.setSinglePass(true);
     restore.setInstant(false);
+    restore.setIncremental(incremental);
     restore.fork();
     restore.join();
     // TODO -- do we have to catch errors from restore thread?
 
-    // Write volume header and metadata to new backup
-    // (must be done after restore so that alloc pages are correct)
-    // CS TODO
-    // volhdr_t vhdr(_vid, _num_pages, backupLSN);
-    // W_DO(vhdr.write(_backup_write_fd));
+    // Record the backup LSN in the new backup
+    // (must be done after restore so that the stnode page is written)
+    rc_t rc;
+    if (incremental) {
+        DBG1(<< "Incremental backup contains "
+                << _backup_delta_writer->getExtentCount() << " segments");
+        rc = _backup_delta_writer->finish(backupLSN);
+    }
+    else {
+        stnode_page stpage;
+        size_t offset = stnode_page::stpid * sizeof(generic_page);
+        rc = me()->pread(_backup_write_fd, &stpage, sizeof(generic_page),
+                offset);
+        if (!rc.is_error()) {
+            stpage.setBackupLSN(backupLSN);
+            stpage.checksum = stpage.calculate_checksum();
+            rc = me()->pwrite(_backup_write_fd, &stpage,
+                    sizeof(generic_page), offset);
+        }
+    }
 
-    // At this point, new backup is fully written
-    // add_backup(path, backupLSN);
     {
         // critical section to guarantee visibility of the fd update
         spinlock_write_critical_section cs(&_mutex);
+        delete _backup_delta_writer;
+        _backup_delta_writer = NULL;
         W_DO(me()->close(_backup_write_fd));
         _backup_write_fd = -1;
+
+        // The backup chain changes below, so the next restore or backup
+        // must open it again
+        if (openedBackup && !is_failed()) {
+            W_DO(close_backup());
+        }
     }
+    W_DO(rc);
+
+    // At this point, new backup is fully written
+    W_DO(sx_add_backup(path));
 
     DBG1(<< "Finished taking backup");
 
@@ -725,6 +901,12 @@ rc_t vol_t::write_backup(PageID first, size_t count, void* buf)
 {
     w_assert0(_backup_write_fd > 0);
     w_assert1(count > 0);
+
+    if (_backup_delta_writer) {
+        // incremental backup -- segments are appended
+        INC_TSTAT(backup_delta_segments);
+        return _backup_delta_writer->append(first, count, buf);
+    }
     size_t offset = size_t(first) * sizeof(generic_page);
 
     W_DO(me()->pwrite(_backup_write_fd, buf, sizeof(generic_page) * count,
@@ -806,7 +988,12 @@ rc_t vol_t::write_many_pages(PageID first_page, const generic_page* const buf, i
     if(_apply_fake_disk_latency) start = gethrtime();
 
     // do the actual write now
-    W_COERCE(t->pwrite(_unix_fd, buf, sizeof(generic_page)*cnt, offset));
+    if (_compress_pages) {
+        W_COERCE(write_compressed(first_page, buf, cnt));
+    }
+    else {
+        W_COERCE(t->pwrite(_unix_fd, buf, sizeof(generic_page)*cnt, offset));
+    }
 
     fake_disk_latency(start);
     ADD_TSTAT(vol_blks_written, cnt);
@@ -815,6 +1002,55 @@ rc_t vol_t::write_many_pages(PageID first_page, const generic_page* const buf, i
     return RCOK;
 }
 
+/*
+ * Pages which do not compress well enough are written in their original
+ * form, in runs of contiguous pages like in write_many_pages. Each compressed
+ * page is written with its own I/O, and the remainder of its slot is punched
+ * out of the file. File systems without hole punching still work, but no
+ * space is saved.
+ */
+rc_t vol_t::write_compressed(PageID first_page, const generic_page* buf,
+        int cnt)
+{
+    char* slot = NULL;
+    int res = posix_memalign((void**) &slot, LogArchiver::IO_ALIGN,
+            sizeof(generic_page));
+    w_assert0(res == 0);
+
+    rc_t rc;
+    int run_start = 0;
+    for (int i = 0; i <= cnt; i++) {
+        size_t size = i < cnt ? compress_page(&buf[i], slot) : 0;
+        if (i < cnt && size == 0) { continue; }
+
+        // write uncompressed pages before this one
+        if (i > run_start) {
+            size_t offset = size_t(first_page + run_start)
+                * sizeof(generic_page);
+            rc = me()->pwrite(_unix_fd, &buf[run_start],
+                    sizeof(generic_page) * (i - run_start), offset);
+            if (rc.is_error()) { break; }
+        }
+        run_start = i + 1;
+        if (i == cnt) { break; }
+
+        size_t offset = size_t(first_page + i) * sizeof(generic_page);
+        rc = me()->pwrite(_unix_fd, slot, size, offset);
+        if (rc.is_error()) { break; }
+
+        rc = me()->punch_hole(_unix_fd, offset + size,
+                sizeof(generic_page) - size);
+        if (rc.is_error() && rc.err_num() != fcNOTIMPLEMENTED) { break; }
+        rc = RCOK;
+
+        INC_TSTAT(vol_pages_compressed);
+        ADD_TSTAT(vol_compress_bytes_saved, sizeof(generic_page) - size);
+    }
+
+    free(slot);
+    return rc;
+}
+
 uint32_t vol_t::get_last_allocated_pid() const
 {
     w_assert1(_alloc_cache);
@@ -15,6 +15,8 @@
 class alloc_cache_t;
 class stnode_cache_t;
 class RestoreMgr;
+class DeltaBackupWriter;
+class DeltaBackupFile;
 class sm_options;
 class chkpt_restore_tab_t;
 
@@ -40,6 +42,12 @@ public:
      * methods. Mounting/dismounting during reads and writes causes the file
      * descriptor to change, resulting in the expected errors in the return
      * code.
+     *
+     * If option sm_vol_compress is set, each page is compressed and, if that
+     * frees at least one file system block, written as a compressed slot
+     * followed by a hole punched into the file. Compressed slots are
+     * recognized and decompressed by read_many_pages regardless of the
+     * option, so it may be changed between runs.
      */
     rc_t                write_many_pages(
         PageID             first_page,
@@ -117,8 +125,16 @@ public:
         _readonly = r;
     }
 
-    /** Take a backup on the given file path. */
-    rc_t take_backup(string path, bool forceArchive = false);
+    /** Take a backup on the given file path.
+     *
+     * The backup is produced by merging the log archive into the most recent
+     * backup (if any), so the volume itself is not read. If incremental is
+     * true and a previous backup exists, only segments changed since then
+     * are written, into a delta file that restore applies on top of the
+     * previous backups. The new backup is registered with sx_add_backup().
+     */
+    rc_t take_backup(string path, bool forceArchive = false,
+            bool incremental = false);
 
     bool is_failed() const
     {
@@ -174,18 +190,23 @@ private:
     /** Paths to backup files, added with add_backup() */
     std::vector<string> _backups;
     std::vector<lsn_t> _backup_lsns;
+    /** Whether each backup is incremental, i.e., applies to the previous */
+    std::vector<bool> _backup_is_delta;
 
     /** Dirty pages that require REDO after restart **/
     // CS TODO: this should be destroyed once recovery is complete
     buf_tab_t* _dirty_pages;
 
-    /** Currently opened backup (during restore only) */
+    /** Currently opened backup (during restore only): the last full backup
+     * and the incremental backups taken after it, oldest first */
     int _backup_fd;
+    std::vector<DeltaBackupFile*> _backup_deltas;
     lsn_t _current_backup_lsn;
 
     /** Backup being currently taken */
     int _backup_write_fd;
     string _backup_write_path;
+    DeltaBackupWriter* _backup_delta_writer;
 
     /** Whether to generate page read log records */
     bool _log_page_reads;
@@ -197,11 +218,24 @@ private:
     /** Whether to open file with O_DIRECT */
     bool _use_o_direct;
 
+    /** Number of page IDs reserved at once by each thread in alloc_cache */
+    size_t _alloc_slab_size;
+
+    /** Whether pages are compressed when written (see write_compressed) */
+    bool _compress_pages;
+
+    /** Writes pages to the volume compressing each one if worthwhile */
+    rc_t write_compressed(PageID first_page, const generic_page* buf,
+            int cnt);
+
     rc_t dismount(bool abrupt = false);
 
     /** Open backup file descriptor for retore or taking new backup */
     rc_t open_backup();
 
+    /** Close the files opened by open_backup() */
+    rc_t close_backup();
+
     // setting failed status only allowed internally (private method)
     void set_failed(bool failed)
     {
@@ -271,6 +271,8 @@ xct_t::xct_t(sm_stats_info_t* stats, timeout_in_ms timeout, bool sys_xct,
     _ssx_chain_len(0),
     _query_concurrency (smlevel_0::t_cc_none),
     _query_exlock_for_select(false),
+    _snapshot_xct(false),
+    _snapshot(0),
     _piggy_backed_single_log_sys_xct(false),
     _sys_xct (sys_xct),
     _single_log_sys_xct (single_log_sys_xct),
@@ -659,7 +661,10 @@ xct_t::commit(bool lazy,lsn_t* plastlsn)
     // be going on right now.... see comments
     // in log_prepared and chkpt.cpp
 
-    return _commit(t_normal | (lazy ? t_lazy : t_normal), plastlsn);
+    uint64_t commit_start = LATENCY_START();
+    rc_t rc = _commit(t_normal | (lazy ? t_lazy : t_normal), plastlsn);
+    RECORD_TLATENCY(xct_commit, commit_start);
+    return rc;
 }
 
 rc_t
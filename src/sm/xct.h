@@ -550,6 +550,10 @@ private:
     concurrency_t                _query_concurrency;
     /** whether to take X lock for lookup/cursor. */
     bool                         _query_exlock_for_select;
+    /** whether this is a read-only snapshot transaction, see version_store_t. */
+    bool                         _snapshot_xct;
+    /** snapshot timestamp of a snapshot transaction. */
+    uint64_t                     _snapshot;
 // hey, these could be one integer with OR-ed flags
 
     /**
@@ -658,6 +662,9 @@ public:
     void                         set_query_concurrency(concurrency_t mode) { _query_concurrency = mode; }
     bool                         get_query_exlock_for_select() const {return _query_exlock_for_select;}
     void                         set_query_exlock_for_select(bool mode) {_query_exlock_for_select = mode;}
+    bool                         is_snapshot_xct() const { return _snapshot_xct; }
+    uint64_t                     get_snapshot() const { return _snapshot; }
+    void                         set_snapshot(uint64_t snapshot) { _snapshot_xct = true; _snapshot = snapshot; }
 
     bool                        is_loser_xct() const
         {
@@ -1180,6 +1187,7 @@ g_xct_does_need_lock()
     xct_t* x = g_xct();
     if (x == NULL)  return false;
     if (x->is_sys_xct()) return false; // system transaction never needs locks
+    if (x->is_snapshot_xct()) return false; // reads versions instead
     return x->get_query_concurrency() == smlevel_0::t_cc_keyrange;
 }
 
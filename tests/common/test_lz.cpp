@@ -0,0 +1,83 @@
+#include "w_lz.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Unit test for the w_lz codec.
+ */
+
+static void roundtrip(const std::vector<char>& in, size_t& compressed)
+{
+    std::vector<char> packed(in.size() + 64);
+    compressed = w_lz::compress(in.empty() ? NULL : &in[0], in.size(),
+            &packed[0], packed.size());
+    ASSERT_GT(compressed, 0U);
+
+    std::vector<char> out(in.size() + 1);
+    size_t len = w_lz::decompress(&packed[0], compressed, &out[0],
+            out.size());
+    ASSERT_EQ(in.size(), len);
+    EXPECT_EQ(0, memcmp(&in[0], &out[0], len));
+}
+
+TEST(LzTest, Zeros) {
+    std::vector<char> in(8192, 0);
+    size_t compressed;
+    roundtrip(in, compressed);
+    EXPECT_LT(compressed, 64U);
+}
+
+TEST(LzTest, TextLikeKeys) {
+    std::vector<char> in;
+    char key[64];
+    for (int i = 0; in.size() < 6000; i++) {
+        int n = snprintf(key, sizeof(key), "customer_%08d|order_status", i);
+        in.insert(in.end(), key, key + n);
+    }
+    // unused page space in the middle
+    in.resize(8192, 0);
+    size_t compressed;
+    roundtrip(in, compressed);
+    EXPECT_LT(compressed, in.size() / 2);
+}
+
+TEST(LzTest, Random) {
+    ::srand(123); // fixed seed for repeatability
+    for (size_t size = 1; size <= 8192; size *= 3) {
+        std::vector<char> in(size);
+        for (size_t i = 0; i < size; i++) {
+            // few distinct symbols, to get short random matches
+            in[i] = 'a' + rand() % ((i / 512) % 4 == 0 ? 4 : 26);
+        }
+        size_t compressed;
+        roundtrip(in, compressed);
+    }
+}
+
+TEST(LzTest, Incompressible) {
+    ::srand(321);
+    std::vector<char> in(4096);
+    for (size_t i = 0; i < in.size(); i++) { in[i] = rand(); }
+
+    // does not fit into a smaller output buffer
+    std::vector<char> packed(in.size());
+    EXPECT_EQ(0U, w_lz::compress(&in[0], in.size(), &packed[0],
+                in.size() / 2));
+}
+
+TEST(LzTest, Malformed) {
+    std::vector<char> in(1000, 'x');
+    std::vector<char> packed(100);
+    size_t compressed = w_lz::compress(&in[0], in.size(), &packed[0],
+            packed.size());
+    ASSERT_GT(compressed, 0U);
+
+    std::vector<char> out(in.size());
+    // truncated input
+    EXPECT_EQ(0U, w_lz::decompress(&packed[0], 3, &out[0], out.size()));
+    // output does not fit
+    EXPECT_EQ(0U, w_lz::decompress(&packed[0], compressed, &out[0], 10));
+}
@@ -0,0 +1,73 @@
+#include "w_defines.h"
+#include "w_mpsc_queue.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST (MPSCQueueTest, SingleThread) {
+    MPSCQueue<int> queue;
+    int value = -1;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_FALSE(queue.peek(value));
+
+    for (int i = 0; i < 100; i++) {
+        queue.push(i);
+    }
+    EXPECT_FALSE(queue.empty());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(queue.peek(value));
+        EXPECT_EQ(i, value);
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_TRUE(queue.empty());
+
+    // destructor frees the remaining nodes
+    queue.push(1);
+    queue.push(2);
+}
+
+TEST (MPSCQueueTest, MultipleProducers) {
+    const int producers = 4;
+    const int perProducer = 100000;
+    MPSCQueue<uint64_t> queue;
+    std::atomic<int> done(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, &done, p] {
+            for (int i = 0; i < perProducer; i++) {
+                queue.push(((uint64_t) p << 32) | i);
+            }
+            done++;
+        });
+    }
+
+    // elements of each producer must come out in the order pushed
+    std::vector<int> expected(producers, 0);
+    int consumed = 0;
+    while (consumed < producers * perProducer) {
+        uint64_t value;
+        if (queue.pop(value)) {
+            int p = value >> 32;
+            int i = value & 0xFFFFFFFF;
+            ASSERT_LT(p, producers);
+            EXPECT_EQ(expected[p], i);
+            expected[p] = i + 1;
+            consumed++;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& t : threads) { t.join(); }
+    EXPECT_EQ(producers, done.load());
+    EXPECT_TRUE(queue.empty());
+    for (int p = 0; p < producers; p++) {
+        EXPECT_EQ(perProducer, expected[p]);
+    }
+}
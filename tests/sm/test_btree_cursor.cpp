@@ -3,6 +3,9 @@
 #include "sm_vas.h"
 #include "btree.h"
 #include "btcursor.h"
+#include "btree_page_h.h"
+#include "btree_impl.h"
+#include "bf_tree.h"
 
 btree_test_env *test_env;
 
@@ -385,6 +388,61 @@ TEST (BtreeCursorTest, SpanPagesLock) {
     EXPECT_EQ(test_env->runBtreeTest(span_pages, true), 0);
 }
 
+w_rc_t optimistic_traverse(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+
+    char keystr[3] = "";
+    const size_t datsize = (SM_PAGESIZE / 6);
+    char datastr[datsize + 1];
+    keystr[2] = '\0';
+    datastr[datsize] = '\0';
+    ::memset (datastr, 'a', datsize);
+
+    W_DO(test_env->begin_xct());
+    for (int i = 10; i < 90; ++i) {
+        keystr[0] = '0' + (i / 10);
+        keystr[1] = '0' + (i % 10);
+        W_DO(test_env->btree_insert(stid, keystr, datastr));
+    }
+    W_DO(test_env->commit_xct());
+
+    if (!smlevel_0::bf->is_optimistic_reads_enabled()) {
+        return RCOK; // requires swizzling
+    }
+
+    // the first pass adopts foster children and swizzles all pointers
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 10; i < 90; ++i) {
+            keystr[0] = '0' + (i / 10);
+            keystr[1] = '0' + (i % 10);
+            w_keystr_t key;
+            key.construct_regularkey(keystr, 2);
+            btree_page_h leaf;
+            if (pass == 0) {
+                W_DO(btree_impl::_ux_traverse(stid, key,
+                            btree_impl::t_fence_contain, LATCH_SH, leaf));
+                continue;
+            }
+            bool success;
+            W_DO(btree_impl::_ux_traverse_optimistic(stid, key,
+                        btree_impl::t_fence_contain, LATCH_SH, leaf, success));
+            EXPECT_TRUE (success);
+            EXPECT_TRUE (leaf.is_fixed());
+            EXPECT_TRUE (leaf.is_leaf());
+            EXPECT_TRUE (leaf.fence_contains(key));
+            EXPECT_EQ (LATCH_SH, leaf.latch_mode());
+        }
+    }
+    return RCOK;
+}
+
+TEST (BtreeCursorTest, OptimisticTraverse) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(optimistic_traverse), 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     test_env = new btree_test_env();
@@ -0,0 +1,193 @@
+#define SM_SOURCE
+#define BTREE_C
+
+#include "sm_base.h"
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btree_page_h.h"
+#include "btree_impl.h"
+#include "bf_tree.h"
+#include "bf_tree_cleaner.h"
+#include "btree_maintainer.h"
+#include "w_key.h"
+#include "xct.h"
+
+#include "smthread.h"
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for the background B-tree maintenance (sm_btree_maintenance).
+ */
+
+/** Holds a latch on the root page to prevent adoption of new fosters. */
+class root_holding_thread_t : public smthread_t {
+public:
+    root_holding_thread_t(StoreID stid)
+        : smthread_t(t_regular, "root_holding_thread_t"),
+          page_held_flag(false), release_request_flag(false), _stid(stid) {}
+    ~root_holding_thread_t()  {_page.unfix();}
+    void run() {
+        W_COERCE(_page.fix_root(_stid, LATCH_SH));
+        page_held_flag = true;
+        while (!release_request_flag) {
+            ::usleep (5000);
+        }
+        _page.unfix();
+    }
+
+    bool volatile page_held_flag;
+    bool volatile release_request_flag;
+    StoreID _stid;
+    btree_page_h _page;
+};
+
+static w_rc_t insert_records(ss_m* ssm, StoreID stid, int from, int step)
+{
+    const int recsize = SM_PAGESIZE / 20;
+    char datastr[recsize];
+    memset (datastr, 'a', recsize);
+    vec_t data;
+    data.set(datastr, recsize);
+
+    W_DO(ssm->begin_xct());
+    test_env->set_xct_query_lock();
+    char keystr[16];
+    w_keystr_t key;
+    for (int i = from; i < 200; i += step) {
+        snprintf(keystr, sizeof(keystr), "key%03d", i);
+        key.construct_regularkey(keystr, strlen(keystr));
+        W_DO(ssm->create_assoc(stid, key, data));
+    }
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+static w_rc_t count_fosters(StoreID stid, int& fosters)
+{
+    btree_page_h root_p;
+    W_DO(root_p.fix_root(stid, LATCH_SH));
+    EXPECT_EQ (root_p.level(), 2);
+    fosters = 0;
+    for (slotid_t i = -1; i < root_p.nrecs(); ++i) {
+        btree_page_h child_p;
+        PageID ptr = i < 0 ? root_p.pid0_opaqueptr() : root_p.child_opaqueptr(i);
+        W_DO(child_p.fix_nonroot(root_p, ptr, LATCH_SH));
+        if (child_p.get_foster() != 0) {
+            fosters++;
+        }
+    }
+    return RCOK;
+}
+
+static void maintain()
+{
+    smlevel_0::bf->get_cleaner()->wakeup(true);
+    smlevel_0::maintainer->wakeup(true);
+}
+
+w_rc_t adopt_fosters(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(ssm, stid, 0, 2));
+
+    int fosters;
+    {
+        // splits below the latched root are left as fosters
+        root_holding_thread_t holder (stid);
+        W_DO(holder.fork());
+        while (!holder.page_held_flag) {
+            ::usleep (5000);
+        }
+        W_DO(insert_records(ssm, stid, 1, 6));
+        W_DO(count_fosters(stid, fosters));
+        EXPECT_GT (fosters, 0);
+
+        holder.release_request_flag = true;
+        W_DO(holder.join(1000));
+    }
+
+    maintain();
+    W_DO(count_fosters(stid, fosters));
+    EXPECT_EQ (fosters, 0);
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ (s.rownum, 134);
+    return RCOK;
+}
+
+TEST (BtreeMaintenanceTest, AdoptFosters) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_bufferpool_swizzle", default_enable_swizzling);
+    options.set_bool_option("sm_btree_maintenance", true);
+    options.set_int_option("sm_btree_maintenance_interval_millisec", 10);
+    EXPECT_EQ(test_env->runBtreeTest(adopt_fosters, options), 0);
+}
+
+w_rc_t merge_underfull(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(ssm, stid, 0, 2));
+    {
+        btree_page_h root_p;
+        W_DO(root_p.fix_root(stid, LATCH_SH));
+        EXPECT_EQ (root_p.level(), 2);
+        EXPECT_GE (root_p.nrecs(), 3);
+    }
+
+    // leave only key000, key040, ..., key160
+    W_DO(ssm->begin_xct());
+    test_env->set_xct_query_lock();
+    char keystr[16];
+    w_keystr_t key;
+    for (int i = 0; i < 200; i += 2) {
+        if (i % 40 != 0) {
+            snprintf(keystr, sizeof(keystr), "key%03d", i);
+            key.construct_regularkey(keystr, strlen(keystr));
+            W_DO(ssm->destroy_assoc(stid, key));
+        }
+    }
+    W_DO(ssm->commit_xct());
+
+    maintain();
+    {
+        btree_page_h root_p;
+        W_DO(root_p.fix_root(stid, LATCH_SH));
+        EXPECT_EQ (root_p.level(), 2);
+        EXPECT_EQ (root_p.nrecs(), 0);
+        btree_page_h leaf_p;
+        W_DO(leaf_p.fix_nonroot(root_p, root_p.pid0_opaqueptr(), LATCH_SH));
+        EXPECT_EQ (leaf_p.get_foster(), (uint) 0);
+    }
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ (s.rownum, 5);
+    EXPECT_EQ (s.minkey, std::string("key000"));
+    EXPECT_EQ (s.maxkey, std::string("key160"));
+    return RCOK;
+}
+
+TEST (BtreeMaintenanceTest, MergeUnderfull) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_bufferpool_swizzle", default_enable_swizzling);
+    options.set_bool_option("sm_btree_maintenance", true);
+    options.set_int_option("sm_btree_maintenance_interval_millisec", 10);
+    EXPECT_EQ(test_env->runBtreeTest(merge_underfull, options), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
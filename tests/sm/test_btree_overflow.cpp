@@ -0,0 +1,154 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btree_overflow.h"
+
+#include <vector>
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for large values stored in overflow pages.
+ */
+
+static char pattern_byte(size_t seed, size_t i)
+{
+    return 'a' + (seed + i * 7) % 26;
+}
+
+static w_rc_t put_large(StoreID stid, const char* keystr, size_t length,
+        size_t seed)
+{
+    w_keystr_t key;
+    key.construct_regularkey(keystr, strlen(keystr));
+
+    // stream in chunks which do not match the page size
+    overflow_writer_t writer(stid);
+    std::vector<char> chunk(1000);
+    size_t written = 0;
+    while (written < length) {
+        size_t count = std::min(chunk.size(), length - written);
+        for (size_t i = 0; i < count; i++) {
+            chunk[i] = pattern_byte(seed, written + i);
+        }
+        W_DO(writer.write(&chunk[0], count));
+        written += count;
+    }
+    W_DO(ss_m::put_large_assoc(stid, key, writer));
+    return RCOK;
+}
+
+static w_rc_t check_large(StoreID stid, const char* keystr, size_t length,
+        size_t seed)
+{
+    w_keystr_t key;
+    key.construct_regularkey(keystr, strlen(keystr));
+
+    overflow_reader_t reader;
+    bool found = false;
+    W_DO(ss_m::find_large_assoc(stid, key, reader, found));
+    EXPECT_TRUE(found);
+    EXPECT_EQ(length, reader.get_length());
+
+    std::vector<char> chunk(777);
+    size_t total = 0;
+    while (!reader.eof()) {
+        size_t done = 0;
+        W_DO(reader.read(&chunk[0], chunk.size(), done));
+        EXPECT_GT(done, 0U);
+        for (size_t i = 0; i < done; i++) {
+            EXPECT_EQ(pattern_byte(seed, total + i), chunk[i]);
+        }
+        total += done;
+    }
+    EXPECT_EQ(length, total);
+    return RCOK;
+}
+
+w_rc_t put_lookup_large(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+
+    const size_t big = 5 * SM_PAGESIZE + 123;
+
+    W_DO(test_env->begin_xct());
+    W_DO(test_env->btree_insert(stid, "a1", "data1"));
+    W_DO(put_large(stid, "b1", big, 1));
+    W_DO(put_large(stid, "b2", 10, 2));
+    W_DO(put_large(stid, "b3", 0, 3));
+    W_DO(test_env->commit_xct());
+
+    W_DO(test_env->begin_xct());
+    W_DO(check_large(stid, "b1", big, 1));
+    W_DO(check_large(stid, "b2", 10, 2));
+    W_DO(check_large(stid, "b3", 0, 3));
+
+    // regular records cannot be read as large values
+    w_keystr_t key;
+    key.construct_regularkey("a1", 2);
+    overflow_reader_t reader;
+    bool found = false;
+    w_rc_t rc = ss_m::find_large_assoc(stid, key, reader, found);
+    EXPECT_EQ(eNOTOVERFLOW, rc.err_num());
+    W_DO(test_env->commit_xct());
+
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ (4, s.rownum);
+    return RCOK;
+}
+
+TEST (BtreeOverflowTest, PutLookupLarge) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(put_lookup_large), 0);
+}
+
+w_rc_t replace_remove_large(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+
+    W_DO(test_env->begin_xct());
+    W_DO(put_large(stid, "key", 3 * SM_PAGESIZE, 1));
+    W_DO(test_env->commit_xct());
+
+    W_DO(test_env->begin_xct());
+    W_DO(put_large(stid, "key", 2 * SM_PAGESIZE + 1, 2));
+    W_DO(test_env->commit_xct());
+
+    W_DO(test_env->begin_xct());
+    W_DO(check_large(stid, "key", 2 * SM_PAGESIZE + 1, 2));
+    W_DO(test_env->commit_xct());
+
+    w_keystr_t key;
+    key.construct_regularkey("key", 3);
+    W_DO(test_env->begin_xct());
+    W_DO(ss_m::destroy_large_assoc(stid, key));
+    W_DO(test_env->commit_xct());
+
+    W_DO(test_env->begin_xct());
+    overflow_reader_t reader;
+    bool found = true;
+    W_DO(ss_m::find_large_assoc(stid, key, reader, found));
+    EXPECT_FALSE(found);
+    W_DO(test_env->commit_xct());
+
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ (0, s.rownum);
+    return RCOK;
+}
+
+TEST (BtreeOverflowTest, ReplaceRemoveLarge) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(replace_remove_large), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,204 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btcursor.h"
+#include "btree_partition.h"
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for partitioned indexes (ss_m::create_partitioned_index).
+ */
+
+static w_rc_t insert_records(ss_m* ssm, StoreID stid, int count)
+{
+    char keystr[16];
+    char datastr[16];
+    w_keystr_t key;
+    W_DO(ssm->begin_xct());
+    test_env->set_xct_query_lock();
+    for (int n = 0; n < count; ++n) {
+        // not in key order, to exercise routing
+        int i = (n * 7) % count;
+        snprintf(keystr, sizeof(keystr), "key%03d", i);
+        snprintf(datastr, sizeof(datastr), "data%03d", i);
+        key.construct_regularkey(keystr, strlen(keystr));
+        W_DO(ssm->create_assoc(stid, key, vec_t(datastr, strlen(datastr))));
+    }
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+/** Scans the cursor and checks that keys come in order with their data. */
+static w_rc_t scan(bt_cursor_t& cursor, int& rownum, std::string& first,
+        std::string& last)
+{
+    rownum = 0;
+    w_keystr_t prev;
+    while (true) {
+        W_DO(cursor.next());
+        if (cursor.eof()) {
+            break;
+        }
+        std::string key((const char*) cursor.key().serialize_as_nonkeystr().data(),
+                cursor.key().get_length_as_nonkeystr());
+        std::string data(cursor.elem(), cursor.elen());
+        EXPECT_EQ(std::string("data") + key.substr(3), data);
+        if (rownum > 0) {
+            EXPECT_EQ(cursor.is_forward(), prev < cursor.key());
+        }
+        if (rownum == 0) {
+            first = key;
+        }
+        last = key;
+        prev = cursor.key();
+        ++rownum;
+    }
+    return RCOK;
+}
+
+w_rc_t range_partitions(ss_m* ssm, test_volume_t *) {
+    std::vector<w_keystr_t> bounds(2);
+    bounds[0].construct_regularkey("key100", 6);
+    bounds[1].construct_regularkey("key050", 6);
+    StoreID stid;
+    W_DO(ssm->begin_xct());
+    EXPECT_EQ(eBADARGUMENT, ssm->create_partitioned_index(stid, bounds).err_num());
+    std::swap(bounds[0], bounds[1]);
+    W_DO(ssm->create_partitioned_index(stid, bounds));
+    W_DO(ssm->commit_xct());
+    EXPECT_TRUE(partition_table_t::is_partitioned(stid));
+
+    W_DO(insert_records(ssm, stid, 150));
+
+    // each partition holds its own key range in its own B-tree
+    const partitioning_t* map;
+    W_DO(smlevel_0::partitions->get(stid, map));
+    EXPECT_EQ(3U, map->stores.size());
+    const char* mins[] = {"key000", "key050", "key100"};
+    const char* maxs[] = {"key049", "key099", "key149"};
+    for (size_t i = 0; i < map->stores.size(); ++i) {
+        x_btree_scan_result s;
+        W_DO(test_env->btree_scan(map->stores[i], s));
+        EXPECT_EQ(50, s.rownum);
+        EXPECT_EQ(std::string(mins[i]), s.minkey);
+        EXPECT_EQ(std::string(maxs[i]), s.maxkey);
+    }
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(150, s.rownum);
+    EXPECT_EQ(std::string("key000"), s.minkey);
+    EXPECT_EQ(std::string("key149"), s.maxkey);
+
+    // a backward scan crossing two partition bounds
+    W_DO(ssm->begin_xct());
+    w_keystr_t lower, upper;
+    lower.construct_regularkey("key030", 6);
+    upper.construct_regularkey("key120", 6);
+    {
+        bt_cursor_t cursor(stid, lower, true, upper, false, false);
+        int rownum;
+        std::string first, last;
+        W_DO(scan(cursor, rownum, first, last));
+        EXPECT_EQ(90, rownum);
+        EXPECT_EQ(std::string("key119"), first);
+        EXPECT_EQ(std::string("key030"), last);
+    }
+
+    w_keystr_t key;
+    key.construct_regularkey("key075", 6);
+    char buf[16];
+    smsize_t elen = sizeof(buf);
+    bool found;
+    W_DO(ssm->find_assoc(stid, key, buf, elen, found));
+    EXPECT_TRUE(found);
+    EXPECT_EQ(std::string("data075"), std::string(buf, elen));
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+TEST (BtreePartitionTest, RangePartitions) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(range_partitions), 0);
+}
+
+w_rc_t hash_partitions(ss_m* ssm, test_volume_t *) {
+    StoreID stid;
+    W_DO(ssm->begin_xct());
+    W_DO(ssm->create_partitioned_index(stid, 4));
+    W_DO(ssm->commit_xct());
+
+    W_DO(insert_records(ssm, stid, 200));
+
+    W_DO(ssm->begin_xct());
+    test_env->set_xct_query_lock();
+    w_keystr_t key;
+    char keystr[16];
+    for (int i = 0; i < 200; i += 2) {
+        snprintf(keystr, sizeof(keystr), "key%03d", i);
+        key.construct_regularkey(keystr, strlen(keystr));
+        W_DO(ssm->destroy_assoc(stid, key));
+    }
+    W_DO(ssm->commit_xct());
+
+    const partitioning_t* map;
+    W_DO(smlevel_0::partitions->get(stid, map));
+    EXPECT_EQ(4U, map->stores.size());
+    int total = 0;
+    for (size_t i = 0; i < map->stores.size(); ++i) {
+        x_btree_scan_result s;
+        W_DO(test_env->btree_scan(map->stores[i], s));
+        EXPECT_GT(s.rownum, 0);
+        total += s.rownum;
+    }
+    EXPECT_EQ(100, total);
+
+    W_DO(x_btree_verify(ssm, stid));
+    W_DO(ssm->begin_xct());
+    {
+        bt_cursor_t cursor(stid, true);
+        int rownum;
+        std::string first, last;
+        W_DO(scan(cursor, rownum, first, last));
+        EXPECT_EQ(100, rownum);
+        EXPECT_EQ(std::string("key001"), first);
+        EXPECT_EQ(std::string("key199"), last);
+    }
+    {
+        bt_cursor_t cursor(stid, false);
+        int rownum;
+        std::string first, last;
+        W_DO(scan(cursor, rownum, first, last));
+        EXPECT_EQ(100, rownum);
+        EXPECT_EQ(std::string("key199"), first);
+        EXPECT_EQ(std::string("key001"), last);
+    }
+
+    key.construct_regularkey("key042", 6);
+    char buf[16];
+    smsize_t elen = sizeof(buf);
+    bool found;
+    W_DO(ssm->find_assoc(stid, key, buf, elen, found));
+    EXPECT_FALSE(found);
+    key.construct_regularkey("key043", 6);
+    elen = sizeof(buf);
+    W_DO(ssm->find_assoc(stid, key, buf, elen, found));
+    EXPECT_TRUE(found);
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+TEST (BtreePartitionTest, HashPartitions) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(hash_partitions), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
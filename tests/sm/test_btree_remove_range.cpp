@@ -0,0 +1,125 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btree_page_h.h"
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for bulk range removal (ss_m::remove_range, ss_m::truncate_index).
+ */
+
+static w_rc_t insert_records(ss_m* ssm, StoreID stid)
+{
+    const int recsize = SM_PAGESIZE / 20;
+    char datastr[recsize];
+    memset (datastr, 'a', recsize);
+    vec_t data;
+    data.set(datastr, recsize);
+
+    W_DO(ssm->begin_xct());
+    test_env->set_xct_query_lock();
+    char keystr[16];
+    w_keystr_t key;
+    for (int i = 0; i < 400; ++i) {
+        snprintf(keystr, sizeof(keystr), "key%03d", i);
+        key.construct_regularkey(keystr, strlen(keystr));
+        W_DO(ssm->create_assoc(stid, key, data));
+    }
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+static w_rc_t exists(ss_m* ssm, StoreID stid, const char* keystr, bool& found)
+{
+    w_keystr_t key;
+    key.construct_regularkey(keystr, strlen(keystr));
+    char buf[SM_PAGESIZE];
+    smsize_t elen = sizeof(buf);
+    W_DO(ssm->begin_xct());
+    W_DO(ssm->find_assoc(stid, key, buf, elen, found));
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+w_rc_t remove_range(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(ssm, stid));
+
+    uint64_t pages_before;
+    W_DO(ssm->touch_index(stid, pages_before));
+
+    w_keystr_t low, high;
+    low.construct_regularkey("key100", 6);
+    high.construct_regularkey("key300", 6);
+
+    // not allowed in a transaction, since it can't be undone
+    W_DO(ssm->begin_xct());
+    EXPECT_EQ(eINTRANS, ssm->remove_range(stid, low, high).err_num());
+    W_DO(ssm->commit_xct());
+
+    W_DO(ssm->remove_range(stid, low, high));
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(200, s.rownum);
+    EXPECT_EQ(std::string("key000"), s.minkey);
+    EXPECT_EQ(std::string("key399"), s.maxkey);
+
+    bool found;
+    W_DO(exists(ssm, stid, "key099", found));
+    EXPECT_TRUE(found);
+    W_DO(exists(ssm, stid, "key100", found));
+    EXPECT_FALSE(found);
+    W_DO(exists(ssm, stid, "key299", found));
+    EXPECT_FALSE(found);
+    W_DO(exists(ssm, stid, "key300", found));
+    EXPECT_TRUE(found);
+
+    // emptied leaves are no longer part of the tree
+    uint64_t pages_after;
+    W_DO(ssm->touch_index(stid, pages_after));
+    EXPECT_LT(pages_after, pages_before);
+    return RCOK;
+}
+
+TEST (BtreeRemoveRangeTest, RemoveRange) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(remove_range), 0);
+}
+
+w_rc_t truncate(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(ssm, stid));
+
+    W_DO(ssm->truncate_index(stid));
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(0, s.rownum);
+
+    // the index remains usable
+    W_DO(test_env->btree_insert_and_commit(stid, "key050", "data"));
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(1, s.rownum);
+    EXPECT_EQ(std::string("key050"), s.minkey);
+    return RCOK;
+}
+
+TEST (BtreeRemoveRangeTest, Truncate) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(truncate), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
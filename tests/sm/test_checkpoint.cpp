@@ -18,6 +18,7 @@ vector<lsn_t> undoNextMap;
 const char someString[12] = "Checkpoint!";
 cvec_t elem;
 w_keystr_t key;
+bool parallelScan = false;
 
 void init()
 {
@@ -85,6 +86,12 @@ lsn_t abortXct(unsigned tid)
     return lsn;
 }
 
+void scanLog(chkpt_t& chkpt)
+{
+    if (parallelScan) { chkpt.scan_log_parallel(4); }
+    else { chkpt.scan_log(); }
+}
+
 lsn_t generateCLR(unsigned tid, lsn_t lsn)
 {
     lsn_t ret;
@@ -99,7 +106,7 @@ lsn_t generateCLR(unsigned tid, lsn_t lsn)
 rc_t emptyChkpt(ss_m*, test_volume_t*)
 {
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(0, chkpt.buf_tab.size());
     EXPECT_EQ(0, chkpt.xct_tab.size());
@@ -116,7 +123,7 @@ rc_t oneUpdateDirtyUncommitted(ss_m*, test_volume_t*)
     lsn_t lsn = makeUpdate(1, 1, "key1");
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -134,7 +141,7 @@ rc_t twoUpdatesDirtyUncommitted(ss_m*, test_volume_t*)
     lsn_t lsn2 = makeUpdate(1, 1, "key2");
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -155,7 +162,7 @@ rc_t twoUpdatesDirtyCommitted(ss_m*, test_volume_t*)
     commitXct(1);
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(0, chkpt.xct_tab.size());
@@ -176,7 +183,7 @@ rc_t twoUpdatesDirtyAborting(ss_m*, test_volume_t*)
     lsn_t clr2 = generateCLR(1, lsn1);
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -200,7 +207,7 @@ rc_t twoUpdatesDirtyAborted(ss_m*, test_volume_t*)
     abortXct(1);
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(0, chkpt.xct_tab.size());
@@ -223,7 +230,7 @@ rc_t twoXcts(ss_m*, test_volume_t*)
     lsn_t clr1 = generateCLR(1, lsn1);
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(4, chkpt.buf_tab.size());
     EXPECT_EQ(2, chkpt.xct_tab.size());
@@ -250,7 +257,7 @@ rc_t twoXctsOneCommitted(ss_m*, test_volume_t*)
     commitXct(2);
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(4, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -275,7 +282,7 @@ rc_t onePageClean(ss_m*, test_volume_t*)
     flushLog();
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(1, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -302,7 +309,7 @@ rc_t twoPagesCleanTwoDirty(ss_m*, test_volume_t*)
     flushLog();
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(2, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -334,7 +341,7 @@ rc_t pagesDirtiedTwice(ss_m*, test_volume_t*)
     lsn_t lsn7 = makeUpdate(1, 1, "key2");
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     EXPECT_EQ(3, chkpt.buf_tab.size());
     EXPECT_EQ(1, chkpt.xct_tab.size());
@@ -376,7 +383,7 @@ rc_t cleanerLostUpdate(ss_m*, test_volume_t*)
     flushLog();
 
     chkpt_t chkpt;
-    chkpt.scan_log();
+    scanLog(chkpt);
 
     // Page 2 must be seen as dirty
     EXPECT_EQ(1, chkpt.buf_tab.size());
@@ -396,6 +403,16 @@ TEST (CheckpointTest, name) { \
     options.set_bool_option("sm_format", true); \
     options.set_bool_option("sm_shutdown_clean", false); \
     EXPECT_EQ(test_env->runBtreeTest(name, options), 0); \
+} \
+TEST (CheckpointTest, name##Parallel) { \
+    test_env->empty_logdata_dir(); \
+    init(); \
+    parallelScan = true; \
+    sm_options options; \
+    options.set_bool_option("sm_format", true); \
+    options.set_bool_option("sm_shutdown_clean", false); \
+    EXPECT_EQ(test_env->runBtreeTest(name, options), 0); \
+    parallelScan = false; \
 }
 
 DFT_TEST(emptyChkpt);
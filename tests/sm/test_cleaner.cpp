@@ -4,6 +4,7 @@
 #include "vol.h"
 #include "logarchiver.h"
 #include "page_cleaner_decoupled.h"
+#include "bf_tree.h"
 
 // use small block to test boundaries
 const size_t BLOCK_SIZE = 1024 * 1024;
@@ -41,26 +42,19 @@ rc_t cleaner(ss_m* ssm, test_volume_t* test_vol)
     W_DO(populateBtree(ssm, test_vol, howManyToInsert));
     ssm->activate_archiver();
 
-    //LogArchiver::LogConsumer cons(lsn_t(1,0), BLOCK_SIZE);
-    //LogArchiver::ArchiverHeap heap(BLOCK_SIZE);
-    //LogArchiver::ArchiveDirectory dir(test_env->archive_dir, BLOCK_SIZE, true);
-    //LogArchiver::BlockAssembly assemb(&dir);
+    // wait for logarchiver to consume up to durable LSN
+    W_DO(ssm->log->flush_all());
+    lsn_t durable = ssm->log->durable_lsn();
+    smlevel_0::logArchiver->requestFlushSync(durable);
+    lsn_t archived = smlevel_0::logArchiver->getDirectory()->getLastLSN();
+    EXPECT_TRUE(archived >= durable);
 
-    //LogArchiver la(&dir, &cons, &heap, &assemb);
-    //la.fork();
-    //la.activate(lsn_t::null, true /* wait */);
-
-    // wait for logarchiver to consume up to durable LSN,
-    //if (la.getDirectory()->getLastLSN() < ssm->log->durable_lsn()) {
-    //        la.requestFlushSync(ssm->log->durable_lsn());
-    //}
-
-    //page_cleaner_mgr cleaner(smlevel_0::bf, &dir);
-    //cleaner.start_cleaners();
-    //cleaner.force_all();
-    //sleep(1);
-    //cleaner.request_stop_cleaners();
-    //cleaner.join_cleaners();
+    // one round of the decoupled cleaner must propagate all archived
+    // updates and report the new clean LSN back to the buffer pool
+    page_cleaner_base* cleaner = smlevel_0::bf->get_cleaner();
+    EXPECT_TRUE(cleaner != NULL);
+    cleaner->wakeup(true);
+    EXPECT_EQ(archived, smlevel_0::bf->get_decoupled_clean_lsn());
 
     return RCOK;
 }
@@ -70,8 +64,7 @@ TEST (CleanerTest, cleaner) {
     options.set_bool_option("sm_testenv_init_vol", true);
     options.set_bool_option("sm_logging", true);
     options.set_bool_option("sm_archiving", true);
-    options.set_bool_option("sm_decoupled_cleaner", true);
-    options.set_bool_option("sm_decoupled_cleaner_mode", true);
+    options.set_bool_option("sm_cleaner_decoupled", true);
     options.set_bool_option("sm_archiver_eager", true);
     // options.set_string_option("sm_archdir", "/var/tmp/lucas/btree_test_env/archive");
     // options.set_string_option("sm_logdir", "/var/tmp/lucas/btree_test_env/log");
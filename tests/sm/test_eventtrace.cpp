@@ -0,0 +1,136 @@
+#include "btree_test_env.h"
+#include "sm_base.h"
+#include "bf_tree.h"
+#include "eventtrace.h"
+
+#include <thread>
+
+btree_test_env *test_env;
+
+const char* TRACE_FILE = "test_eventtrace.trace";
+char HUNDRED_BYTES[100];
+
+/**
+ * Unit test for the binary event tracer (event_tracer).
+ */
+
+trace_event_t make_event(PageID pid)
+{
+    trace_event_t e;
+    memset(&e, 0, sizeof(e));
+    e.type = trace_event_t::page_read;
+    e.pid = pid;
+    e.count = 1;
+    return e;
+}
+
+TEST (EventTraceTest, Ring) {
+    trace_ring_t ring(7, 8);
+    std::vector<trace_event_t> out;
+    EXPECT_EQ(0U, ring.drain(out));
+
+    for (PageID i = 0; i < 10; i++) {
+        EXPECT_EQ(i < 8, ring.push(make_event(i)));
+    }
+    EXPECT_EQ(2U, ring.take_dropped());
+    EXPECT_EQ(0U, ring.take_dropped());
+
+    EXPECT_EQ(8U, ring.drain(out));
+    for (PageID i = 0; i < 8; i++) {
+        EXPECT_EQ(i, out[i].pid);
+    }
+
+    // ring wraps around after being drained
+    out.clear();
+    for (PageID i = 100; i < 105; i++) {
+        EXPECT_TRUE(ring.push(make_event(i)));
+    }
+    EXPECT_EQ(5U, ring.drain(out));
+    EXPECT_EQ(100U, out[0].pid);
+    EXPECT_EQ(104U, out[4].pid);
+    EXPECT_EQ(7U, ring.thread());
+}
+
+w_rc_t trace_events(ss_m* ssm, test_volume_t* test_volume)
+{
+    EXPECT_TRUE(smlevel_0::tracer != NULL);
+
+    // generate some page writes with the cleaner
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(test_env->begin_xct());
+    std::stringstream ss("key");
+    for (int i = 0; i < 2000; i++) {
+        ss.seekp(3);
+        ss << i;
+        W_DO(test_env->btree_insert(stid, ss.str().c_str(), HUNDRED_BYTES));
+    }
+    W_DO(test_env->commit_xct());
+    smlevel_0::bf->get_cleaner()->wakeup(true);
+
+    event_tracer::trace(trace_event_t::page_evict, 4242, 1, lsn_t(1, 64));
+
+    // events of an exited thread must not be lost
+    std::thread t([] {
+        for (int i = 0; i < 10; i++) {
+            event_tracer::trace(trace_event_t::page_read, 5000 + i, 3);
+        }
+    });
+    t.join();
+
+    return RCOK;
+}
+
+TEST (EventTraceTest, TraceFile) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_testenv_init_vol", true);
+    options.set_bool_option("sm_logging", true);
+    options.set_string_option("sm_trace_file", TRACE_FILE);
+    options.set_int_option("sm_trace_flush_interval", 10);
+    EXPECT_EQ(test_env->runBtreeTest(trace_events, options), 0);
+    EXPECT_TRUE(smlevel_0::tracer == NULL);
+
+    trace_reader_t reader(TRACE_FILE);
+    EXPECT_GT(reader.header().start_usec, 0U);
+
+    trace_event_t e;
+    size_t writes = 0, reads = 0, evicts = 0;
+    uint32_t evict_thread = 0, read_thread = 0;
+    while (reader.next(e)) {
+        switch (e.type) {
+        case trace_event_t::page_write:
+            writes++;
+            break;
+        case trace_event_t::page_read:
+            if (e.pid >= 5000 && e.pid < 5010) {
+                EXPECT_EQ(3U, e.count);
+                read_thread = e.thread;
+                reads++;
+            }
+            break;
+        case trace_event_t::page_evict:
+            EXPECT_EQ(4242U, e.pid);
+            EXPECT_EQ(lsn_t(1, 64), lsn_t(e.lsn));
+            evict_thread = e.thread;
+            evicts++;
+            break;
+        default:
+            EXPECT_NE(trace_event_t::dropped, e.type);
+        }
+    }
+    EXPECT_GT(writes, 0U);
+    EXPECT_EQ(10U, reads);
+    EXPECT_EQ(1U, evicts);
+    EXPECT_NE(evict_thread, read_thread);
+
+    ::unlink(TRACE_FILE);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
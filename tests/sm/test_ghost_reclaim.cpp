@@ -0,0 +1,135 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btree_page_h.h"
+#include "bf_tree.h"
+#include "bf_tree_cleaner.h"
+#include "ghost_reclaimer.h"
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for the background ghost reclaimer (sm_ghost_reclaim).
+ */
+
+static w_rc_t insert_records(StoreID stid)
+{
+    char key[16];
+    std::string data(100, 'd');
+    W_DO(test_env->begin_xct());
+    for (int i = 0; i < 50; i++) {
+        snprintf(key, sizeof(key), "key%03d", i);
+        W_DO(test_env->btree_insert(stid, key, data.c_str()));
+    }
+    W_DO(test_env->commit_xct());
+    return RCOK;
+}
+
+static w_rc_t remove_records(StoreID stid)
+{
+    char key[16];
+    for (int i = 0; i < 30; i++) {
+        snprintf(key, sizeof(key), "key%03d", i);
+        W_DO(test_env->btree_remove(stid, key));
+    }
+    return RCOK;
+}
+
+static void clean_and_reclaim()
+{
+    smlevel_0::bf->get_cleaner()->wakeup(true);
+    smlevel_0::reclaimer->wakeup(true);
+}
+
+static w_rc_t root_ghosts(StoreID stid, int& ghosts, smsize_t& reclaimable)
+{
+    btree_page_h root_p;
+    W_DO(root_p.fix_root(stid, LATCH_SH));
+    EXPECT_TRUE(root_p.is_leaf());
+    ghosts = root_p.nghosts();
+    reclaimable = root_p.reclaimable_space();
+    return RCOK;
+}
+
+w_rc_t reclaim_committed(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(stid));
+
+    W_DO(test_env->begin_xct());
+    W_DO(remove_records(stid));
+    W_DO(test_env->commit_xct());
+
+    int ghosts;
+    smsize_t reclaimable;
+    W_DO(root_ghosts(stid, ghosts, reclaimable));
+    EXPECT_EQ(30, ghosts);
+    EXPECT_GT(reclaimable, (smsize_t) 0);
+
+    clean_and_reclaim();
+    W_DO(root_ghosts(stid, ghosts, reclaimable));
+    EXPECT_EQ(0, ghosts);
+    EXPECT_EQ((smsize_t) 0, reclaimable);
+    EXPECT_EQ(0U, smlevel_0::reclaimer->get_candidate_count());
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(20, s.rownum);
+    EXPECT_EQ(std::string("key030"), s.minkey);
+    return RCOK;
+}
+
+TEST (GhostReclaimTest, ReclaimCommitted) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_ghost_reclaim", true);
+    options.set_int_option("sm_ghost_reclaim_interval_millisec", 10);
+    EXPECT_EQ(test_env->runBtreeTest(reclaim_committed, options), 0);
+}
+
+w_rc_t keep_active(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+    W_DO(insert_records(stid));
+
+    W_DO(test_env->begin_xct());
+    W_DO(remove_records(stid));
+    xct_t* deleter = xct();
+    ss_m::detach_xct();
+
+    // the deleter may still need its ghosts to roll back
+    clean_and_reclaim();
+    int ghosts;
+    smsize_t reclaimable;
+    W_DO(root_ghosts(stid, ghosts, reclaimable));
+    EXPECT_EQ(30, ghosts);
+    EXPECT_EQ(1U, smlevel_0::reclaimer->get_candidate_count());
+
+    ss_m::attach_xct(deleter);
+    W_DO(test_env->abort_xct());
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ(50, s.rownum);
+    return RCOK;
+}
+
+TEST (GhostReclaimTest, KeepActive) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_ghost_reclaim", true);
+    options.set_int_option("sm_ghost_reclaim_interval_millisec", 10);
+    EXPECT_EQ(test_env->runBtreeTest(keep_active, options), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+#include "sm_base.h"
+#include "smstats.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+/**
+ * Unit test for the latency histograms kept in sm_stats_info_t.
+ */
+
+TEST (LatencyHistTest, Buckets) {
+    // small values are exact
+    for (uint64_t v = 0; v < latency_histogram_t::SUB_BUCKETS; v++) {
+        EXPECT_EQ(v, latency_histogram_t::bucket_of(v));
+        EXPECT_EQ(v, latency_histogram_t::bucket_max(v));
+    }
+
+    // every value falls into a bucket whose range contains it, and the
+    // bucket width is bounded by 1/SUB_BUCKETS of the value
+    uint32_t prev = 0;
+    for (uint64_t v = 1; v < (1ULL << 40); v = v * 3 / 2 + 1) {
+        uint32_t b = latency_histogram_t::bucket_of(v);
+        EXPECT_GE(b, prev);
+        EXPECT_GE(latency_histogram_t::bucket_max(b), v);
+        if (b > 0) {
+            EXPECT_LT(latency_histogram_t::bucket_max(b - 1), v);
+        }
+        EXPECT_LE(latency_histogram_t::bucket_max(b) - v,
+                v / latency_histogram_t::SUB_BUCKETS);
+        prev = b;
+    }
+
+    // huge values are clamped into the last bucket
+    EXPECT_EQ((uint32_t) latency_histogram_t::BUCKETS - 1,
+            latency_histogram_t::bucket_of(~0ULL));
+}
+
+TEST (LatencyHistTest, Percentiles) {
+    sm_stats_info_t stats;
+    latency_histogram_t& h = stats.lat.hist[sm_latency_stats_t::fix_hit];
+    EXPECT_EQ(0U, h.count());
+    EXPECT_EQ(0U, h.percentile(0.99));
+
+    // 1000 values between 1us and 1ms
+    for (uint64_t i = 1; i <= 1000; i++) {
+        h.record(i * 1000);
+    }
+    EXPECT_EQ(1000U, h.count());
+    EXPECT_EQ(1000000U, h.max());
+    EXPECT_EQ(500500U, h.mean());
+
+    uint64_t p50 = h.percentile(0.5);
+    EXPECT_GE(p50, 500000U);
+    EXPECT_LE(p50, 500000U + 500000U / latency_histogram_t::SUB_BUCKETS);
+    uint64_t p99 = h.percentile(0.99);
+    EXPECT_GE(p99, 990000U);
+    EXPECT_LE(p99, 1000000U);
+    EXPECT_EQ(1000000U, h.percentile(1.0));
+}
+
+TEST (LatencyHistTest, Merge) {
+    sm_stats_info_t a, b;
+    for (uint64_t i = 0; i < 100; i++) {
+        a.lat.hist[sm_latency_stats_t::xct_commit].record(100);
+        b.lat.hist[sm_latency_stats_t::xct_commit].record(100000);
+    }
+
+    sm_stats_info_t sum;
+    sum += a;
+    sum += b;
+    const latency_histogram_t& h = sum.lat.hist[sm_latency_stats_t::xct_commit];
+    EXPECT_EQ(200U, h.count());
+    EXPECT_EQ(100000U, h.max());
+    EXPECT_LE(h.percentile(0.5), 100U + 100U / latency_histogram_t::SUB_BUCKETS);
+    EXPECT_GE(h.percentile(0.51), 100000U);
+    EXPECT_EQ(0U, sum.lat.hist[sm_latency_stats_t::fix_miss].count());
+
+    sum -= b;
+    EXPECT_EQ(100U, h.count());
+    EXPECT_LE(h.percentile(0.999), 100U + 100U / latency_histogram_t::SUB_BUCKETS);
+}
+
+TEST (LatencyHistTest, Export) {
+    sm_stats_info_t stats;
+    stats.lat.hist[sm_latency_stats_t::lock_acquire].record(42);
+
+    std::stringstream ss;
+    ss << stats.lat;
+    std::string line;
+    std::getline(ss, line);
+    EXPECT_EQ('#', line[0]);
+
+    int lines = 0;
+    while (std::getline(ss, line)) {
+        std::istringstream ls(line);
+        std::string name;
+        uint64_t count, mean, p50, p90, p99, p999, max;
+        ls >> name >> count >> mean >> p50 >> p90 >> p99 >> p999 >> max;
+        EXPECT_FALSE(ls.fail());
+        EXPECT_EQ(std::string(sm_latency_stats_t::names[lines]), name);
+        if (name == "lock_acquire") {
+            EXPECT_EQ(1U, count);
+            EXPECT_EQ(42U, p999);
+            EXPECT_EQ(42U, max);
+        }
+        else {
+            EXPECT_EQ(0U, count);
+        }
+        lines++;
+    }
+    EXPECT_EQ((int) sm_latency_stats_t::kind_count, lines);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -95,7 +95,8 @@ rc_t generateFakeArchive(LogArchiver::ArchiveDirectory* dir,
     return RCOK;
 }
 
-rc_t emptyHeapAndCheck(LogArchiver::ArchiverHeap& heap)
+template <class H>
+rc_t emptyHeapAndCheck(H& heap)
 {
     logrec_t* lr;
     PageID prevPage = 0;
@@ -200,6 +201,45 @@ rc_t heapTestReal(ss_m* ssm, test_volume_t* test_vol)
     return RCOK;
 }
 
+rc_t heapTestParallel(ss_m* ssm, test_volume_t* test_vol)
+{
+    unsigned howManyToInsert = 1000;
+    W_DO(populateBtree(ssm, test_vol, howManyToInsert));
+
+    lsn_t lastLSN = ssm->log->durable_lsn();
+    lsn_t prevLSN = lsn_t(1,0);
+    LogArchiver::LogConsumer cons(prevLSN, BLOCK_SIZE);
+    cons.open(lastLSN);
+
+    LogArchiver::ParallelArchiverHeap heap(4 * BLOCK_SIZE, 4);
+
+    logrec_t* lr;
+    bool pushed = false;
+    size_t pushedCount = 0;
+    run_number_t run = heap.topRun();
+    while (cons.next(lr)) {
+        pushed = heap.push(lr, false);
+        if (!pushed) {
+            EXPECT_EQ(pushedCount, heap.size());
+            EXPECT_EQ(run, heap.topRun());
+            emptyHeapAndCheck(heap);
+            // every batch is a run of its own
+            EXPECT_EQ(run + 1, heap.topRun());
+            run = heap.topRun();
+            pushedCount = 0;
+            pushed = heap.push(lr, false);
+            EXPECT_TRUE(pushed);
+        }
+        pushedCount++;
+    }
+
+    EXPECT_EQ(pushedCount, heap.size());
+    emptyHeapAndCheck(heap);
+    EXPECT_EQ(0, heap.size());
+
+    return RCOK;
+}
+
 rc_t fullPipelineTest(ss_m* ssm, test_volume_t* test_vol)
 {
     unsigned howManyToInsert = 1000;
@@ -509,6 +549,7 @@ rc_t writerTest(ss_m*, test_volume_t*) {
 
 DEFAULT_TEST (LogArchiverTest, consumerTest);
 DEFAULT_TEST (LogArchiverTest, heapTestReal);
+DEFAULT_TEST (LogArchiverTest, heapTestParallel);
 DEFAULT_TEST (LogArchiverTest, fullPipelineTest);
 DEFAULT_TEST (ArchiveScannerTest, runScannerTest);
 DEFAULT_TEST (ArchiveScannerTest, runScannerWithIndex);
@@ -0,0 +1,264 @@
+#include "w_defines.h"
+#include "w_heap.h"
+#include "w_losertree.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * Unit test and benchmark of LoserTree, which replaced Heap<> in run
+ * generation (ArchiverHeap) and k-way merge (RunMerger) of the log archiver.
+ */
+
+typedef w_packed_key_t pkey_t;
+
+pkey_t make_key(uint32_t run, uint32_t pid, uint64_t lsn)
+{
+    return pkey_t(((uint64_t) run << 32) | pid, lsn);
+}
+
+// Entry and comparison equivalent to those previously used in ArchiverHeap
+struct HeapEntry {
+    char* address;
+    size_t length;
+    uint64_t lsn;
+    int32_t run;
+    uint32_t pid;
+};
+
+struct HeapEntryCmp {
+    bool gt(const HeapEntry& a, const HeapEntry& b) const
+    {
+        if (a.run != b.run) { return a.run < b.run; }
+        if (a.pid != b.pid) { return a.pid < b.pid; }
+        return a.lsn < b.lsn;
+    }
+};
+
+TEST (LoserTreeTest, PushPop) {
+    std::mt19937 rng(42);
+    LoserTree<int> tree;
+    std::vector<pkey_t> reference;
+
+    // random mix of insertions and removals, growing the tree a few times
+    for (int i = 0; i < 20000; i++) {
+        if (reference.empty() || rng() % 3 != 0) {
+            pkey_t k = make_key(rng() % 4, rng() % 1000, rng());
+            tree.push(k, i);
+            reference.push_back(k);
+            std::push_heap(reference.begin(), reference.end(),
+                    [] (const pkey_t& a, const pkey_t& b) { return b < a; });
+        }
+        else {
+            pkey_t expected = reference.front();
+            EXPECT_EQ(expected.hi, tree.top_key().hi);
+            EXPECT_EQ(expected.lo, tree.top_key().lo);
+            std::pop_heap(reference.begin(), reference.end(),
+                    [] (const pkey_t& a, const pkey_t& b) { return b < a; });
+            reference.pop_back();
+            tree.pop();
+        }
+        EXPECT_EQ(reference.size(), tree.size());
+    }
+    EXPECT_GE(tree.capacity(), tree.size());
+
+    pkey_t prev(0, 0);
+    while (!tree.empty()) {
+        EXPECT_FALSE(tree.top_key() < prev);
+        prev = tree.top_key();
+        tree.pop();
+    }
+}
+
+TEST (LoserTreeTest, Merge) {
+    const size_t inputs = 13;
+    std::mt19937 rng(7);
+    std::vector<std::vector<uint64_t>> runs(inputs);
+    std::vector<uint64_t> all;
+    for (size_t i = 0; i < inputs; i++) {
+        runs[i].resize(rng() % 500);
+        for (auto& v : runs[i]) { v = rng() % 100000; }
+        std::sort(runs[i].begin(), runs[i].end());
+        all.insert(all.end(), runs[i].begin(), runs[i].end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::vector<size_t> pos(inputs, 0);
+    LoserTree<size_t> tree(inputs);
+    for (size_t i = 0; i < inputs; i++) {
+        if (!runs[i].empty()) {
+            tree.push(pkey_t(runs[i][0], i), i);
+        }
+    }
+
+    std::vector<uint64_t> merged;
+    while (!tree.empty()) {
+        size_t i = tree.top();
+        merged.push_back(runs[i][pos[i]]);
+        if (++pos[i] < runs[i].size()) {
+            tree.replace_top(pkey_t(runs[i][pos[i]], i));
+        }
+        else {
+            tree.pop();
+        }
+    }
+    EXPECT_EQ(all, merged);
+}
+
+/*
+ * Benchmarks: both structures perform the same sequence of operations, which
+ * mimics the two uses in the log archiver, and the run times are printed.
+ * The results are only compared for correctness, not for speed.
+ */
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(
+            bench_clock::now() - begin).count();
+}
+
+TEST (LoserTreeTest, BenchRunGeneration) {
+    // replacement selection with a workspace of 64K records: pop the
+    // smallest and push a new record, with increasing LSNs
+    const size_t wspace = 65536;
+    const size_t ops = 2000000;
+    std::mt19937 rng(1);
+    std::vector<uint32_t> pids(wspace + ops);
+    for (auto& p : pids) { p = rng() % 100000; }
+
+    uint64_t sumHeap = 0, sumTree = 0;
+
+    bench_clock::time_point begin = bench_clock::now();
+    {
+        HeapEntryCmp cmp;
+        Heap<HeapEntry, HeapEntryCmp> heap(cmp);
+        size_t next = 0;
+        for (; next < wspace; next++) {
+            HeapEntry e = { NULL, 0, next, 1, pids[next] };
+            heap.AddElement(e);
+        }
+        for (size_t i = 0; i < ops; i++, next++) {
+            sumHeap += heap.First().lsn;
+            HeapEntry e = { NULL, 0, next, 2, pids[next] };
+            heap.RemoveFirst();
+            heap.AddElement(e);
+        }
+    }
+    double heapMs = elapsed_ms(begin);
+
+    begin = bench_clock::now();
+    {
+        LoserTree<char*> tree(wspace);
+        size_t next = 0;
+        for (; next < wspace; next++) {
+            tree.push(make_key(1, pids[next], next), NULL);
+        }
+        for (size_t i = 0; i < ops; i++, next++) {
+            sumTree += tree.top_key().lo;
+            tree.pop();
+            tree.push(make_key(2, pids[next], next), NULL);
+        }
+    }
+    double treeMs = elapsed_ms(begin);
+
+    EXPECT_EQ(sumHeap, sumTree);
+    std::cout << "Run generation (" << ops << " records): w_heap "
+        << heapMs << " ms, loser tree " << treeMs << " ms" << std::endl;
+}
+
+TEST (LoserTreeTest, BenchMerge) {
+    // k-way merge of sorted runs of (pid, lsn), replacing the top with the
+    // next record of the same run
+    const size_t k = 64;
+    const size_t perRun = 30000;
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> runs(k);
+    std::mt19937 rng(2);
+    uint64_t lsn = 0;
+    for (auto& r : runs) {
+        r.resize(perRun);
+        for (auto& v : r) { v = std::make_pair(rng() % 100000, lsn++); }
+        std::sort(r.begin(), r.end());
+    }
+
+    uint64_t sumHeap = 0, sumTree = 0;
+
+    // entry and comparison equivalent to those previously used in RunMerger
+    struct MergeEntry {
+        bool active;
+        uint32_t pid;
+        uint64_t lsn;
+        void* lr;
+        size_t run;
+        size_t pos;
+    };
+    struct MergeCmp {
+        bool gt(const MergeEntry& a, const MergeEntry& b) const
+        {
+            if (!a.active) { return false; }
+            if (!b.active) { return true; }
+            if (a.pid != b.pid) { return a.pid < b.pid; }
+            return a.lsn < b.lsn;
+        }
+    };
+
+    bench_clock::time_point begin = bench_clock::now();
+    {
+        MergeCmp cmp;
+        Heap<MergeEntry, MergeCmp> heap(cmp);
+        for (size_t i = 0; i < k; i++) {
+            MergeEntry e = { true, runs[i][0].first, runs[i][0].second,
+                NULL, i, 0 };
+            heap.AddElement(e);
+        }
+        while (heap.First().active) {
+            MergeEntry& top = heap.First();
+            sumHeap += top.lsn;
+            if (++top.pos < perRun) {
+                top.pid = runs[top.run][top.pos].first;
+                top.lsn = runs[top.run][top.pos].second;
+            }
+            else {
+                top.active = false;
+            }
+            heap.ReplacedFirst();
+        }
+    }
+    double heapMs = elapsed_ms(begin);
+
+    begin = bench_clock::now();
+    {
+        std::vector<size_t> pos(k, 0);
+        LoserTree<size_t> tree(k);
+        for (size_t i = 0; i < k; i++) {
+            tree.push(make_key(0, runs[i][0].first, runs[i][0].second), i);
+        }
+        while (!tree.empty()) {
+            size_t i = tree.top();
+            sumTree += tree.top_key().lo;
+            if (++pos[i] < perRun) {
+                tree.replace_top(make_key(0, runs[i][pos[i]].first,
+                            runs[i][pos[i]].second));
+            }
+            else {
+                tree.pop();
+            }
+        }
+    }
+    double treeMs = elapsed_ms(begin);
+
+    EXPECT_EQ(sumHeap, sumTree);
+    std::cout << "Merge (" << k << " runs, " << k * perRun
+        << " records): w_heap " << heapMs << " ms, loser tree "
+        << treeMs << " ms" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 #include "log_core.h"
 #include "logarchiver.h"
 #include "restore.h"
+#include "backup_delta.h"
 #include "vol.h"
 #include "alloc_cache.h"
 #include "sm_options.h"
@@ -191,6 +192,57 @@ rc_t takeBackupTest(ss_m* ssm, test_volume_t* test_volume)
     return RCOK;
 }
 
+rc_t deltaFormatTest(ss_m*, test_volume_t*)
+{
+    // write extents of pages 8-15 and 32-35 (out of order), each page
+    // filled with its own page ID
+    const size_t pageSize = sizeof(generic_page);
+    string path = string(test_env->vol_dir) + "/delta";
+    int fd = -1;
+    int flags = smthread_t::OPEN_RDWR | smthread_t::OPEN_TRUNC
+        | smthread_t::OPEN_CREATE;
+    W_DO(me()->open(path.c_str(), flags, 0666, fd));
+
+    std::vector<char> pages(8 * pageSize);
+    {
+        DeltaBackupWriter writer(fd, lsn_t(1, 100));
+        for (size_t i = 0; i < 4; i++) {
+            memset(&pages[i * pageSize], 32 + i, pageSize);
+        }
+        W_DO(writer.append(32, 4, &pages[0]));
+        for (size_t i = 0; i < 8; i++) {
+            memset(&pages[i * pageSize], 8 + i, pageSize);
+        }
+        W_DO(writer.append(8, 8, &pages[0]));
+        W_DO(writer.finish(lsn_t(2, 200)));
+    }
+    W_DO(me()->close(fd));
+
+    DeltaBackupFile delta(path);
+    W_DO(delta.open(false));
+    EXPECT_EQ(lsn_t(1, 100), delta.getHeader().baseLSN);
+    EXPECT_EQ(lsn_t(2, 200), delta.getHeader().backupLSN);
+    EXPECT_EQ(2, (int) delta.getHeader().extentCount);
+
+    // overlay pages 12-35 on a buffer filled with zeroes: only pages
+    // contained in the delta are overwritten
+    const PageID first = 12, count = 24;
+    std::vector<char> buf(count * pageSize, 0);
+    W_DO(delta.overlay(first, count, &buf[0]));
+    for (PageID p = first; p < first + count; p++) {
+        char expected = (p < 16 || p >= 32) ? (char) p : 0;
+        EXPECT_EQ(expected, buf[(p - first) * pageSize]);
+        EXPECT_EQ(expected, buf[(p - first + 1) * pageSize - 1]);
+    }
+
+    return RCOK;
+}
+
+TEST (BackupTest, deltaFormatTest) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(deltaFormatTest), 0);
+}
+
 #define DEFAULT_TEST(test, function, option_reuse, option_singlepass) \
     TEST (test, function) { \
         test_env->empty_logdata_dir(); \
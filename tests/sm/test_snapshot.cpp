@@ -0,0 +1,167 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "btree.h"
+#include "btcursor.h"
+#include "version_store.h"
+
+#include <string>
+#include <vector>
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for snapshot transactions (ss_m::begin_snapshot_xct).
+ */
+
+static w_rc_t scan(StoreID stid, bool forward, std::string& result)
+{
+    result.clear();
+    bt_cursor_t cursor(stid, forward);
+    do {
+        W_DO(cursor.next());
+        if (cursor.eof()) {
+            break;
+        }
+        result += std::string((const char*)
+                cursor.key().serialize_as_nonkeystr().data(),
+                cursor.key().get_length_as_nonkeystr());
+        result += "=";
+        result += std::string(cursor.elem(), cursor.elen());
+        result += " ";
+    } while (true);
+    return RCOK;
+}
+
+static w_rc_t populate(ss_m* ssm, test_volume_t* test_volume, StoreID& stid)
+{
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+
+    W_DO(test_env->begin_xct());
+    W_DO(test_env->btree_insert(stid, "a1", "v1"));
+    W_DO(test_env->btree_insert(stid, "a2", "v1"));
+    W_DO(test_env->btree_insert(stid, "a3", "v1"));
+    W_DO(test_env->btree_insert(stid, "a4", "v1"));
+    W_DO(test_env->commit_xct());
+    return RCOK;
+}
+
+w_rc_t snapshot_reads(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    W_DO(populate(ssm, test_volume, stid));
+
+    const std::string old_state = "a1=v1 a2=v1 a3=v1 a4=v1 ";
+    const std::string new_state = "a1=v2 a3=v1 a4=v1 a5=v2 ";
+    std::string data, result;
+
+    // active writer
+    W_DO(test_env->begin_xct());
+    W_DO(test_env->btree_update(stid, "a1", "v2"));
+    W_DO(test_env->btree_remove(stid, "a2"));
+    W_DO(test_env->btree_insert(stid, "a5", "v2"));
+    xct_t* writer = xct();
+    ss_m::detach_xct();
+
+    // snapshot taken while the writer is active
+    W_DO(ss_m::begin_snapshot_xct());
+    W_DO(x_btree_lookup(ssm, stid, "a1", data));
+    EXPECT_EQ(std::string("v1"), data);
+    W_DO(x_btree_lookup(ssm, stid, "a2", data));
+    EXPECT_EQ(std::string("v1"), data);
+    W_DO(x_btree_lookup(ssm, stid, "a5", data));
+    EXPECT_TRUE(data.empty());
+    W_DO(scan(stid, true, result));
+    EXPECT_EQ(old_state, result);
+    W_DO(scan(stid, false, result));
+    EXPECT_EQ(std::string("a4=v1 a3=v1 a2=v1 a1=v1 "), result);
+    xct_t* snapshot = xct();
+    ss_m::detach_xct();
+
+    // snapshots cannot update
+    W_DO(ss_m::begin_snapshot_xct());
+    w_rc_t rc = x_btree_insert(ssm, stid, "a9", "v9");
+    EXPECT_EQ(eSNAPSHOTUPDATE, rc.err_num());
+    W_DO(ss_m::commit_xct());
+
+    ss_m::attach_xct(writer);
+    W_DO(ss_m::commit_xct());
+
+    // older snapshot still sees the state before the writer committed
+    ss_m::attach_xct(snapshot);
+    W_DO(scan(stid, true, result));
+    EXPECT_EQ(old_state, result);
+    W_DO(ss_m::commit_xct());
+
+    // new snapshot sees the committed changes
+    W_DO(ss_m::begin_snapshot_xct());
+    W_DO(x_btree_lookup(ssm, stid, "a1", data));
+    EXPECT_EQ(std::string("v2"), data);
+    W_DO(x_btree_lookup(ssm, stid, "a2", data));
+    EXPECT_TRUE(data.empty());
+    W_DO(scan(stid, true, result));
+    EXPECT_EQ(new_state, result);
+    W_DO(ss_m::commit_xct());
+
+    // versions are collected once no snapshot needs them
+    EXPECT_EQ(0U, smlevel_0::versions->get_version_count());
+    return RCOK;
+}
+
+TEST (SnapshotTest, SnapshotReads) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_snapshot_reads", true);
+    EXPECT_EQ(test_env->runBtreeTest(snapshot_reads, options), 0);
+}
+
+w_rc_t aborted_writer(ss_m* ssm, test_volume_t *test_volume) {
+    StoreID stid;
+    W_DO(populate(ssm, test_volume, stid));
+
+    std::string result;
+    W_DO(test_env->begin_xct());
+    W_DO(test_env->btree_update(stid, "a3", "v2"));
+    W_DO(test_env->btree_insert(stid, "a0", "v2"));
+    xct_t* writer = xct();
+    ss_m::detach_xct();
+
+    W_DO(ss_m::begin_snapshot_xct());
+    xct_t* snapshot = xct();
+    ss_m::detach_xct();
+
+    ss_m::attach_xct(writer);
+    W_DO(ss_m::abort_xct());
+    EXPECT_EQ(0U, smlevel_0::versions->get_version_count());
+
+    ss_m::attach_xct(snapshot);
+    W_DO(scan(stid, true, result));
+    EXPECT_EQ(std::string("a1=v1 a2=v1 a3=v1 a4=v1 "), result);
+    W_DO(ss_m::commit_xct());
+    return RCOK;
+}
+
+TEST (SnapshotTest, AbortedWriter) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_snapshot_reads", true);
+    EXPECT_EQ(test_env->runBtreeTest(aborted_writer, options), 0);
+}
+
+w_rc_t not_enabled(ss_m*, test_volume_t*) {
+    w_rc_t rc = ss_m::begin_snapshot_xct();
+    EXPECT_EQ(eNOSNAPSHOTS, rc.err_num());
+    return RCOK;
+}
+
+TEST (SnapshotTest, NotEnabled) {
+    test_env->empty_logdata_dir();
+    EXPECT_EQ(test_env->runBtreeTest(not_enabled), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}
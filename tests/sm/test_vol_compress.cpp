@@ -0,0 +1,137 @@
+#include "btree_test_env.h"
+#include "gtest/gtest.h"
+#include "sm_vas.h"
+#include "sm_base.h"
+#include "vol.h"
+#include "bf_tree.h"
+#include "logarchiver.h"
+
+#include <cstdlib>
+
+btree_test_env *test_env;
+
+/**
+ * Unit test for page compression on the volume (option sm_vol_compress).
+ */
+
+static generic_page* alloc_pages(size_t count)
+{
+    generic_page* buf = NULL;
+    int res = posix_memalign((void**) &buf, LogArchiver::IO_ALIGN,
+            count * sizeof(generic_page));
+    w_assert0(res == 0);
+    memset(buf, 0, count * sizeof(generic_page));
+    return buf;
+}
+
+static void make_page(generic_page* page, PageID pid, bool compressible)
+{
+    memset(page, 0, sizeof(generic_page));
+    page->pid = pid;
+    page->tag = t_btree_p;
+
+    char* data = reinterpret_cast<char*>(page) + sizeof(generic_page_header);
+    size_t len = sizeof(generic_page) - sizeof(generic_page_header);
+    if (compressible) {
+        // text-like keys in the first half, unused space after that
+        for (size_t i = 0; i + 32 < len / 2; i += 32) {
+            snprintf(data + i, 32, "key_%08zu|value_%08zu", i, i * 3);
+        }
+    }
+    else {
+        for (size_t i = 0; i < len; i++) { data[i] = rand(); }
+    }
+    page->checksum = page->calculate_checksum();
+}
+
+w_rc_t write_read(ss_m*, test_volume_t*) {
+    vol_t* vol = smlevel_0::vol;
+    generic_page* pages = alloc_pages(3);
+    generic_page* read = alloc_pages(3);
+    ::srand(123); // fixed seed for repeatability
+
+    // pages past the last allocated one are not used by anyone else
+    PageID first = vol->get_last_allocated_pid() + 1;
+
+    // single compressible page
+    uint64_t compressed = GET_TSTAT(vol_pages_compressed);
+    uint64_t decompressed = GET_TSTAT(vol_pages_decompressed);
+    make_page(&pages[0], first, true);
+    W_DO(vol->write_page(first, pages));
+    EXPECT_EQ(compressed + 1, GET_TSTAT(vol_pages_compressed));
+    W_DO(vol->read_page(first, read));
+    EXPECT_EQ(decompressed + 1, GET_TSTAT(vol_pages_decompressed));
+    EXPECT_EQ(0, memcmp(pages, read, sizeof(generic_page)));
+
+    // single incompressible page overwrites the compressed slot
+    make_page(&pages[0], first, false);
+    W_DO(vol->write_page(first, pages));
+    EXPECT_EQ(compressed + 1, GET_TSTAT(vol_pages_compressed));
+    W_DO(vol->read_page(first, read));
+    EXPECT_EQ(decompressed + 1, GET_TSTAT(vol_pages_decompressed));
+    EXPECT_EQ(0, memcmp(pages, read, sizeof(generic_page)));
+
+    // mixed batch
+    make_page(&pages[0], first, true);
+    make_page(&pages[1], first + 1, false);
+    make_page(&pages[2], first + 2, true);
+    W_DO(vol->write_many_pages(first, pages, 3));
+    EXPECT_EQ(compressed + 3, GET_TSTAT(vol_pages_compressed));
+    W_DO(vol->read_many_pages(first, read, 3));
+    EXPECT_EQ(decompressed + 3, GET_TSTAT(vol_pages_decompressed));
+    EXPECT_EQ(0, memcmp(pages, read, 3 * sizeof(generic_page)));
+
+    free(pages);
+    free(read);
+    return RCOK;
+}
+
+TEST (VolCompressTest, WriteRead) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_vol_compress", true);
+    EXPECT_EQ(test_env->runBtreeTest(write_read, options), 0);
+}
+
+w_rc_t btree_cleaner(ss_m* ssm, test_volume_t* test_volume) {
+    StoreID stid;
+    PageID root_pid;
+    W_DO(x_btree_create_index(ssm, test_volume, stid, root_pid));
+
+    W_DO(test_env->begin_xct());
+    char key[16];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        W_DO(test_env->btree_insert(stid, key, "data"));
+    }
+    W_DO(test_env->commit_xct());
+
+    // write out compressed pages and read the root back from the volume
+    smlevel_0::bf->get_cleaner()->wakeup(true);
+
+    generic_page* read = alloc_pages(1);
+    W_DO(smlevel_0::vol->read_page(root_pid, read));
+    EXPECT_EQ(root_pid, read->pid);
+    EXPECT_EQ(read->checksum, read->calculate_checksum());
+    free(read);
+
+    W_DO(x_btree_verify(ssm, stid));
+    x_btree_scan_result s;
+    W_DO(test_env->btree_scan(stid, s));
+    EXPECT_EQ (2000, s.rownum);
+    return RCOK;
+}
+
+TEST (VolCompressTest, BtreeCleaner) {
+    test_env->empty_logdata_dir();
+    sm_options options;
+    options.set_bool_option("sm_vol_compress", true);
+    EXPECT_EQ(test_env->runBtreeTest(btree_cleaner, options), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    test_env = new btree_test_env();
+    ::testing::AddGlobalTestEnvironment(test_env);
+    return RUN_ALL_TESTS();
+}